@@ -0,0 +1,557 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBDocumentArchiveExtractor.h"
+
+#include "globals/UBGlobals.h"
+
+#include "core/UBApplication.h"
+#include "core/UBSettings.h"
+#include "core/UBPersistenceManager.h"
+#include "core/UBMediaStore.h"
+
+#include "frameworks/UBFileSystemUtils.h"
+
+THIRD_PARTY_WARNINGS_DISABLE
+#include "quazip.h"
+#include "quazipfile.h"
+THIRD_PARTY_WARNINGS_ENABLE
+
+#include "core/memcheck.h"
+
+UBDocumentArchiveExtractor* UBDocumentArchiveExtractor::sExtractor = 0;
+
+// first line is the archive path, the others the entries still to extract
+static const char* pendingMarkerName = "extraction.pending";
+static const char* archiveCopyName = "extraction.archive";
+
+
+class UBDocumentArchiveExtraction : public QRunnable
+{
+    public:
+        UBDocumentArchiveExtraction(UBDocumentArchiveExtractor* extractor, const QString& documentPath)
+            : mExtractor(extractor)
+            , mDocumentPath(documentPath)
+        {
+            // NOOP
+        }
+
+        virtual void run()
+        {
+            QString targetPath;
+            UBDocumentArchiveExtractor::PendingEntry entry;
+
+            while (mExtractor->takeNextPendingTarget(mDocumentPath, targetPath, entry))
+            {
+                // the document may have been deleted in the meantime
+                bool success = !QDir(UBDocumentArchiveExtractor::documentPathOf(targetPath, entry)).exists()
+                        || UBDocumentArchiveExtractor::extractEntry(entry.archivePath, entry.entryName, targetPath);
+
+                mExtractor->targetExtracted(targetPath, entry, success);
+            }
+        }
+
+    private:
+        UBDocumentArchiveExtractor* mExtractor;
+        QString mDocumentPath;
+};
+
+
+UBDocumentArchiveExtractor* UBDocumentArchiveExtractor::extractor()
+{
+    if (!sExtractor)
+        sExtractor = new UBDocumentArchiveExtractor();
+
+    return sExtractor;
+}
+
+
+void UBDocumentArchiveExtractor::destroy()
+{
+    delete sExtractor;
+    sExtractor = 0;
+}
+
+
+UBDocumentArchiveExtractor::UBDocumentArchiveExtractor()
+    : QObject(0)
+{
+    // reading a big archive from several threads at once only makes the disk seek
+    mPool.setMaxThreadCount(1);
+}
+
+
+UBDocumentArchiveExtractor::~UBDocumentArchiveExtractor()
+{
+    // imported documents must be complete on the next start
+    mPool.waitForDone();
+}
+
+
+void UBDocumentArchiveExtractor::extractLater(const QString& archivePath, const QString& documentPath, const QStringList& entryNames)
+{
+    // a marker may come from the archive itself
+    removeMarker(documentPath);
+
+    if (entryNames.isEmpty())
+        return;
+
+    // the imported file may be deleted or sit on a removable disk, the document extracts from its own copy
+    QString archiveCopyPath = documentPath + "/" + archiveCopyName;
+
+    if (!UBFileSystemUtils::cloneFile(archivePath, archiveCopyPath) || !writeMarker(documentPath, archiveCopyPath, entryNames))
+    {
+        // without the copy and the marker an interrupted extraction would leave the document incomplete for good
+        removeMarker(documentPath);
+
+        foreach (const QString& entryName, entryNames)
+        {
+            if (!extractEntry(archivePath, entryName, documentPath + "/" + entryName))
+                extractionFailed(entryName);
+        }
+
+        return;
+    }
+
+    queueEntries(archiveCopyPath, documentPath, entryNames);
+}
+
+
+void UBDocumentArchiveExtractor::resumePendingExtractions()
+{
+    QString repositoryPath = UBSettings::userDocumentDirectory();
+
+    // built like the persistence paths of the documents, pending entries are looked up by prefix
+    foreach (const QString& documentDir, QDir(repositoryPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        QString documentPath = repositoryPath + "/" + documentDir;
+        QFile marker(markerPath(documentPath));
+
+        if (!marker.exists())
+            continue;
+
+        if (!marker.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            qWarning() << "cannot read" << marker.fileName() << marker.errorString();
+            continue;
+        }
+
+        QStringList lines = QString::fromUtf8(marker.readAll()).split("\n", QString::SkipEmptyParts);
+        marker.close();
+
+        QString archivePath = lines.isEmpty() ? QString() : lines.takeFirst();
+        QStringList missingEntries;
+
+        // extracted files are renamed in place once complete, an existing target is done
+        foreach (const QString& entryName, lines)
+        {
+            if (!QFileInfo(documentPath + "/" + entryName).exists())
+                missingEntries << entryName;
+        }
+
+        if (missingEntries.isEmpty())
+        {
+            removeMarker(documentPath);
+        }
+        else if (archivePath.isEmpty() || !QFileInfo(archivePath).exists())
+        {
+            qWarning() << "archive" << archivePath << "of" << documentPath << "is gone," << missingEntries.size() << "media files stay missing";
+
+            foreach (const QString& entryName, missingEntries)
+                extractionFailed(entryName);
+
+            removeMarker(documentPath);
+        }
+        else
+        {
+            queueEntries(archivePath, documentPath, missingEntries);
+        }
+    }
+}
+
+
+QString UBDocumentArchiveExtractor::markerPath(const QString& documentPath)
+{
+    return documentPath + "/" + pendingMarkerName;
+}
+
+
+QString UBDocumentArchiveExtractor::documentPathOf(const QString& targetPath, const PendingEntry& entry)
+{
+    return targetPath.left(targetPath.length() - entry.entryName.length() - 1);
+}
+
+
+void UBDocumentArchiveExtractor::removeMarker(const QString& documentPath)
+{
+    QFile::remove(markerPath(documentPath));
+    QFile::remove(documentPath + "/" + archiveCopyName);
+}
+
+
+bool UBDocumentArchiveExtractor::writeMarker(const QString& documentPath, const QString& archivePath, const QStringList& entryNames)
+{
+    QSaveFile marker(markerPath(documentPath));
+
+    if (!marker.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "cannot write" << marker.fileName() << marker.errorString();
+        return false;
+    }
+
+    marker.write(archivePath.toUtf8() + "\n");
+    marker.write(entryNames.join("\n").toUtf8() + "\n");
+
+    return marker.commit();
+}
+
+
+void UBDocumentArchiveExtractor::queueEntries(const QString& archivePath, const QString& documentPath, const QStringList& entryNames)
+{
+    {
+        QMutexLocker locker(&mMutex);
+
+        foreach (const QString& entryName, entryNames)
+        {
+            PendingEntry entry;
+            entry.archivePath = archivePath;
+            entry.entryName = entryName;
+
+            mPendingEntries.insert(documentPath + "/" + entryName, entry);
+        }
+    }
+
+    mPool.start(new UBDocumentArchiveExtraction(this, documentPath));
+}
+
+
+bool UBDocumentArchiveExtractor::hasPendingEntries(const QString& documentPath)
+{
+    return !pendingTargets(documentPath).isEmpty();
+}
+
+
+void UBDocumentArchiveExtractor::extractReferencedEntries(const QString& documentPath, const QByteArray& sceneText)
+{
+    // media files are named after the uuid of their item, finding the name in the page is enough
+    foreach (const QString& targetPath, pendingTargets(documentPath))
+    {
+        if (sceneText.contains(QFileInfo(targetPath).fileName().toUtf8()))
+            extractTarget(targetPath);
+    }
+
+    // the scenes showing the page already get the media the worker extracted while waiting
+    if (QThread::currentThread() == thread())
+        announceExtractedTargets();
+}
+
+
+bool UBDocumentArchiveExtractor::prioritizeReferencedEntries(const QString& documentPath, const QByteArray& sceneText)
+{
+    QString objectPrefix = documentPath + "/" + UBPersistenceManager::objectDirectory + "/";
+    bool mediaPending = false;
+
+    foreach (const QString& targetPath, pendingTargets(documentPath))
+    {
+        if (!sceneText.contains(QFileInfo(targetPath).fileName().toUtf8()))
+            continue;
+
+        // the pdf backgrounds give the page its size, they cannot show up later
+        if (targetPath.startsWith(objectPrefix))
+        {
+            extractTarget(targetPath);
+        }
+        else
+        {
+            QMutexLocker locker(&mMutex);
+            mUrgentTargets.insert(targetPath);
+            mediaPending = true;
+        }
+    }
+
+    return mediaPending;
+}
+
+
+void UBDocumentArchiveExtractor::extractAllEntries(const QString& documentPath)
+{
+    foreach (const QString& targetPath, pendingTargets(documentPath))
+        extractTarget(targetPath);
+
+    if (QThread::currentThread() == thread())
+        announceExtractedTargets();
+}
+
+
+void UBDocumentArchiveExtractor::forgetDocument(const QString& documentPath)
+{
+    QMutexLocker locker(&mMutex);
+
+    QString prefix = documentPath + "/";
+    QMap<QString, PendingEntry>::iterator it = mPendingEntries.lowerBound(prefix);
+
+    while (it != mPendingEntries.end() && it.key().startsWith(prefix))
+        it = mPendingEntries.erase(it);
+
+    foreach (const QString& targetPath, mUrgentTargets)
+    {
+        if (targetPath.startsWith(prefix))
+            mUrgentTargets.remove(targetPath);
+    }
+
+    bool extracting = true;
+
+    while (extracting)
+    {
+        extracting = false;
+
+        foreach (const QString& targetPath, mExtractingTargets)
+            extracting = extracting || targetPath.startsWith(prefix);
+
+        if (extracting)
+            mTargetExtracted.wait(&mMutex);
+    }
+}
+
+
+QStringList UBDocumentArchiveExtractor::pendingTargets(const QString& documentPath)
+{
+    QMutexLocker locker(&mMutex);
+
+    QStringList targets;
+    QString prefix = documentPath + "/";
+
+    QMap<QString, PendingEntry>::const_iterator it = mPendingEntries.lowerBound(prefix);
+    for (; it != mPendingEntries.constEnd() && it.key().startsWith(prefix); ++it)
+        targets << it.key();
+
+    foreach (const QString& targetPath, mExtractingTargets)
+    {
+        if (targetPath.startsWith(prefix))
+            targets << targetPath;
+    }
+
+    return targets;
+}
+
+
+bool UBDocumentArchiveExtractor::takeNextPendingTarget(const QString& documentPath, QString& targetPath, PendingEntry& entry)
+{
+    QMutexLocker locker(&mMutex);
+
+    QString prefix = documentPath + "/";
+    QMap<QString, PendingEntry>::iterator it = mPendingEntries.end();
+
+    // the media of the pages on screen come first, whatever document they belong to
+    foreach (const QString& urgentPath, mUrgentTargets)
+    {
+        it = mPendingEntries.find(urgentPath);
+
+        if (it != mPendingEntries.end())
+            break;
+    }
+
+    if (it == mPendingEntries.end())
+    {
+        it = mPendingEntries.lowerBound(prefix);
+
+        if (it == mPendingEntries.end() || !it.key().startsWith(prefix))
+            return false;
+    }
+
+    targetPath = it.key();
+    entry = it.value();
+
+    mPendingEntries.erase(it);
+    mExtractingTargets.insert(targetPath);
+
+    return true;
+}
+
+
+void UBDocumentArchiveExtractor::extractTarget(const QString& targetPath)
+{
+    PendingEntry entry;
+    {
+        QMutexLocker locker(&mMutex);
+
+        if (!mPendingEntries.contains(targetPath))
+        {
+            // the worker is on it, or it is done already
+            while (mExtractingTargets.contains(targetPath))
+                mTargetExtracted.wait(&mMutex);
+
+            return;
+        }
+
+        entry = mPendingEntries.take(targetPath);
+        mExtractingTargets.insert(targetPath);
+    }
+
+    bool success = extractEntry(entry.archivePath, entry.entryName, targetPath);
+
+    targetExtracted(targetPath, entry, success);
+}
+
+
+void UBDocumentArchiveExtractor::targetExtracted(const QString& targetPath, const PendingEntry& entry, bool success)
+{
+    if (!success)
+        extractionFailed(entry.entryName);
+    else
+        QMetaObject::invokeMethod(this, "announceExtractedTargets", Qt::QueuedConnection);
+
+    QMutexLocker locker(&mMutex);
+
+    mExtractingTargets.remove(targetPath);
+    mUrgentTargets.remove(targetPath);
+    mTargetExtracted.wakeAll();
+
+    if (success)
+        mExtractedTargets << targetPath;
+
+    QString documentPath = documentPathOf(targetPath, entry);
+    QString prefix = documentPath + "/";
+
+    QMap<QString, PendingEntry>::const_iterator it = mPendingEntries.lowerBound(prefix);
+    bool done = it == mPendingEntries.constEnd() || !it.key().startsWith(prefix);
+
+    foreach (const QString& extractingPath, mExtractingTargets)
+        done = done && !extractingPath.startsWith(prefix);
+
+    // failed entries are reported now, retrying them on the next start would fail the same way
+    if (done)
+        removeMarker(documentPath);
+}
+
+
+void UBDocumentArchiveExtractor::extractionFailed(const QString& description)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mFailures << description;
+    }
+
+    QMetaObject::invokeMethod(this, "reportFailures", Qt::QueuedConnection);
+}
+
+
+void UBDocumentArchiveExtractor::reportFailures()
+{
+    QStringList failures;
+    {
+        QMutexLocker locker(&mMutex);
+        failures = mFailures;
+        mFailures.clear();
+    }
+
+    if (failures.isEmpty())
+        return;
+
+    qWarning() << "media of imported documents could not be extracted:" << failures;
+
+    UBApplication::showMessage(tr("%n media file(s) of an imported document could not be extracted, the archive may have been moved or damaged.", "", failures.size()));
+}
+
+
+void UBDocumentArchiveExtractor::announceExtractedTargets()
+{
+    QStringList targets;
+    {
+        QMutexLocker locker(&mMutex);
+        targets = mExtractedTargets;
+        mExtractedTargets.clear();
+    }
+
+    foreach (const QString& targetPath, targets)
+    {
+        UBMediaStore::storeLater(targetPath);
+        emit entryExtracted(targetPath);
+    }
+}
+
+
+bool UBDocumentArchiveExtractor::extractEntry(const QString& archivePath, const QString& entryName, const QString& targetPath)
+{
+    QuaZip zip(archivePath);
+    zip.setFileNameCodec("UTF-8");
+
+    if (!zip.open(QuaZip::mdUnzip) || !zip.setCurrentFile(entryName))
+    {
+        qWarning() << "cannot extract" << entryName << "from" << archivePath << ":" << zip.getZipError();
+        return false;
+    }
+
+    QuaZipFile file(&zip);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "cannot extract" << entryName << "from" << archivePath << ":" << file.getZipError();
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(targetPath).absolutePath());
+
+    // written aside and renamed, nobody ever reads a partial file
+    QString partPath = targetPath + ".part";
+    QFile out(partPath);
+
+    if (!out.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "cannot write" << partPath << out.errorString();
+        return false;
+    }
+
+    bool success = true;
+
+    while (!file.atEnd() && success)
+    {
+        QByteArray buffer = file.read(1024 * 1024);
+        success = file.getZipError() == UNZ_OK && !buffer.isEmpty() && out.write(buffer) == buffer.size();
+    }
+
+    out.close();
+    file.close();
+
+    success = success && file.getZipError() == UNZ_OK;
+
+    if (success)
+    {
+        QFile::remove(targetPath);
+        success = out.rename(targetPath);
+    }
+
+    if (!success)
+    {
+        qWarning() << "cannot extract" << entryName << "from" << archivePath << "to" << targetPath;
+        QFile::remove(partPath);
+        return false;
+    }
+
+    return true;
+}
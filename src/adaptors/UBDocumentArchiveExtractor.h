@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBDOCUMENTARCHIVEEXTRACTOR_H_
+#define UBDOCUMENTARCHIVEEXTRACTOR_H_
+
+#include <QtCore>
+#include <QThreadPool>
+
+/*
+ * Media entries of an imported ubz are extracted after the document shows up, one after the
+ * other on a worker thread, from a copy of the archive kept in the document until the last one
+ * is done. A page shown on the board moves the media it references to the front of the queue
+ * and gets them through entryExtracted(), code rendering or copying pages first extracts
+ * what they reference in the calling thread.
+ * The pending entries are also listed in a marker file of the document, so that an extraction
+ * interrupted by quitting resumes on the next start.
+ */
+class UBDocumentArchiveExtractor : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static UBDocumentArchiveExtractor* extractor();
+        static void destroy();
+
+        // entryNames are relative to the archive root, they get extracted under documentPath
+        void extractLater(const QString& archivePath, const QString& documentPath, const QStringList& entryNames);
+
+        void extractReferencedEntries(const QString& documentPath, const QByteArray& sceneText);
+
+        // extracts the page geometry right away, returns true if other referenced media are still pending
+        bool prioritizeReferencedEntries(const QString& documentPath, const QByteArray& sceneText);
+
+        void extractAllEntries(const QString& documentPath);
+        void forgetDocument(const QString& documentPath);
+
+        // called once at startup, before any document page gets loaded
+        void resumePendingExtractions();
+
+        bool hasPendingEntries(const QString& documentPath);
+
+        static bool extractEntry(const QString& archivePath, const QString& entryName, const QString& targetPath);
+
+    signals:
+        // always emitted in the thread of the extractor
+        void entryExtracted(const QString& targetPath);
+
+    private slots:
+        void reportFailures();
+        void announceExtractedTargets();
+
+    private:
+        UBDocumentArchiveExtractor();
+        virtual ~UBDocumentArchiveExtractor();
+
+        friend class UBDocumentArchiveExtraction;
+
+        struct PendingEntry
+        {
+            QString archivePath;
+            QString entryName;
+        };
+
+        static QString documentPathOf(const QString& targetPath, const PendingEntry& entry);
+        static QString markerPath(const QString& documentPath);
+        static void removeMarker(const QString& documentPath);
+        static bool writeMarker(const QString& documentPath, const QString& archivePath, const QStringList& entryNames);
+
+        void queueEntries(const QString& archivePath, const QString& documentPath, const QStringList& entryNames);
+        QStringList pendingTargets(const QString& documentPath);
+        bool takeNextPendingTarget(const QString& documentPath, QString& targetPath, PendingEntry& entry);
+        void extractTarget(const QString& targetPath);
+        void targetExtracted(const QString& targetPath, const PendingEntry& entry, bool success);
+        void extractionFailed(const QString& description);
+
+        static UBDocumentArchiveExtractor* sExtractor;
+
+        QThreadPool mPool;
+        QMutex mMutex;
+        QWaitCondition mTargetExtracted;
+        QMap<QString, PendingEntry> mPendingEntries;
+        QSet<QString> mExtractingTargets;
+        QSet<QString> mUrgentTargets;
+        QStringList mExtractedTargets;
+        QStringList mFailures;
+};
+
+#endif /* UBDOCUMENTARCHIVEEXTRACTOR_H_ */
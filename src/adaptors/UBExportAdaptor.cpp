@@ -28,6 +28,7 @@
 #include <QFileDialog>
 
 #include "UBExportAdaptor.h"
+#include "UBExportQueue.h"
 
 #include "document/UBDocumentProxy.h"
 
@@ -37,6 +38,8 @@
 #include "core/UBSetting.h"
 #include "core/UBApplication.h"
 
+#include "board/UBBoardController.h"
+
 #include "gui/UBMainWindow.h"
 #include "gui/UBMessagesDialog.h"
 
@@ -45,6 +48,7 @@
 UBExportAdaptor::UBExportAdaptor(QObject *parent)
     : QObject(parent)
     , mIsVerbose(true)
+    , mProgressListener(0)
 {
     // NOOP
 }
@@ -127,11 +131,6 @@ void UBExportAdaptor::persistLocally(UBDocumentProxy* pDocumentProxy, const QStr
     QString filename = askForFileName(pDocumentProxy, pDialogTitle);
 
     if (filename.length() > 0) {
-        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-        if (mIsVerbose)
-            UBApplication::showMessage(tr("Exporting document..."));
-
         // Check that the location is writeable
         QFileInfo info(filename);
         info.setFile(info.absolutePath());
@@ -146,18 +145,40 @@ void UBExportAdaptor::persistLocally(UBDocumentProxy* pDocumentProxy, const QStr
             if (mIsVerbose)
                 UBApplication::showMessage(tr("Export failed: location not writable"));
 
-            QApplication::restoreOverrideCursor();
-
             return;
         }
 
-        bool persisted = this->persistsDocument(pDocumentProxy, filename);
+        persistInQueue(pDocumentProxy, filename);
+    }
+}
 
-        if (mIsVerbose && persisted)
-            UBApplication::showMessage(tr("Export successful."));
+void UBExportAdaptor::persistInQueue(UBDocumentProxy* pDocumentProxy, const QString& filename)
+{
+    // exports work from the persisted pages
+    if (UBApplication::boardController && UBApplication::boardController->selectedDocument() == pDocumentProxy)
+        UBApplication::boardController->persistCurrentScene(false, true);
 
-        QApplication::restoreOverrideCursor();
-    }
+    if (mIsVerbose)
+        UBApplication::showMessage(tr("Exporting document..."));
+
+    UBExportQueue::queue()->enqueue(this, pDocumentProxy, filename);
+}
+
+bool UBExportAdaptor::exportProgress(const QString& pObjectName, int pCurrent, int pTotal)
+{
+    if (!mProgressListener)
+        return true;
+
+    mProgressListener->processing(pObjectName, pCurrent, pTotal);
+
+    return !mProgressListener->isCancelled();
+}
+
+void UBExportAdaptor::exportFinished(UBDocumentProxy* pDocument, const QString& filename, bool success)
+{
+    Q_UNUSED(pDocument);
+    Q_UNUSED(filename);
+    Q_UNUSED(success);
 }
 
 bool UBExportAdaptor::persistsDocument(UBDocumentProxy* pDocument, const QString& filename)
@@ -169,6 +190,15 @@ bool UBExportAdaptor::persistsDocument(UBDocumentProxy* pDocument, const QString
     return false;
 }
 
+bool UBExportAdaptor::persistsDocumentFiles(const QString& persistencePath, const QString& filename)
+{
+    // Implemented in child classes running in background
+
+    Q_UNUSED(persistencePath);
+    Q_UNUSED(filename);
+    return false;
+}
+
 void UBExportAdaptor::showErrorsList(QList<QString> errorsList)
 {
     if (errorsList.count())
@@ -33,6 +33,7 @@
 #include <QtGui>
 
 class UBDocumentProxy;
+class UBProcessingProgressListener;
 
 class UBExportAdaptor : public QObject
 {
@@ -47,6 +48,23 @@ class UBExportAdaptor : public QObject
         virtual void persist(UBDocumentProxy* pDocument) = 0;
         virtual bool persistsDocument(UBDocumentProxy* pDocument, const QString& filename);
 
+        // true when the adaptor only reads the persisted document files and may run on a worker thread,
+        // it then exports through persistsDocumentFiles, the proxy may be deleted by the GUI meanwhile
+        virtual bool persistsInBackground() const
+        {
+            return false;
+        }
+
+        virtual bool persistsDocumentFiles(const QString& persistencePath, const QString& filename);
+
+        // called in the GUI thread once an export queued by persistLocally is done
+        virtual void exportFinished(UBDocumentProxy* pDocument, const QString& filename, bool success);
+
+        void setProgressListener(UBProcessingProgressListener* listener)
+        {
+            mProgressListener = listener;
+        }
+
         virtual void setVerbose(bool verbose)
         {
             mIsVerbose = verbose;
@@ -62,10 +80,15 @@ class UBExportAdaptor : public QObject
         QString askForDirName(UBDocumentProxy* pDocument, const QString& pDialogTitle);
 
         virtual void persistLocally(UBDocumentProxy* pDocumentProxy, const QString &pDialogTitle);
+        void persistInQueue(UBDocumentProxy* pDocumentProxy, const QString& filename);
+
+        // reports progress to the export queue, returns false once the export got cancelled
+        bool exportProgress(const QString& pObjectName, int pCurrent, int pTotal);
 
         void showErrorsList(QList<QString> errorsList);
 
         bool mIsVerbose;
+        UBProcessingProgressListener* mProgressListener;
 
 };
 
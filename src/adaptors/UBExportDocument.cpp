@@ -28,6 +28,7 @@
 
 
 #include "UBExportDocument.h"
+#include "UBDocumentArchiveExtractor.h"
 
 #include "frameworks/UBPlatformUtils.h"
 
@@ -63,6 +64,12 @@ void UBExportDocument::persist(UBDocumentProxy* pDocumentProxy)
 
 
 bool UBExportDocument::persistsDocument(UBDocumentProxy* pDocumentProxy, const QString &filename)
+{
+    return persistsDocumentFiles(pDocumentProxy->persistencePath(), filename);
+}
+
+
+bool UBExportDocument::persistsDocumentFiles(const QString& persistencePath, const QString &filename)
 {
     QuaZip zip(filename);
     zip.setFileNameCodec("UTF-8");
@@ -72,13 +79,22 @@ bool UBExportDocument::persistsDocument(UBDocumentProxy* pDocumentProxy, const Q
         return false;
     }
 
-    QDir documentDir = QDir(pDocumentProxy->persistencePath());
+    QDir documentDir = QDir(persistencePath);
+
+    UBDocumentArchiveExtractor::extractor()->extractAllEntries(documentDir.path());
 
     QuaZipFile outFile(&zip);
-    UBFileSystemUtils::compressDirInZip(documentDir, "", &outFile, true, this);
+    bool compressed = UBFileSystemUtils::compressDirInZip(documentDir, "", &outFile, true, this);
 
     zip.close();
 
+    if (!compressed)
+    {
+        qWarning() << "Export failed or cancelled while compressing" << documentDir.path();
+        QFile::remove(filename);
+        return false;
+    }
+
     if(zip.getZipError() != 0)
     {
         qWarning("Export failed. Cause: zip.close(): %d", zip.getZipError());
@@ -94,10 +110,21 @@ bool UBExportDocument::persistsDocument(UBDocumentProxy* pDocumentProxy, const Q
 
 void UBExportDocument::processing(const QString& pObjectName, int pCurrent, int pTotal)
 {
-    QString localized = UBExportDocument::trUtf8(pObjectName.toUtf8());
+    // may be called from the export queue worker thread, the queue shows the progress
+    exportProgress(pObjectName, pCurrent, pTotal);
+}
+
+
+void UBExportDocument::bytesProcessed(qint64 pBytes, qint64 pElapsedMSecs)
+{
+    if (mProgressListener)
+        mProgressListener->bytesProcessed(pBytes, pElapsedMSecs);
+}
 
-    if (mIsVerbose)
-        UBApplication::showMessage(tr("Exporting %1 %2 of %3").arg(localized).arg(pCurrent).arg(pTotal));
+
+bool UBExportDocument::isCancelled() const
+{
+    return mProgressListener && mProgressListener->isCancelled();
 }
 
 
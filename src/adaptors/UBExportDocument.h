@@ -52,8 +52,15 @@ class UBExportDocument : public UBExportAdaptor, public UBProcessingProgressList
         virtual void persist(UBDocumentProxy* pDocument);
 
         virtual bool persistsDocument(UBDocumentProxy* pDocument, const QString& filename);
+        virtual bool persistsDocumentFiles(const QString& persistencePath, const QString& filename);
+        virtual bool persistsInBackground() const
+        {
+            return true;
+        }
 
         virtual void processing(const QString& pObjectName, int pCurrent, int pTotal);
+        virtual void bytesProcessed(qint64 pBytes, qint64 pElapsedMSecs);
+        virtual bool isCancelled() const;
 };
 
 #endif /* UBEXPORTDOCUMENT_H_ */
@@ -44,9 +44,13 @@
 
 #include "document/UBDocumentProxy.h"
 
+#include "frameworks/UBDecodingQueue.h"
+#include "frameworks/UBExportImageCache.h"
+
 #include "pdf/GraphicsPDFItem.h"
 
 #include "UBExportPDF.h"
+#include "UBExportSceneLoader.h"
 
 #include <Merger.h>
 #include <Exception.h>
@@ -67,6 +71,8 @@ UBExportFullPDF::UBExportFullPDF(QObject *parent)
     mScaleFactor = 72.0f / dpiCommon; // 1pt = 1/72 inch
 
     mSimpleExporter = new UBExportPDF();
+
+    UBExportFullPDF::tr("Page"); // dummy slot for translation
 }
 
 
@@ -76,10 +82,10 @@ UBExportFullPDF::~UBExportFullPDF()
 }
 
 
-void UBExportFullPDF::saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QString& filename)
+bool UBExportFullPDF::saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QString& filename)
 {
     if (!pDocumentProxy || filename.length() == 0 || pDocumentProxy->pageCount() == 0)
-        return;
+        return true;
 
     //PDF
     qDebug() << "exporting document to PDF Merger" << filename;
@@ -92,9 +98,27 @@ void UBExportFullPDF::saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QStr
 
     QPainter* pdfPainter = 0;
 
-    for(int pageIndex = 0 ; pageIndex < pDocumentProxy->pageCount(); pageIndex++)
+    // pages are read ahead on worker threads and kept out of the scene cache
+    UBExportSceneLoader sceneLoader(pDocumentProxy);
+
+    // images repeated over pages are embedded once
+    UBExportImageCache imageCache(UBSettings::settings()->pdfImageResolution->get().toInt());
+
+    bool completed = true;
+    int existingPageCount = pDocumentProxy->pageCount();
+
+    for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++)
     {
-        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
+        if (!exportProgress("Page", pageIndex + 1, existingPageCount))
+        {
+            completed = false;
+            break;
+        }
+
+        UBGraphicsScene* scene = sceneLoader.scene(pageIndex);
+        if (!scene)
+            continue;
+
         // set background to white, no grid for PDF output
         bool isDark = scene->isDarkBackground();
         bool isCrossed = scene->isCrossedBackground();
@@ -103,33 +127,57 @@ void UBExportFullPDF::saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QStr
         // set high res rendering
         scene->setRenderingQuality(UBItem::RenderingQualityHigh);
         scene->setRenderingContext(UBGraphicsScene::PdfExport);
+        scene->setExportImageCache(&imageCache);
 
         QSize pageSize = scene->nominalSize();
 
         UBGraphicsPDFItem *pdfItem = qgraphicsitem_cast<UBGraphicsPDFItem*>(scene->backgroundObject());
 
-        if (pdfItem) mHasPDFBackgrounds = true;
-        
         pdfPrinter.setPaperSize(QSizeF(pageSize.width()*mScaleFactor, pageSize.height()*mScaleFactor), QPrinter::Point);
 
         if (!pdfPainter) pdfPainter = new QPainter(&pdfPrinter);
 
-        if (pageIndex != 0) pdfPrinter.newPage();
+        if (!mOverlayPages.isEmpty()) pdfPrinter.newPage();
 
         //render to PDF
         scene->setDrawingMode(true);
+        UBDecodingQueue::queue()->waitForPendingDecodes(scene);
         scene->render(pdfPainter, QRectF(), scene->normalizedSceneRect());
 
         //restore screen rendering quality
         scene->setRenderingContext(UBGraphicsScene::Screen);
+        scene->setExportImageCache(0);
         scene->setRenderingQuality(UBItem::RenderingQualityNormal);
 
         //restore background state
         scene->setDrawingMode(false);
         scene->setBackground(isDark, isCrossed);
+
+        OverlayPage overlayPage;
+        overlayPage.pageSize = pageSize;
+        overlayPage.hasPdfBackground = (pdfItem != 0);
+        overlayPage.pdfPageNumber = 0;
+        overlayPage.pdfScale = 1;
+
+        if (pdfItem)
+        {
+            mHasPDFBackgrounds = true;
+
+            overlayPage.pdfFileUuid = pdfItem->fileUuid();
+            overlayPage.pdfPageNumber = pdfItem->pageNumber();
+            overlayPage.pdfSceneRect = pdfItem->sceneBoundingRect();
+            overlayPage.pdfScale = pdfItem->scale();
+            overlayPage.annotationsRect = scene->annotationsBoundingRect();
+        }
+
+        mOverlayPages << overlayPage;
+
+        sceneLoader.releaseScene(pageIndex);
     }
 
     if (pdfPainter) delete pdfPainter;
+
+    return completed;
 }
 
 
@@ -152,8 +200,13 @@ bool UBExportFullPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QS
         previousOverlay.remove();
 
     mHasPDFBackgrounds = false;
+    mOverlayPages.clear();
 
-    saveOverlayPdf(pDocumentProxy, overlayName);
+    if (!saveOverlayPdf(pDocumentProxy, overlayName))
+    {
+        QFile::remove(overlayName);
+        return false;
+    }
 
     if (!mHasPDFBackgrounds)
     {
@@ -169,27 +222,24 @@ bool UBExportFullPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QS
 
             MergeDescription mergeInfo;
 
-            int existingPageCount = pDocumentProxy->pageCount();
-
-            for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++)
+            for(int pageIndex = 0 ; pageIndex < mOverlayPages.size(); pageIndex++)
             {
-                UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
-                UBGraphicsPDFItem *pdfItem = qgraphicsitem_cast<UBGraphicsPDFItem*>(scene->backgroundObject());
+                const OverlayPage& overlayPage = mOverlayPages.at(pageIndex);
+
+                QSize pageSize = overlayPage.pageSize;
 
-                QSize pageSize = scene->nominalSize();
-                
-                if (pdfItem)
+                if (overlayPage.hasPdfBackground)
                 {
-                    QString pdfName = UBPersistenceManager::objectDirectory + "/" + pdfItem->fileUuid().toString() + ".pdf";
+                    QString pdfName = UBPersistenceManager::objectDirectory + "/" + overlayPage.pdfFileUuid.toString() + ".pdf";
                     QString backgroundPath = pDocumentProxy->persistencePath() + "/" + pdfName;
-                    QRectF annotationsRect = scene->annotationsBoundingRect();
+                    QRectF annotationsRect = overlayPage.annotationsRect;
 
                     // Original datas
                     double xAnnotation = qRound(annotationsRect.x());
                     double yAnnotation = qRound(annotationsRect.y());
-                    double xPdf = qRound(pdfItem->sceneBoundingRect().x());
-                    double yPdf = qRound(pdfItem->sceneBoundingRect().y());
-                    double hPdf = qRound(pdfItem->sceneBoundingRect().height());
+                    double xPdf = qRound(overlayPage.pdfSceneRect.x());
+                    double yPdf = qRound(overlayPage.pdfSceneRect.y());
+                    double hPdf = qRound(overlayPage.pdfSceneRect.height());
 
                     // Exportation-transformed datas
                     double hScaleFactor = pageSize.width()/annotationsRect.width();
@@ -210,14 +260,14 @@ bool UBExportFullPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QS
 
                     // If the PDF was scaled when added to the scene (e.g if it was loaded from a document with a different DPI
                     // than the current one), it should also be scaled here.
-                    qreal pdfScale = pdfItem->scale();
+                    qreal pdfScale = overlayPage.pdfScale;
 
                     TransformationDescription pdfTransform(xPdfOffset, yPdfOffset, scaleFactor * pdfScale, 0);
                     TransformationDescription annotationTransform(xAnnotationsOffset, yAnnotationsOffset, 1, 0);
 
                     MergePageDescription pageDescription(pageSize.width() * mScaleFactor,
                                                          pageSize.height() * mScaleFactor,
-                                                         pdfItem->pageNumber(),
+                                                         overlayPage.pdfPageNumber,
                                                          QFile::encodeName(backgroundPath).constData(),
                                                          pdfTransform,
                                                          pageIndex + 1,
@@ -253,7 +303,15 @@ bool UBExportFullPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QS
             qDebug() << "PdfMerger failed to merge documents to " << filename << " - Exception : " << e.what();
 
             // default to raster export
-            mSimpleExporter->persistsDocument(pDocumentProxy, filename);
+            mSimpleExporter->setProgressListener(mProgressListener);
+            bool persisted = mSimpleExporter->persistsDocument(pDocumentProxy, filename);
+            mSimpleExporter->setProgressListener(0);
+
+            if (!persisted)
+            {
+                QFile::remove(overlayName);
+                return false;
+            }
         }
 
         if (!UBApplication::app()->isVerbose())
@@ -51,11 +51,24 @@ class UBExportFullPDF : public UBExportAdaptor
         virtual bool persistsDocument(UBDocumentProxy* pDocument, const QString& filename);
 
     protected:
-        void saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QString& filename);
+        bool saveOverlayPdf(UBDocumentProxy* pDocumentProxy, const QString& filename);
 
     private:
+        // what the merge needs from each overlay page, gathered while the overlay is rendered
+        struct OverlayPage
+        {
+            QSize pageSize;
+            bool hasPdfBackground;
+            QUuid pdfFileUuid;
+            int pdfPageNumber;
+            QRectF pdfSceneRect;
+            qreal pdfScale;
+            QRectF annotationsRect;
+        };
+
         float mScaleFactor;
         bool mHasPDFBackgrounds;
+        QList<OverlayPage> mOverlayPages;
 
         UBExportPDF * mSimpleExporter;
 };
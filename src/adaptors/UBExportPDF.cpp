@@ -45,14 +45,19 @@
 
 #include "document/UBDocumentProxy.h"
 
+#include "frameworks/UBDecodingQueue.h"
+#include "frameworks/UBExportImageCache.h"
+
 #include "pdf/GraphicsPDFItem.h"
 
+#include "UBExportSceneLoader.h"
+
 #include "core/memcheck.h"
 
 UBExportPDF::UBExportPDF(QObject *parent)
     : UBExportAdaptor(parent)
 {
-    // NOOP
+    UBExportPDF::tr("Page"); // dummy slot for translation
 }
 
 UBExportPDF::~UBExportPDF()
@@ -87,10 +92,24 @@ bool UBExportPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QStrin
 
     int existingPageCount = pDocumentProxy->pageCount();
 
+    // pages are read ahead on worker threads and kept out of the scene cache
+    UBExportSceneLoader sceneLoader(pDocumentProxy);
+
+    // images repeated over pages are embedded once
+    UBExportImageCache imageCache(UBSettings::settings()->pdfImageResolution->get().toInt());
+
+    bool completed = true;
+
     for(int pageIndex = 0 ; pageIndex < existingPageCount; pageIndex++) {
 
-        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(pDocumentProxy, pageIndex);
-        UBApplication::showMessage(tr("Exporting page %1 of %2").arg(pageIndex + 1).arg(existingPageCount));
+        if (!exportProgress("Page", pageIndex + 1, existingPageCount)) {
+            completed = false;
+            break;
+        }
+
+        UBGraphicsScene* scene = sceneLoader.scene(pageIndex);
+        if (!scene)
+            continue;
 
         // set background to white, no crossing for PDF output
         bool isDark = scene->isDarkBackground();
@@ -104,6 +123,7 @@ bool UBExportPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QStrin
         // set high res rendering
         scene->setRenderingQuality(UBItem::RenderingQualityHigh);
         scene->setRenderingContext(UBGraphicsScene::NonScreen);
+        scene->setExportImageCache(&imageCache);
 
         // Setting output page size
         QPageSize outputPageSize = QPageSize(QSizeF(pageSize.width()*scaleFactor, pageSize.height()*scaleFactor), QPageSize::Point);
@@ -117,20 +137,24 @@ bool UBExportPDF::persistsDocument(UBDocumentProxy* pDocumentProxy, const QStrin
             pdfWriter.newPage();
 
         // Render the scene
+        UBDecodingQueue::queue()->waitForPendingDecodes(scene);
         scene->render(&pdfPainter, QRectF(), scene->normalizedSceneRect());
 
         // Restore screen rendering quality
         scene->setRenderingContext(UBGraphicsScene::Screen);
+        scene->setExportImageCache(0);
         scene->setRenderingQuality(UBItem::RenderingQualityNormal);
 
         // Restore background state
         scene->setBackground(isDark, isCrossed);
+
+        sceneLoader.releaseScene(pageIndex);
     }
 
     if(!painterNeedsBegin)
         pdfPainter.end();
 
-    return true;
+    return completed;
 }
 
 QString UBExportPDF::exportExtention()
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBExportQueue.h"
+
+#include <QProgressDialog>
+
+#include "UBExportAdaptor.h"
+
+#include "core/UBApplication.h"
+#include "core/UBPersistenceManager.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "frameworks/UBFileSystemUtils.h"
+
+#include "gui/UBMainWindow.h"
+
+#include "core/memcheck.h"
+
+UBExportQueue* UBExportQueue::sQueue = 0;
+
+
+class UBExportJob : public QRunnable, public UBProcessingProgressListener
+{
+    public:
+        UBExportJob(UBExportQueue* queue, UBExportAdaptor* adaptor, UBDocumentProxy* document, const QString& filename)
+            : mQueue(queue)
+            , mAdaptor(adaptor)
+            , mDocument(document)
+            , mPersistencePath(document->persistencePath())
+            , mPageCount(document->pageCount())
+            , mFilename(filename)
+            , mTargetExisted(QFileInfo(filename).exists())
+            , mCancelled(0)
+            , mSuccess(false)
+        {
+            setAutoDelete(false);
+        }
+
+        virtual void run()
+        {
+            if (!isCancelled())
+            {
+                mAdaptor->setProgressListener(this);
+
+                // on the worker thread only the recorded path is used, the GUI may delete the proxy meanwhile
+                if (mAdaptor->persistsInBackground())
+                    mSuccess = mAdaptor->persistsDocumentFiles(mPersistencePath, mFilename);
+                else
+                    mSuccess = mAdaptor->persistsDocument(mDocument, mFilename);
+
+                mSuccess = mSuccess && !isCancelled();
+                mAdaptor->setProgressListener(0);
+            }
+
+            QMetaObject::invokeMethod(mQueue, "jobFinished", Qt::QueuedConnection);
+        }
+
+        virtual void processing(const QString& pObjectName, int pCurrent, int pTotal)
+        {
+            QMetaObject::invokeMethod(mQueue, "jobProgress", Qt::QueuedConnection,
+                                      Q_ARG(QString, pObjectName), Q_ARG(int, pCurrent), Q_ARG(int, pTotal));
+
+            // jobs rendering scenes run in the GUI thread, keep it responsive between two steps
+            if (QThread::currentThread() == mQueue->thread())
+                QCoreApplication::processEvents();
+        }
+
+        virtual void bytesProcessed(qint64 pBytes, qint64 pElapsedMSecs)
+        {
+            QMetaObject::invokeMethod(mQueue, "jobThroughput", Qt::QueuedConnection,
+                                      Q_ARG(qint64, pBytes), Q_ARG(qint64, pElapsedMSecs));
+        }
+
+        // also read from the worker thread: documentWillBeDeleted cancels the job, mDocument is not looked at
+        virtual bool isCancelled() const
+        {
+            return mCancelled.load() != 0;
+        }
+
+        void cancel()
+        {
+            mCancelled.store(1);
+        }
+
+        UBExportQueue* mQueue;
+        UBExportAdaptor* mAdaptor;
+        QPointer<UBDocumentProxy> mDocument;
+        // the document as it was queued
+        QString mPersistencePath;
+        int mPageCount;
+        QString mFilename;
+        bool mTargetExisted;
+        QAtomicInt mCancelled;
+        bool mSuccess;
+};
+
+
+UBExportQueue* UBExportQueue::queue()
+{
+    if (!sQueue)
+        sQueue = new UBExportQueue();
+
+    return sQueue;
+}
+
+
+void UBExportQueue::destroy()
+{
+    delete sQueue;
+    sQueue = 0;
+}
+
+
+UBExportQueue::UBExportQueue()
+    : QObject(0)
+    , mCurrentJob(0)
+{
+    // exports write big files, running them one after the other is faster than side by side
+    mPool.setMaxThreadCount(1);
+
+    connect(UBPersistenceManager::persistenceManager(), SIGNAL(documentWillBeDeleted(UBDocumentProxy*)),
+            this, SLOT(documentWillBeDeleted(UBDocumentProxy*)));
+}
+
+
+UBExportQueue::~UBExportQueue()
+{
+    cancelAllExports();
+
+    mPool.waitForDone();
+
+    delete mCurrentJob;
+
+    if (mProgressDialog)
+        delete mProgressDialog;
+}
+
+
+void UBExportQueue::enqueue(UBExportAdaptor* adaptor, UBDocumentProxy* document, const QString& filename)
+{
+    mPendingJobs << new UBExportJob(this, adaptor, document, filename);
+
+    if (!mCurrentJob)
+        QTimer::singleShot(0, this, SLOT(startNextJob()));
+    else
+        updateProgressDialog(mProgressText, -1, -1);
+}
+
+
+bool UBExportQueue::hasPendingExports() const
+{
+    return mCurrentJob || !mPendingJobs.isEmpty();
+}
+
+
+bool UBExportQueue::blocksPageChanges(UBDocumentProxy* document)
+{
+    if (!document)
+        return false;
+
+    bool exporting = mCurrentJob && mCurrentJob->mDocument == document;
+
+    foreach (UBExportJob* job, mPendingJobs)
+        exporting = exporting || job->mDocument == document;
+
+    if (exporting)
+        UBApplication::showMessage(tr("Pages cannot be added, removed or moved while the document is being exported."));
+
+    return exporting;
+}
+
+
+void UBExportQueue::cancelCurrentExport()
+{
+    if (mCurrentJob)
+        mCurrentJob->cancel();
+}
+
+
+void UBExportQueue::cancelAllExports()
+{
+    foreach (UBExportJob* job, mPendingJobs)
+        delete job;
+
+    mPendingJobs.clear();
+
+    cancelCurrentExport();
+}
+
+
+void UBExportQueue::documentWillBeDeleted(UBDocumentProxy* document)
+{
+    foreach (UBExportJob* job, mPendingJobs)
+    {
+        if (job->mDocument == document)
+        {
+            mPendingJobs.removeAll(job);
+            delete job;
+        }
+    }
+
+    if (mCurrentJob && mCurrentJob->mDocument == document)
+        mCurrentJob->cancel();
+}
+
+
+void UBExportQueue::startNextJob()
+{
+    if (mCurrentJob || mPendingJobs.isEmpty())
+        return;
+
+    mCurrentJob = mPendingJobs.takeFirst();
+    mThroughputText.clear();
+
+    UBDocumentProxy* document = mCurrentJob->mDocument;
+
+    if (!document)
+    {
+        qWarning() << "document" << mCurrentJob->mPersistencePath << "was deleted since its export was queued";
+        mCurrentJob->cancel();
+    }
+    else if (document->persistencePath() != mCurrentJob->mPersistencePath || document->pageCount() != mCurrentJob->mPageCount)
+    {
+        qWarning() << "document" << mCurrentJob->mPersistencePath << "changed since its export was queued";
+        mCurrentJob->cancel();
+    }
+
+    updateProgressDialog(tr("Exporting %1").arg(QFileInfo(mCurrentJob->mFilename).fileName()), 0, 0);
+
+    if (mCurrentJob->mAdaptor->persistsInBackground())
+        mPool.start(mCurrentJob);
+    else
+        mCurrentJob->run();
+}
+
+
+void UBExportQueue::jobProgress(const QString& objectName, int current, int total)
+{
+    if (!mCurrentJob)
+        return;
+
+    // object names are translated in the context of the adaptor exporting them
+    QString localized = QCoreApplication::translate(mCurrentJob->mAdaptor->metaObject()->className(), objectName.toUtf8().constData());
+    QString text = tr("Exporting %1 %2 of %3").arg(localized).arg(current).arg(total);
+
+    updateProgressDialog(text, current, total);
+
+    if (mCurrentJob->mAdaptor->isVerbose())
+        UBApplication::showMessage(text);
+}
+
+
+void UBExportQueue::jobThroughput(qint64 bytes, qint64 elapsedMSecs)
+{
+    if (!mCurrentJob || elapsedMSecs <= 0)
+        return;
+
+    double megaBytes = bytes / (1024.0 * 1024.0);
+    mThroughputText = tr("%1 MB written, %2 MB/s").arg(megaBytes, 0, 'f', 1).arg(megaBytes * 1000 / elapsedMSecs, 0, 'f', 1);
+
+    updateProgressDialog(mProgressText, -1, -1);
+}
+
+
+void UBExportQueue::jobFinished()
+{
+    UBExportJob* job = mCurrentJob;
+    mCurrentJob = 0;
+
+    if (!job)
+        return;
+
+    bool cancelled = job->isCancelled();
+
+    if (!job->mSuccess)
+    {
+        // directory exports (web) only remove a directory they created, never one picked with other content
+        if (!QFileInfo(job->mFilename).isDir())
+            QFile::remove(job->mFilename);
+        else if (!job->mTargetExisted)
+            UBFileSystemUtils::deleteDir(job->mFilename);
+    }
+
+    if (job->mAdaptor->isVerbose())
+    {
+        if (job->mSuccess)
+            UBApplication::showMessage(tr("Export successful."));
+        else if (cancelled)
+            UBApplication::showMessage(tr("Export cancelled."));
+        else
+            UBApplication::showMessage(tr("Export failed."));
+    }
+
+    if (!cancelled)
+        job->mAdaptor->exportFinished(job->mDocument, job->mFilename, job->mSuccess);
+
+    emit exportFinished(job->mFilename, job->mSuccess);
+
+    delete job;
+
+    if (!mPendingJobs.isEmpty())
+    {
+        QTimer::singleShot(0, this, SLOT(startNextJob()));
+    }
+    else if (mProgressDialog)
+    {
+        // a new dialog waits its minimum duration again before showing up for the next exports
+        QProgressDialog* dialog = mProgressDialog;
+        mProgressDialog = 0;
+        dialog->deleteLater();
+    }
+}
+
+
+void UBExportQueue::updateProgressDialog(const QString& text, int current, int total)
+{
+    if (!mProgressDialog)
+    {
+        mProgressDialog = new QProgressDialog(UBApplication::mainWindow);
+        mProgressDialog->setWindowTitle(tr("Export"));
+        mProgressDialog->setWindowModality(Qt::NonModal);
+        mProgressDialog->setAutoClose(false);
+        mProgressDialog->setAutoReset(false);
+        // quick exports are over before the dialog shows up
+        mProgressDialog->setMinimumDuration(2000);
+        mProgressDialog->setCancelButtonText(tr("Cancel"));
+
+        connect(mProgressDialog, SIGNAL(canceled()), this, SLOT(cancelCurrentExport()));
+    }
+
+    mProgressText = text;
+
+    QString label = text;
+
+    if (!mThroughputText.isEmpty())
+        label += "\n" + mThroughputText;
+
+    if (!mPendingJobs.isEmpty())
+        label += "\n" + tr("%n more export(s) queued", "", mPendingJobs.size());
+
+    mProgressDialog->setLabelText(label);
+
+    if (total >= 0)
+    {
+        mProgressDialog->setMaximum(total);
+        mProgressDialog->setValue(current);
+    }
+}
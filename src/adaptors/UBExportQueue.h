@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBEXPORTQUEUE_H_
+#define UBEXPORTQUEUE_H_
+
+#include <QtGui>
+#include <QThreadPool>
+#include <QPointer>
+
+class QProgressDialog;
+class UBDocumentProxy;
+class UBExportAdaptor;
+class UBExportJob;
+
+/*
+ * Runs exports one after the other. Adaptors that only read the persisted document run on a
+ * worker thread; the ones rendering scenes run in the GUI thread and let it process its events
+ * after each page. Progress is shown in a non modal dialog through which the export can be cancelled.
+ * The pages of a document cannot be added, removed or moved from the time its export is queued until
+ * it is done, the export reads them from disk while the GUI keeps running.
+ */
+class UBExportQueue : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static UBExportQueue* queue();
+        static void destroy();
+
+        void enqueue(UBExportAdaptor* adaptor, UBDocumentProxy* document, const QString& filename);
+        bool hasPendingExports() const;
+
+        // true, and the user is told, while an export of the document is queued or running
+        bool blocksPageChanges(UBDocumentProxy* document);
+
+    public slots:
+        void cancelCurrentExport();
+        void cancelAllExports();
+
+    signals:
+        void exportFinished(const QString& filename, bool success);
+
+    private slots:
+        void startNextJob();
+        void jobProgress(const QString& objectName, int current, int total);
+        void jobThroughput(qint64 bytes, qint64 elapsedMSecs);
+        void jobFinished();
+        void documentWillBeDeleted(UBDocumentProxy* document);
+
+    private:
+        UBExportQueue();
+        virtual ~UBExportQueue();
+
+        void updateProgressDialog(const QString& text, int current, int total);
+
+        static UBExportQueue* sQueue;
+
+        QThreadPool mPool;
+        QList<UBExportJob*> mPendingJobs;
+        UBExportJob* mCurrentJob;
+        QPointer<QProgressDialog> mProgressDialog;
+        QString mProgressText;
+        QString mThroughputText;
+};
+
+#endif /* UBEXPORTQUEUE_H_ */
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBExportSceneLoader.h"
+
+#include "core/UBPersistenceManager.h"
+
+#include "domain/UBGraphicsScene.h"
+
+#include "document/UBDocumentProxy.h"
+
+#include "UBSvgSubsetAdaptor.h"
+
+#include "core/memcheck.h"
+
+
+class UBExportSceneReading : public QRunnable
+{
+    public:
+        UBExportSceneReading(UBExportSceneLoader* loader, const QString& persistencePath, int pageIndex)
+            : mLoader(loader)
+            , mPersistencePath(persistencePath)
+            , mPageIndex(pageIndex)
+        {
+            // NOOP
+        }
+
+        virtual void run()
+        {
+            mLoader->textRead(mPageIndex, UBSvgSubsetAdaptor::loadSceneAsText(mPersistencePath, mPageIndex));
+        }
+
+    private:
+        UBExportSceneLoader* mLoader;
+        QString mPersistencePath;
+        int mPageIndex;
+};
+
+
+UBExportSceneLoader::UBExportSceneLoader(UBDocumentProxy* proxy, int readAhead)
+    : mProxy(proxy)
+    , mPersistencePath(proxy->persistencePath())
+    , mPageCount(proxy->pageCount())
+    , mReadAhead(qMax(1, readAhead))
+    , mNextPageToRead(0)
+{
+    mPool.setMaxThreadCount(qMin(mReadAhead, qMax(1, QThread::idealThreadCount() - 1)));
+}
+
+
+UBExportSceneLoader::~UBExportSceneLoader()
+{
+    mPool.waitForDone();
+
+    qDeleteAll(mOwnedScenes);
+}
+
+
+UBGraphicsScene* UBExportSceneLoader::scene(int pageIndex)
+{
+    if (mOwnedScenes.contains(pageIndex))
+        return mOwnedScenes.value(pageIndex);
+
+    readAhead(pageIndex);
+
+    UBGraphicsScene* cachedScene = UBPersistenceManager::persistenceManager()->getDocumentScene(mProxy, pageIndex);
+
+    if (cachedScene)
+    {
+        // the cached scene may hold unsaved changes, it wins over the text read from disk
+        if (mPendingPages.remove(pageIndex))
+            takeReadText(pageIndex);
+
+        // a page shown on the board may still wait for media of its imported document
+        UBPersistenceManager::persistenceManager()->extractSceneMedia(mProxy, pageIndex);
+
+        return cachedScene;
+    }
+
+    QByteArray text;
+
+    // pages skipped by the read ahead because they were cached then, or asked for a second time, are read here
+    if (mPendingPages.remove(pageIndex))
+        text = takeReadText(pageIndex);
+    else
+        text = UBSvgSubsetAdaptor::loadSceneAsText(mPersistencePath, pageIndex);
+
+    if (text.isEmpty())
+    {
+        qWarning() << "cannot read page" << pageIndex << "of" << mPersistencePath;
+        return 0;
+    }
+
+    UBGraphicsScene* scene = UBSvgSubsetAdaptor::loadScene(mProxy, text);
+
+    if (scene)
+        mOwnedScenes.insert(pageIndex, scene);
+
+    return scene;
+}
+
+
+void UBExportSceneLoader::releaseScene(int pageIndex)
+{
+    // deleted right away: the export loop does not return to the event loop before its last page
+    delete mOwnedScenes.take(pageIndex);
+}
+
+
+void UBExportSceneLoader::readAhead(int fromPageIndex)
+{
+    int lastPageToRead = qMin(fromPageIndex + mReadAhead, mPageCount) - 1;
+
+    if (mNextPageToRead < fromPageIndex)
+        mNextPageToRead = fromPageIndex;
+
+    for (; mNextPageToRead <= lastPageToRead; mNextPageToRead++)
+    {
+        if (UBPersistenceManager::persistenceManager()->getDocumentScene(mProxy, mNextPageToRead))
+            continue;
+
+        mPendingPages.insert(mNextPageToRead);
+        mPool.start(new UBExportSceneReading(this, mPersistencePath, mNextPageToRead));
+    }
+}
+
+
+QByteArray UBExportSceneLoader::takeReadText(int pageIndex)
+{
+    QMutexLocker locker(&mMutex);
+
+    while (!mTexts.contains(pageIndex))
+        mTextAvailable.wait(&mMutex);
+
+    return mTexts.take(pageIndex);
+}
+
+
+void UBExportSceneLoader::textRead(int pageIndex, const QByteArray& text)
+{
+    QMutexLocker locker(&mMutex);
+
+    mTexts.insert(pageIndex, text);
+    mTextAvailable.wakeAll();
+}
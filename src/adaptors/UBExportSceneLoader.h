@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBEXPORTSCENELOADER_H_
+#define UBEXPORTSCENELOADER_H_
+
+#include <QtCore>
+#include <QThreadPool>
+
+class UBDocumentProxy;
+class UBGraphicsScene;
+
+/*
+ * Hands the export adaptors one scene per page without going through the persistence
+ * manager scene cache. The svg text of the next pages is read on a thread pool while the
+ * current page is built and rendered; scenes that were already cached (e.g. the page shown
+ * on the board) are reused as is and never deleted. The persistence path and page count are
+ * taken when the loader is created, the worker threads never touch the document proxy.
+ */
+class UBExportSceneLoader
+{
+    public:
+        UBExportSceneLoader(UBDocumentProxy* proxy, int readAhead = 4);
+        virtual ~UBExportSceneLoader();
+
+        UBGraphicsScene* scene(int pageIndex);
+        void releaseScene(int pageIndex);
+
+    private:
+        friend class UBExportSceneReading;
+
+        void readAhead(int fromPageIndex);
+        QByteArray takeReadText(int pageIndex);
+        void textRead(int pageIndex, const QByteArray& text);
+
+        UBDocumentProxy* mProxy;
+        QString mPersistencePath;
+        int mPageCount;
+        int mReadAhead;
+        int mNextPageToRead;
+
+        QThreadPool mPool;
+        QMutex mMutex;
+        QWaitCondition mTextAvailable;
+        QHash<int, QByteArray> mTexts;
+        QSet<int> mPendingPages;
+
+        QHash<int, UBGraphicsScene*> mOwnedScenes;
+};
+
+#endif /* UBEXPORTSCENELOADER_H_ */
@@ -28,6 +28,7 @@
 
 
 #include "UBExportWeb.h"
+#include "UBDocumentArchiveExtractor.h"
 
 #include "frameworks/UBPlatformUtils.h"
 #include "frameworks/UBFileSystemUtils.h"
@@ -67,29 +68,38 @@ void UBExportWeb::persist(UBDocumentProxy* pDocumentProxy)
     QString dirName = askForDirName(pDocumentProxy, tr("Export as Web data"));
 
     if (dirName.length() > 0)
-    {
-        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-        UBApplication::showMessage(tr("Exporting document..."));
+        persistInQueue(pDocumentProxy, dirName);
+}
+
+
+bool UBExportWeb::persistsDocument(UBDocumentProxy* pDocumentProxy, const QString& dirName)
+{
+    return persistsDocumentFiles(pDocumentProxy->persistencePath(), dirName);
+}
 
-        if(UBFileSystemUtils::copyDir(pDocumentProxy->persistencePath(), dirName))
-        {
-            QString htmlPath = dirName + "/index.html";
 
-            QFile html(":www/OpenBoard-web-player.html");
-            html.copy(htmlPath);
+bool UBExportWeb::persistsDocumentFiles(const QString& persistencePath, const QString& dirName)
+{
+    UBDocumentArchiveExtractor::extractor()->extractAllEntries(persistencePath);
 
-            UBApplication::showMessage(tr("Export successful."));
+    if (!UBFileSystemUtils::copyDir(persistencePath, dirName))
+        return false;
 
-            QDesktopServices::openUrl(QUrl::fromLocalFile(htmlPath));
-        }
-        else
-        {
-            UBApplication::showMessage(tr("Export failed."));
-        }
+    QFile html(":www/OpenBoard-web-player.html");
 
+    if (!html.copy(dirName + "/index.html"))
+        qWarning() << "cannot copy the web player to" << dirName << html.errorString();
+
+    return true;
+}
+
+
+void UBExportWeb::exportFinished(UBDocumentProxy* pDocumentProxy, const QString& dirName, bool success)
+{
+    Q_UNUSED(pDocumentProxy);
 
-        QApplication::restoreOverrideCursor();
-    }
+    if (success)
+        QDesktopServices::openUrl(QUrl::fromLocalFile(dirName + "/index.html"));
 }
 
 
@@ -48,6 +48,15 @@ class UBExportWeb : public UBExportAdaptor
 
         virtual void persist(UBDocumentProxy* pDocument);
 
+        virtual bool persistsDocument(UBDocumentProxy* pDocument, const QString& dirName);
+        virtual bool persistsDocumentFiles(const QString& persistencePath, const QString& dirName);
+        virtual bool persistsInBackground() const
+        {
+            return true;
+        }
+
+        virtual void exportFinished(UBDocumentProxy* pDocument, const QString& dirName, bool success);
+
 };
 
 #endif /* UBEXPORTWEB_H_ */
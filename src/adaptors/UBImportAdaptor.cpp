@@ -54,6 +54,15 @@ UBPageBasedImportAdaptor::UBPageBasedImportAdaptor(QObject *parent)
     // NOOP
 }
 
+int UBPageBasedImportAdaptor::importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(uuid);
+    Q_UNUSED(filePath);
+
+    return -1;
+}
+
 UBDocumentBasedImportAdaptor::UBDocumentBasedImportAdaptor(QObject *parent)
     :UBImportAdaptor(true, parent)
 {
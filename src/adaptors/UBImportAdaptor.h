@@ -64,6 +64,9 @@ public:
         virtual QList<UBGraphicsItem*> import(const QUuid& uuid, const QString& filePath) = 0;
         virtual void placeImportedItemToScene(UBGraphicsScene* scene, UBGraphicsItem* item) = 0;
         virtual const QString& folderToCopy() = 0;
+
+        // appends the pages to the document without building their scenes, returns -1 when not supported
+        virtual int importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath);
 };
 
 class UBDocumentBasedImportAdaptor : public UBImportAdaptor
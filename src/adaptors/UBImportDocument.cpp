@@ -28,6 +28,7 @@
 
 
 #include "UBImportDocument.h"
+#include "UBDocumentArchiveExtractor.h"
 #include "document/UBDocumentProxy.h"
 
 #include "frameworks/UBFileSystemUtils.h"
@@ -35,6 +36,7 @@
 #include "core/UBApplication.h"
 #include "core/UBSettings.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBMediaStore.h"
 
 #include "globals/UBGlobals.h"
 
@@ -70,7 +72,22 @@ QString UBImportDocument::importFileFilter()
 }
 
 
-bool UBImportDocument::extractFileToDir(const QFile& pZipFile, const QString& pDir, QString& documentRoot)
+// media big enough to be worth showing the document before they are extracted
+static bool isDeferredEntry(const QuaZipFileInfo& info)
+{
+    static const qint64 minDeferredSize = 1024 * 1024;
+
+    QString directory = info.name.section('/', 0, 0);
+
+    return info.uncompressedSize >= minDeferredSize
+            && (directory == UBPersistenceManager::videoDirectory
+                || directory == UBPersistenceManager::audioDirectory
+                || directory == UBPersistenceManager::imageDirectory
+                || directory == UBPersistenceManager::objectDirectory);
+}
+
+
+bool UBImportDocument::extractFileToDir(const QFile& pZipFile, const QString& pDir, QString& documentRoot, QStringList* deferredEntries)
 {
 
     QDir rootDir(pDir);
@@ -87,7 +104,6 @@ bool UBImportDocument::extractFileToDir(const QFile& pZipFile, const QString& pD
     QuaZipFile file(&zip);
 
     QFile out;
-    char c;
     documentRoot = UBPersistenceManager::persistenceManager()->generateUniqueDocumentPath(pDir);
     for(bool more=zip.goToFirstFile(); more; more=zip.goToNextFile())
     {
@@ -98,6 +114,12 @@ bool UBImportDocument::extractFileToDir(const QFile& pZipFile, const QString& pD
             return false;
         }
 
+        if (deferredEntries && isDeferredEntry(info))
+        {
+            deferredEntries->append(info.name);
+            continue;
+        }
+
         if(!file.open(QIODevice::ReadOnly))
         {
             qWarning() << "Import failed. Cause: file.open(): " << zip.getZipError();
@@ -119,20 +141,18 @@ bool UBImportDocument::extractFileToDir(const QFile& pZipFile, const QString& pD
         if (!out.open(QIODevice::WriteOnly))
             return false;
 
-        // Slow like hell (on GNU/Linux at least), but it is not my fault.
-        // Not ZIP/UNZIP package's fault either.
-        // The slowest thing here is out.putChar(c).
-        QByteArray outFileContent = file.readAll();
-        if (out.write(outFileContent) == -1)
+        // copied by chunks, media entries can be big
+        while (!file.atEnd() && file.getZipError() == UNZ_OK)
         {
-            qWarning() << "Import failed. Cause: Unable to write file";
-            out.close();
-            return false;
+            QByteArray buffer = file.read(1024 * 1024);
+            if (out.write(buffer) == -1)
+            {
+                qWarning() << "Import failed. Cause: Unable to write file";
+                out.close();
+                return false;
+            }
         }
 
-        while(file.getChar(&c))
-            out.putChar(c);
-
         out.close();
 
         if(file.getZipError()!=UNZ_OK)
@@ -180,11 +200,18 @@ UBDocumentProxy* UBImportDocument::importFile(const QFile& pFile, const QString&
 
     QString documentRootFolder;
 
-    if(!extractFileToDir(pFile, path, documentRootFolder)){
+    // big media are extracted once the document shows up, or when a page needs them
+    QStringList deferredEntries;
+
+    if(!extractFileToDir(pFile, path, documentRootFolder, &deferredEntries)){
         UBApplication::showMessage(tr("Import of file %1 failed.").arg(fi.baseName()));
         return NULL;
     }
 
+    // the deferred entries are stored as they get extracted
+    UBMediaStore::storeDocumentMediaLater(documentRootFolder);
+    UBDocumentArchiveExtractor::extractor()->extractLater(fi.absoluteFilePath(), documentRootFolder, deferredEntries);
+
     UBDocumentProxy* newDocument = UBPersistenceManager::persistenceManager()->createDocumentFromDir(documentRootFolder, pGroup, "");
     UBApplication::showMessage(tr("Import successful."));
     return newDocument;
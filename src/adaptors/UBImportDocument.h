@@ -51,7 +51,8 @@ class UBImportDocument : public UBDocumentBasedImportAdaptor
         virtual bool addFileToDocument(UBDocumentProxy* pDocument, const QFile& pFile);
 
     private:
-        bool extractFileToDir(const QFile& pZipFile, const QString& pDir, QString& documentRoot);
+        // with deferredEntries, big media entries are not extracted but listed there
+        bool extractFileToDir(const QFile& pZipFile, const QString& pDir, QString& documentRoot, QStringList* deferredEntries = 0);
 };
 
 #endif /* UBIMPORTDOCUMENT_H_ */
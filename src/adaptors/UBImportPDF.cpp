@@ -33,11 +33,19 @@
 
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBSettings.h"
+
+#include "board/UBBoardController.h"
+#include "document/UBDocumentController.h"
+
+#include "frameworks/UBFileSystemUtils.h"
 
 #include "domain/UBGraphicsPDFItem.h"
 
 #include "pdf/PDFRenderer.h"
 
+#include "UBSvgSubsetAdaptor.h"
+
 #include "core/memcheck.h"
 
 UBImportPDF::UBImportPDF(QObject *parent)
@@ -89,6 +97,134 @@ QList<UBGraphicsItem*> UBImportPDF::import(const QUuid& uuid, const QString& fil
     return result;
 }
 
+int UBImportPDF::importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath)
+{
+    PDFRenderer *pdfRenderer = PDFRenderer::rendererForUuid(uuid, filePath, true);
+
+    if (!pdfRenderer->isValid())
+    {
+        // not attached, take it down
+        pdfRenderer->attach();
+        pdfRenderer->detach();
+
+        UBApplication::showMessage(tr("PDF import failed."));
+        return 0;
+    }
+
+    pdfRenderer->attach();
+    pdfRenderer->setDPI(this->dpi);
+
+    QString pdfFileName = UBPersistenceManager::objectDirectory + "/" + QFileInfo(filePath).fileName();
+
+    int pdfPageCount = pdfRenderer->pageCount();
+    int thumbnailWidth = UBSettings::maxThumbnailWidth;
+
+    ThumbnailedImport thumbnailedImport;
+    thumbnailedImport.document = document;
+
+    QList<PDFThumbnailRequest> thumbnailRequests;
+    QHash<QString, QByteArray> blankThumbnails;
+
+    // pages are written as descriptors, their scene is built the first time they are opened
+    for(int pdfPageNumber = 1; pdfPageNumber <= pdfPageCount; pdfPageNumber++)
+    {
+        QSizeF pageSize = pdfRenderer->pageSizeF(pdfPageNumber);
+
+        int pageIndex = UBPersistenceManager::persistenceManager()->appendPDFPage(document, pdfFileName, pdfPageNumber, pageSize);
+        if (pageIndex < 0)
+            break;
+
+        // a blank thumbnail until the real one is rasterized, so that nothing loads the scene to make one
+        QSizeF thumbnailRatio = pageSize;
+
+        // a degenerate page box gets the default page proportions, the thumbnailer skips such pages
+        if (thumbnailRatio.width() <= 0 || thumbnailRatio.height() <= 0)
+            thumbnailRatio = QSizeF(UBSettings::settings()->pageSize->get().toSize());
+
+        int thumbnailHeight = qRound(thumbnailWidth * thumbnailRatio.height() / thumbnailRatio.width());
+        QString sizeKey = QString("%1x%2").arg(thumbnailWidth).arg(thumbnailHeight);
+
+        if (!blankThumbnails.contains(sizeKey))
+        {
+            QImage blank(thumbnailWidth, thumbnailHeight, QImage::Format_RGB32);
+            blank.fill(UBSettings::settings()->isDarkBackground() ? Qt::black : Qt::white);
+
+            QBuffer buffer(&blankThumbnails[sizeKey]);
+            buffer.open(QIODevice::WriteOnly);
+            blank.save(&buffer, "JPG");
+        }
+
+        PDFThumbnailRequest request;
+        request.pageNumber = pdfPageNumber;
+        request.thumbnailFile = document->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", pageIndex);
+        request.persistencePath = document->persistencePath();
+        request.pageIndex = pageIndex;
+        request.sceneUuid = UBSvgSubsetAdaptor::sceneUuid(document, pageIndex);
+
+        QFile thumbnailFile(request.thumbnailFile);
+        if (thumbnailFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            thumbnailFile.write(blankThumbnails.value(sizeKey));
+            thumbnailFile.close();
+        }
+
+        request.pageModified = QFileInfo(request.persistencePath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex)).lastModified();
+
+        thumbnailRequests << request;
+        thumbnailedImport.pageIndexes << pageIndex;
+    }
+
+    if (!thumbnailRequests.isEmpty())
+        UBPersistenceManager::persistenceManager()->pagesAppended(document, thumbnailedImport.pageIndexes.first());
+
+    mThumbnailedImports.insert(pdfRenderer, thumbnailedImport);
+
+    connect(pdfRenderer, SIGNAL(thumbnailWritten(int)), this, SLOT(thumbnailWritten(int)));
+    connect(pdfRenderer, SIGNAL(thumbnailsWritten()), this, SLOT(thumbnailsWritten()));
+
+    pdfRenderer->writeThumbnails(thumbnailRequests, thumbnailWidth);
+
+    return thumbnailRequests.size();
+}
+
+void UBImportPDF::thumbnailWritten(int requestIndex)
+{
+    PDFRenderer* pdfRenderer = qobject_cast<PDFRenderer*>(sender());
+
+    if (!mThumbnailedImports.contains(pdfRenderer))
+        return;
+
+    const ThumbnailedImport& thumbnailedImport = mThumbnailedImports[pdfRenderer];
+
+    if (!thumbnailedImport.document || requestIndex < 0 || requestIndex >= thumbnailedImport.pageIndexes.size())
+        return;
+
+    int pageIndex = thumbnailedImport.pageIndexes.at(requestIndex);
+
+    UBDocumentContainer* containers[] = {UBApplication::boardController, UBApplication::documentController};
+
+    for (int i = 0; i < 2; i++)
+    {
+        UBDocumentContainer* container = containers[i];
+
+        if (container && container->selectedDocument() == thumbnailedImport.document && pageIndex < container->pageCount())
+            container->updatePage(pageIndex);
+    }
+}
+
+void UBImportPDF::thumbnailsWritten()
+{
+    PDFRenderer* pdfRenderer = qobject_cast<PDFRenderer*>(sender());
+
+    if (!mThumbnailedImports.contains(pdfRenderer))
+        return;
+
+    mThumbnailedImports.remove(pdfRenderer);
+
+    disconnect(pdfRenderer, 0, this, 0);
+    pdfRenderer->detach();
+}
+
 void UBImportPDF::placeImportedItemToScene(UBGraphicsScene* scene, UBGraphicsItem* item)
 {
     UBGraphicsPDFItem *pdfItem = (UBGraphicsPDFItem*)item;
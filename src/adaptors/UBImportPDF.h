@@ -34,6 +34,7 @@
 #include "UBImportAdaptor.h"
 
 class UBDocumentProxy;
+class PDFRenderer;
 
 class UBImportPDF : public UBPageBasedImportAdaptor
 {
@@ -50,8 +51,23 @@ class UBImportPDF : public UBPageBasedImportAdaptor
         virtual void placeImportedItemToScene(UBGraphicsScene* scene, UBGraphicsItem* item);
         virtual const QString& folderToCopy();
 
+        virtual int importPages(UBDocumentProxy* document, const QUuid& uuid, const QString& filePath);
+
+    private slots:
+        void thumbnailWritten(int requestIndex);
+        void thumbnailsWritten();
+
     private:
         int dpi;
+
+        struct ThumbnailedImport
+        {
+            QPointer<UBDocumentProxy> document;
+            QList<int> pageIndexes;
+        };
+
+        // imports whose thumbnails are still being rasterized, the renderers stay attached until done
+        QHash<PDFRenderer*, ThumbnailedImport> mThumbnailedImports;
 };
 
 #endif /* UBIMPORTPDF_H_ */
@@ -28,6 +28,7 @@
 
 
 #include "UBSvgSubsetAdaptor.h"
+#include "UBDocumentArchiveExtractor.h"
 
 #include <QtCore>
 #include <QtXml>
@@ -236,7 +237,7 @@ QString UBSvgSubsetAdaptor::uniboardDocumentNamespaceUriFromVersion(int mFileVer
 }
 
 
-UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int pageIndex)
+UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int pageIndex, bool waitForMedia)
 {
     QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
     qDebug() << fileName;
@@ -250,7 +251,7 @@ UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int
             return 0;
         }
 
-        UBGraphicsScene* scene = loadScene(proxy, file.readAll());
+        UBGraphicsScene* scene = loadScene(proxy, file.readAll(), waitForMedia);
 
         file.close();
 
@@ -263,7 +264,13 @@ UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const int
 
 QByteArray UBSvgSubsetAdaptor::loadSceneAsText(UBDocumentProxy* proxy, const int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    return loadSceneAsText(proxy->persistencePath(), pageIndex);
+}
+
+
+QByteArray UBSvgSubsetAdaptor::loadSceneAsText(const QString& persistencePath, const int pageIndex)
+{
+    QString fileName = persistencePath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
     qDebug() << fileName;
     QFile file(fileName);
 
@@ -286,7 +293,13 @@ QByteArray UBSvgSubsetAdaptor::loadSceneAsText(UBDocumentProxy* proxy, const int
 
 QUuid UBSvgSubsetAdaptor::sceneUuid(UBDocumentProxy* proxy, const int pageIndex)
 {
-    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    return sceneUuid(proxy->persistencePath(), pageIndex);
+}
+
+
+QUuid UBSvgSubsetAdaptor::sceneUuid(const QString& persistencePath, const int pageIndex)
+{
+    QString fileName = persistencePath + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
 
     QFile file(fileName);
 
@@ -331,10 +344,26 @@ QUuid UBSvgSubsetAdaptor::sceneUuid(UBDocumentProxy* proxy, const int pageIndex)
 }
 
 
-UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const QByteArray& pArray)
+UBGraphicsScene* UBSvgSubsetAdaptor::loadScene(UBDocumentProxy* proxy, const QByteArray& pArray, bool waitForMedia)
 {
+    UBDocumentArchiveExtractor* extractor = UBDocumentArchiveExtractor::extractor();
+
+    // media of an imported document may still be in its archive
+    bool mediaPending = false;
+
+    if (waitForMedia)
+        extractor->extractReferencedEntries(proxy->persistencePath(), pArray);
+    else
+        mediaPending = extractor->prioritizeReferencedEntries(proxy->persistencePath(), pArray);
+
     UBSvgSubsetReader reader(proxy, UBTextTools::cleanHtmlCData(QString(pArray)).toUtf8());
-    return reader.loadScene(proxy);
+    UBGraphicsScene* scene = reader.loadScene(proxy);
+
+    // the missing media show their placeholder until then
+    if (scene && mediaPending)
+        QObject::connect(extractor, SIGNAL(entryExtracted(QString)), scene, SLOT(mediaFileExtracted(QString)));
+
+    return scene;
 }
 
 UBSvgSubsetAdaptor::UBSvgSubsetReader::UBSvgSubsetReader(UBDocumentProxy* pProxy, const QByteArray& pXmlData)
@@ -1038,6 +1067,98 @@ void UBSvgSubsetAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* p
 }
 
 
+bool UBSvgSubsetAdaptor::persistPDFPageDescriptor(UBDocumentProxy* proxy, const int pageIndex, const QString& pdfFileName,
+                                                  int pdfPageNumber, const QSizeF& pdfPageSize)
+{
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+
+    QXmlStreamWriter xmlWriter(&buffer);
+    xmlWriter.setAutoFormatting(true);
+
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeDefaultNamespace(nsSvg);
+    xmlWriter.writeNamespace(nsXLink, "xlink");
+    xmlWriter.writeNamespace(UBSettings::uniboardDocumentNamespaceUri, "ub");
+    xmlWriter.writeNamespace(nsXHtml, "xhtml");
+
+    // same layout as a scene with the pdf page centered as background, see UBImportPDF::placeImportedItemToScene
+    QSize nominalSize = pdfPageSize.toSize();
+    QRectF pageRect(nominalSize.width() / -2., nominalSize.height() / -2., nominalSize.width(), nominalSize.height());
+    pageRect |= QRectF(QPointF(pdfPageSize.width() / -2, pdfPageSize.height() / -2), pdfPageSize);
+
+    bool isDark = UBSettings::settings()->isDarkBackground();
+
+    xmlWriter.writeStartElement("svg");
+    xmlWriter.writeAttribute("version", "1.1");
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "version", UBSettings::currentFileVersion);
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(QUuid::createUuid()));
+
+    int margin = UBSettings::settings()->svgViewBoxMargin->get().toInt();
+    QRect normalized = pageRect.toRect();
+    normalized.translate(margin * -1, margin * -1);
+    normalized.setWidth(normalized.width() + (margin * 2));
+    normalized.setHeight(normalized.height() + (margin * 2));
+    xmlWriter.writeAttribute("viewBox", QString("%1 %2 %3 %4").arg(normalized.x()).arg(normalized.y()).arg(normalized.width()).arg(normalized.height()));
+
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "nominal-size", QString("%1x%2").arg(nominalSize.width()).arg(nominalSize.height()));
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "dark-background", isDark ? xmlTrue : xmlFalse);
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "crossed-background", UBSettings::settings()->isCrossedBackground() ? xmlTrue : xmlFalse);
+
+    if (proxy->pageDpi() == 0)
+    {
+        QDesktopWidget* desktop = UBApplication::desktop();
+        proxy->setPageDpi((desktop->physicalDpiX() + desktop->physicalDpiY()) / 2);
+    }
+
+    xmlWriter.writeAttribute("pageDpi", QString::number(proxy->pageDpi()));
+
+    xmlWriter.writeStartElement("rect");
+    xmlWriter.writeAttribute("fill", isDark ? "black" : "white");
+    xmlWriter.writeAttribute("x", QString::number(normalized.x()));
+    xmlWriter.writeAttribute("y", QString::number(normalized.y()));
+    xmlWriter.writeAttribute("width", QString::number(normalized.width()));
+    xmlWriter.writeAttribute("height", QString::number(normalized.height()));
+    xmlWriter.writeEndElement();
+
+    xmlWriter.writeStartElement("foreignObject");
+    xmlWriter.writeAttribute("requiredExtensions", "http://ns.adobe.com/pdf/1.3/");
+    xmlWriter.writeAttribute(nsXLink, "href", pdfFileName + "#page=" + QString::number(pdfPageNumber));
+
+    xmlWriter.writeAttribute("x", "0");
+    xmlWriter.writeAttribute("y", "0");
+    xmlWriter.writeAttribute("width", QString("%1").arg(pdfPageSize.width()));
+    xmlWriter.writeAttribute("height", QString("%1").arg(pdfPageSize.height()));
+
+    QMatrix matrix;
+    matrix.translate(pdfPageSize.width() / -2, pdfPageSize.height() / -2);
+    xmlWriter.writeAttribute("transform", toSvgTransform(matrix));
+
+    QString zs;
+    zs.setNum(-1000000.0, 'f');
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "z-value", zs);
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "background", xmlTrue);
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "uuid", UBStringUtils::toCanonicalUuid(QUuid::createUuid()));
+    xmlWriter.writeAttribute(UBSettings::uniboardDocumentNamespaceUri, "layer", QString("%1").arg(UBItemLayerType::FixedBackground));
+    xmlWriter.writeEndElement();
+
+    xmlWriter.writeEndDocument();
+
+    QString fileName = proxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", pageIndex);
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "cannot open " << fileName << " for writing ...";
+        return false;
+    }
+    file.write(buffer.data());
+    file.close();
+
+    return true;
+}
+
+
 UBSvgSubsetAdaptor::UBSvgSubsetWriter::UBSvgSubsetWriter(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex)
     : mScene(pScene)
     , mDocumentPath(proxy->persistencePath())
@@ -1927,8 +2048,17 @@ UBGraphicsPixmapItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::pixmapItemFromSvg()
     if (!imageHref.isNull())
     {
         QString href = imageHref.toString();
-        QPixmap pix(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
-        pixmapItem->setPixmap(pix);
+
+        // decode at the size the image is displayed on the page, not at the size of the file
+        qreal displayScale = 1.0;
+        QStringRef svgTransform = mXmlReader.attributes().value("transform");
+        if (!svgTransform.isNull())
+        {
+            QMatrix itemMatrix = fromSvgTransform(svgTransform.toString());
+            displayScale = qSqrt(itemMatrix.m11() * itemMatrix.m11() + itemMatrix.m12() * itemMatrix.m12());
+        }
+
+        pixmapItem->setImageSource(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href), displayScale, true);
     }
     else
     {
@@ -1969,7 +2099,8 @@ UBGraphicsSvgItem* UBSvgSubsetAdaptor::UBSvgSubsetReader::svgItemFromSvg()
     {
         QString href = imageHref.toString();
 
-        svgItem = new UBGraphicsSvgItem(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
+        svgItem = new UBGraphicsSvgItem();
+        svgItem->loadAsynchronously(mDocumentPath + "/" + UBFileSystemUtils::normalizeFilePath(href));
     }
     else
     {
@@ -1995,18 +2126,12 @@ void UBSvgSubsetAdaptor::UBSvgSubsetWriter::pdfItemToLinkedPDF(UBGraphicsPDFItem
 
     if (!QFile::exists(path))
     {
-        QDir dir;
-        dir.mkdir(mDocumentPath + "/" + UBPersistenceManager::objectDirectory);
-
-        QFile file(path);
-        if (!file.open(QIODevice::WriteOnly))
+        // copied file to file, the pdf content is never loaded in memory
+        if (!UBFileSystemUtils::copyFile(pdfItem->fileName(), path))
         {
-            qWarning() << "cannot open file for writing embeded pdf content " << path;
+            qWarning() << "cannot copy embeded pdf content " << pdfItem->fileName() << "to" << path;
             return;
         }
-
-        file.write(pdfItem->fileData());
-        file.close();
     }
 
     mXmlWriter.writeAttribute(nsXLink, "href", fileName + "#page=" + QString::number(pdfItem->pageNumber()));
@@ -2261,7 +2386,7 @@ void UBSvgSubsetAdaptor::UBSvgSubsetReader::graphicsItemFromSvg(QGraphicsItem* g
         int layerAsInt = ubLayer.toString().toInt(&ok);
 
         if (ok)
-            gItem->setData(UBGraphicsItemData::ItemLayerType, QVariant(layerAsInt));
+            UBGraphicsItem::assignLayer(gItem, layerAsInt);
     }
 }
 
@@ -2998,7 +3123,7 @@ UBGraphicsTriangle* UBSvgSubsetAdaptor::UBSvgSubsetReader::triangleFromSvg()
 UBGraphicsCache* UBSvgSubsetAdaptor::UBSvgSubsetReader::cacheFromSvg()
 {
     UBGraphicsCache* pCache = UBGraphicsCache::instance(mScene);
-    pCache->setData(UBGraphicsItemData::ItemLayerType, QVariant(UBItemLayerType::Tool));
+    UBGraphicsItem::assignLayer(pCache, UBItemLayerType::Tool);
 
     graphicsItemFromSvg(pCache);
 
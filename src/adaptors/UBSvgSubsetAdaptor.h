@@ -69,14 +69,21 @@ class UBSvgSubsetAdaptor
 
     public:
 
-        static UBGraphicsScene* loadScene(UBDocumentProxy* proxy, const int pageIndex);
+        // a scene loaded for display shows the media of an imported document as they get extracted
+        static UBGraphicsScene* loadScene(UBDocumentProxy* proxy, const int pageIndex, bool waitForMedia = true);
         static QByteArray loadSceneAsText(UBDocumentProxy* proxy, const int pageIndex);
-        static UBGraphicsScene* loadScene(UBDocumentProxy* proxy, const QByteArray& pArray);
+        static QByteArray loadSceneAsText(const QString& persistencePath, const int pageIndex);
+        static UBGraphicsScene* loadScene(UBDocumentProxy* proxy, const QByteArray& pArray, bool waitForMedia = true);
 
         static void persistScene(UBDocumentProxy* proxy, UBGraphicsScene* pScene, const int pageIndex);
+
+        // writes a page holding only a pdf page as background, as the writer would, without building a scene
+        static bool persistPDFPageDescriptor(UBDocumentProxy* proxy, const int pageIndex, const QString& pdfFileName,
+                                             int pdfPageNumber, const QSizeF& pdfPageSize);
         static void upgradeScene(UBDocumentProxy* proxy, const int pageIndex);
 
         static QUuid sceneUuid(UBDocumentProxy* proxy, const int pageIndex);
+        static QUuid sceneUuid(const QString& persistencePath, const int pageIndex);
         static void setSceneUuid(UBDocumentProxy* proxy, const int pageIndex, QUuid pUuid);
 
         static void convertPDFObjectsToImages(UBDocumentProxy* proxy);
@@ -32,6 +32,7 @@
 #include <QtCore>
 
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBDecodingQueue.h"
 
 #include "core/UBPersistenceManager.h"
 #include "core/UBApplication.h"
@@ -155,6 +156,9 @@ void UBThumbnailAdaptor::persistScene(UBDocumentProxy* proxy, UBGraphicsScene* p
         pScene->setRenderingContext(UBGraphicsScene::NonScreen);
         pScene->setRenderingQuality(UBItem::RenderingQualityHigh);
 
+        // images of a freshly loaded page may still be decoding
+        UBDecodingQueue::queue()->waitForPendingDecodes(pScene);
+
         pScene->render(&painter, imageRect, sceneRect, Qt::KeepAspectRatio);
 
         pScene->setRenderingContext(UBGraphicsScene::Screen);
@@ -1,12 +1,15 @@
 
 HEADERS      += src/adaptors/UBExportAdaptor.h\
+                src/adaptors/UBExportQueue.h \
                 src/adaptors/UBExportPDF.h \
                 src/adaptors/UBExportFullPDF.h \
+                src/adaptors/UBExportSceneLoader.h \
                 src/adaptors/UBExportDocument.h \
                 src/adaptors/UBSvgSubsetAdaptor.h \
                 src/adaptors/UBMetadataDcSubsetAdaptor.h \
                 src/adaptors/UBImportAdaptor.h \
                 src/adaptors/UBImportDocument.h \
+                src/adaptors/UBDocumentArchiveExtractor.h \
                 src/adaptors/UBThumbnailAdaptor.h \
                 src/adaptors/UBImportPDF.h \
                 src/adaptors/UBImportImage.h \
@@ -16,13 +19,16 @@ HEADERS      += src/adaptors/UBExportAdaptor.h\
 
 
 SOURCES      += src/adaptors/UBExportAdaptor.cpp\
+                src/adaptors/UBExportQueue.cpp \
                 src/adaptors/UBExportPDF.cpp \
                 src/adaptors/UBExportFullPDF.cpp \
+                src/adaptors/UBExportSceneLoader.cpp \
                 src/adaptors/UBExportDocument.cpp \
                 src/adaptors/UBSvgSubsetAdaptor.cpp \
                 src/adaptors/UBMetadataDcSubsetAdaptor.cpp \
                 src/adaptors/UBImportAdaptor.cpp \
                 src/adaptors/UBImportDocument.cpp \
+                src/adaptors/UBDocumentArchiveExtractor.cpp \
                 src/adaptors/UBThumbnailAdaptor.cpp \
                 src/adaptors/UBImportPDF.cpp \
                 src/adaptors/UBImportImage.cpp \
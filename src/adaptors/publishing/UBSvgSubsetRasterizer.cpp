@@ -32,6 +32,8 @@
 #include "domain/UBGraphicsScene.h"
 #include "adaptors/UBSvgSubsetAdaptor.h"
 
+#include "frameworks/UBDecodingQueue.h"
+
 #include "core/memcheck.h"
 
 UBSvgSubsetRasterizer::UBSvgSubsetRasterizer(UBDocumentProxy* document, int pageIndex, QObject* parent)
@@ -87,6 +89,8 @@ bool UBSvgSubsetRasterizer::rasterizeToFile(const QString& filename)
     scene->setRenderingQuality(UBItem::RenderingQualityHigh);
     scene->setRenderingContext(UBGraphicsScene::NonScreen);
 
+    UBDecodingQueue::queue()->waitForPendingDecodes(scene);
+
     scene->render(&painter, imageRect, sceneRect, Qt::KeepAspectRatio);
 
     scene->setRenderingQuality(UBItem::RenderingQualityNormal);
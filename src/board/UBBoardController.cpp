@@ -39,6 +39,7 @@
 #include "core/UBSettings.h"
 #include "core/UBSetting.h"
 #include "core/UBPersistenceManager.h"
+#include "core/UBMediaStore.h"
 #include "core/UBApplicationController.h"
 #include "core/UBDocumentManager.h"
 #include "core/UBMimeData.h"
@@ -82,6 +83,7 @@
 
 #include "adaptors/UBMetadataDcSubsetAdaptor.h"
 #include "adaptors/UBSvgSubsetAdaptor.h"
+#include "adaptors/UBExportQueue.h"
 
 #include "UBBoardPaletteManager.h"
 
@@ -134,10 +136,10 @@ void UBBoardController::init()
     setupViews();
     setupToolbar();
 
-    connect(UBApplication::undoStack, SIGNAL(canUndoChanged(bool))
+    connect(UBApplication::undoGroup, SIGNAL(canUndoChanged(bool))
             , this, SLOT(undoRedoStateChange(bool)));
 
-    connect(UBApplication::undoStack, SIGNAL(canRedoChanged (bool))
+    connect(UBApplication::undoGroup, SIGNAL(canRedoChanged (bool))
             , this, SLOT(undoRedoStateChange(bool)));
 
     connect(UBDrawingController::drawingController(), SIGNAL(stylusToolChanged(int))
@@ -376,8 +378,8 @@ void UBBoardController::connectToolbar()
     connect(mMainWindow->actionEraseAnnotations, SIGNAL(triggered()), this, SLOT(clearSceneAnnotation()));
     connect(mMainWindow->actionEraseBackground,SIGNAL(triggered()),this,SLOT(clearSceneBackground()));
 
-    connect(mMainWindow->actionUndo, SIGNAL(triggered()), UBApplication::undoStack, SLOT(undo()));
-    connect(mMainWindow->actionRedo, SIGNAL(triggered()), UBApplication::undoStack, SLOT(redo()));
+    connect(mMainWindow->actionUndo, SIGNAL(triggered()), UBApplication::undoGroup, SLOT(undo()));
+    connect(mMainWindow->actionRedo, SIGNAL(triggered()), UBApplication::undoGroup, SLOT(redo()));
     connect(mMainWindow->actionRedo, SIGNAL(triggered()), this, SLOT(startScript()));
     connect(mMainWindow->actionBack, SIGNAL( triggered()), this, SLOT(previousScene()));
     connect(mMainWindow->actionForward, SIGNAL(triggered()), this, SLOT(nextScene()));
@@ -483,6 +485,9 @@ void UBBoardController::stylusToolDoubleClicked(int tool)
 
 void UBBoardController::addScene()
 {
+    if (UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
+        return;
+
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
     persistCurrentScene(false,true);
 
@@ -496,7 +501,7 @@ void UBBoardController::addScene()
 
 void UBBoardController::addScene(UBGraphicsScene* scene, bool replaceActiveIfEmpty)
 {
-    if (scene)
+    if (scene && !UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
     {
         UBGraphicsScene* clone = scene->sceneDeepCopy();
 
@@ -509,12 +514,8 @@ void UBBoardController::addScene(UBGraphicsScene* scene, bool replaceActiveIfEmp
 
                 if(QFileInfo(source).isDir())
                     UBFileSystemUtils::copyDir(source,target);
-                else{
-                    QFileInfo fi(target);
-                    QDir d = fi.dir();
-                    d.mkpath(d.absolutePath());
-                    QFile::copy(source, target);
-                }
+                else
+                    UBMediaStore::shareFile(source, target);
             }
         }
 
@@ -548,6 +549,9 @@ void UBBoardController::addScene(UBDocumentProxy* proxy, int sceneIndex, bool re
 
 void UBBoardController::duplicateScene(int nIndex)
 {
+    if (UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
+        return;
+
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
     persistCurrentScene(false,true);
 
@@ -652,7 +656,7 @@ UBGraphicsItem *UBBoardController::duplicateItem(UBItem *item)
                  QBuffer buffer(&pData);
                  buffer.open(QIODevice::WriteOnly);
                  QString format = UBFileSystemUtils::extension(item->sourceUrl().toString(QUrl::DecodeReserved));
-                 pixitem->pixmap().save(&buffer, format.toLatin1());
+                 pixitem->fullResolutionPixmap().save(&buffer, format.toLatin1());
             }
         }break;
 
@@ -734,7 +738,7 @@ UBGraphicsItem *UBBoardController::duplicateItem(UBItem *item)
 
 void UBBoardController::deleteScene(int nIndex)
 {
-    if (selectedDocument()->pageCount()>=2)
+    if (selectedDocument()->pageCount()>=2 && !UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
     {
         mDeletingSceneIndex = nIndex;
         QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
@@ -1509,10 +1513,11 @@ void UBBoardController::setActiveDocumentScene(UBDocumentProxy* pDocumentProxy,
 
         persistCurrentScene();
 
-        ClearUndoStack();
-
         mActiveScene = targetScene;
         mActiveSceneIndex = index;
+
+        UBApplication::setActiveUndoStack(mActiveScene->undoStack());
+        keepUndoHistory(mActiveScene);
         setDocument(pDocumentProxy, forceReload);
 
         updateSystemScaleFactor();
@@ -1547,7 +1552,7 @@ void UBBoardController::setActiveDocumentScene(UBDocumentProxy* pDocumentProxy,
 
 void UBBoardController::moveSceneToIndex(int source, int target)
 {
-    if (selectedDocument())
+    if (selectedDocument() && !UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
     {
 
         persistCurrentScene(false,true);
@@ -1563,96 +1568,52 @@ void UBBoardController::moveSceneToIndex(int source, int target)
     }
 }
 
-void UBBoardController::findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem*> &itms)
+void UBBoardController::keepUndoHistory(UBGraphicsScene* scene)
 {
-    if (parent->childCount()) {
-        for (int i = 0; i < parent->childCount(); i++) {
-            findUniquesItems(parent->child(i), itms);
-        }
-    }
-
-    // Undo command transaction macros. Process separatedly
-    if (parent->text() == UBSettings::undoCommandTransactionName) {
-        return;
-    }
-
-    const UBUndoCommand *undoCmd = static_cast<const UBUndoCommand*>(parent);
-    if(undoCmd->getType() != UBUndoType::undotype_GRAPHICITEM)
-        return;
+    // most recently visited pages first
+    mUndoHistoryScenes.removeAll(QPointer<UBGraphicsScene>(scene));
+    mUndoHistoryScenes.removeAll(QPointer<UBGraphicsScene>());
+    mUndoHistoryScenes.prepend(QPointer<UBGraphicsScene>(scene));
 
-    const UBGraphicsItemUndoCommand *cmd = dynamic_cast<const UBGraphicsItemUndoCommand*>(parent);
+    int maxPages = qMax(1, UBSettings::settings()->undoHistoryPagesPerDocument->get().toInt());
+    qint64 maxBytes = (qint64)qMax(0, UBSettings::settings()->undoHistoryMegabytesPerDocument->get().toInt()) * 1024 * 1024;
+    int pages = 0;
+    qint64 bytes = 0;
 
-    // go through all added and removed objects, for create list of unique objects
-    // grouped items will be deleted by groups, so we don't need do delete that items.
-    QSetIterator<QGraphicsItem*> itAdded(cmd->GetAddedList());
-    while (itAdded.hasNext())
+    for (int i = 0; i < mUndoHistoryScenes.count(); )
     {
-        QGraphicsItem* item = itAdded.next();
-        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
-            itms.insert(item);
-    }
+        UBGraphicsScene* historyScene = mUndoHistoryScenes.at(i);
+        if (historyScene->document() != scene->document())
+        {
+            i++;
+            continue;
+        }
 
-    QSetIterator<QGraphicsItem*> itRemoved(cmd->GetRemovedList());
-    while (itRemoved.hasNext())
-    {
-        QGraphicsItem* item = itRemoved.next();
-        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
-            itms.insert(item);
+        pages++;
+        bytes += historyScene->undoHistorySize();
+
+        // the least recently visited pages lose their history first, the current one never does
+        if (historyScene != scene && (pages > maxPages || bytes > maxBytes))
+        {
+            historyScene->clearUndoHistory();
+            mUndoHistoryScenes.removeAt(i);
+        }
+        else
+            i++;
     }
 }
 
 void UBBoardController::ClearUndoStack()
 {
-    QSet<QGraphicsItem*> uniqueItems;
-    // go through all stack command
-    for (int i = 0; i < UBApplication::undoStack->count(); i++) {
-        findUniquesItems(UBApplication::undoStack->command(i), uniqueItems);
-    }
-
-    // Get items from clipboard in order not to delete an item that was cut
-    // (using source URL of graphics items as a surrogate for equality testing)
-    // This ensures that we can cut and paste a media item, widget, etc. from one page to the next.
-    QClipboard *clipboard = QApplication::clipboard();
-    const QMimeData* data = clipboard->mimeData();
-    QList<QUrl> sourceURLs;
-
-    if (data && data->hasFormat(UBApplication::mimeTypeUniboardPageItem)) {
-        const UBMimeDataGraphicsItem* mimeDataGI = qobject_cast <const UBMimeDataGraphicsItem*>(data);
-
-        if (mimeDataGI) {
-            foreach (UBItem* sourceItem, mimeDataGI->items()) {
-                sourceURLs << sourceItem->sourceUrl();
-            }
-        }
-    }
-
-    // go through all unique items, and check, if they are on scene, or not.
-    // if not on scene, than item can be deleted
-    QSetIterator<QGraphicsItem*> itUniq(uniqueItems);
-    while (itUniq.hasNext())
+    foreach(QPointer<UBGraphicsScene> scene, mUndoHistoryScenes)
     {
-        QGraphicsItem* item = itUniq.next();
-        UBGraphicsScene *scene = NULL;
-        if (item->scene()) {
-            scene = dynamic_cast<UBGraphicsScene*>(item->scene());
-        }
-
-        bool inClipboard = false;
-        UBItem* ubi = dynamic_cast<UBItem*>(item);
-        if (ubi && sourceURLs.contains(ubi->sourceUrl()))
-            inClipboard = true;
-
-        if(!scene && !inClipboard)
-        {
-            if (!mActiveScene->deleteItem(item)){
-                delete item;
-                item = 0;
-            }
-        }
+        if (scene)
+            scene->clearUndoHistory();
     }
+    mUndoHistoryScenes.clear();
 
-    // clear stack, and command list
-    UBApplication::undoStack->clear();
+    if (mActiveScene)
+        mActiveScene->clearUndoHistory();
 }
 
 void UBBoardController::adjustDisplayViews()
@@ -1759,8 +1720,8 @@ void UBBoardController::undoRedoStateChange(bool canUndo)
 {
     Q_UNUSED(canUndo);
 
-    mMainWindow->actionUndo->setEnabled(UBApplication::undoStack->canUndo());
-    mMainWindow->actionRedo->setEnabled(UBApplication::undoStack->canRedo());
+    mMainWindow->actionUndo->setEnabled(UBApplication::undoGroup->canUndo());
+    mMainWindow->actionRedo->setEnabled(UBApplication::undoGroup->canRedo());
 
     updateActionStates();
 }
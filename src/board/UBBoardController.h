@@ -175,7 +175,6 @@ class UBBoardController : public UBDocumentContainer
         void notifyPageChanged();
         void displayMetaData(QMap<QString, QString> metadatas);
 
-        void findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem *> &itms);
         void ClearUndoStack();
 
         void setActiveDocumentScene(UBDocumentProxy* pDocumentProxy, int pSceneIndex = 0, bool forceReload = false);
@@ -288,10 +287,12 @@ class UBBoardController : public UBDocumentContainer
         void saveViewState();
         void adjustDisplayViews();
         int autosaveTimeoutFromSettings();
+        void keepUndoHistory(UBGraphicsScene* scene);
 
         UBMainWindow *mMainWindow;
         UBGraphicsScene* mActiveScene;
         int mActiveSceneIndex;
+        QList<QPointer<UBGraphicsScene> > mUndoHistoryScenes;
         UBBoardPaletteManager *mPaletteManager;
         UBSoftwareUpdateDialog *mSoftwareUpdateDialog;
         UBMessageWindow *mMessageWindow;
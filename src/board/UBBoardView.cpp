@@ -72,6 +72,7 @@
 #include "domain/UBGraphicsSvgItem.h"
 #include "domain/UBGraphicsGroupContainerItem.h"
 #include "domain/UBGraphicsStrokesGroup.h"
+#include "domain/UBBackgroundGrid.h"
 #include "domain/UBGraphicsItemDelegate.h"
 
 #include "document/UBDocumentProxy.h"
@@ -1513,31 +1514,39 @@ void UBBoardView::leaveEvent (QEvent * event)
     QGraphicsView::leaveEvent (event);
 }
 
+bool UBBoardView::shouldDisplayItem(UBGraphicsScene *scene, QGraphicsItem *item)
+{
+    int itemLayerType;
+    return scene->itemLayer(item, itemLayerType) && (itemLayerType >= mStartLayer && itemLayerType <= mEndLayer);
+}
+
 void UBBoardView::drawItems (QPainter *painter, int numItems, QGraphicsItem* items[], const QStyleOptionGraphicsItem options[])
 {
-    if (!mFilterZIndex)
+    UBGraphicsScene *ubScene = scene ();
+
+    if (!mFilterZIndex || !ubScene)
         QGraphicsView::drawItems (painter, numItems, items, options);
     else
     {
-        int count = 0;
+        if (mFilteredItems.size() < numItems)
+        {
+            mFilteredItems.resize(numItems);
+            mFilteredOptions.resize(numItems);
+        }
 
-        QGraphicsItem** itemsFiltered = new QGraphicsItem*[numItems];
-        QStyleOptionGraphicsItem *optionsFiltered = new QStyleOptionGraphicsItem[numItems];
+        int count = 0;
 
         for (int i = 0; i < numItems; i++)
         {
-            if (shouldDisplayItem (items[i]))
+            if (shouldDisplayItem (ubScene, items[i]))
             {
-                itemsFiltered[count] = items[i];
-                optionsFiltered[count] = options[i];
+                mFilteredItems[count] = items[i];
+                mFilteredOptions[count] = options[i];
                 count++;
             }
         }
 
-        QGraphicsView::drawItems (painter, count, itemsFiltered, optionsFiltered);
-
-        delete[] optionsFiltered;
-        delete[] itemsFiltered;
+        QGraphicsView::drawItems (painter, count, mFilteredItems.data(), mFilteredOptions.constData());
     }
 }
 
@@ -1590,50 +1599,9 @@ void UBBoardView::drawBackground (QPainter *painter, const QRectF &rect)
     }
 
     bool darkBackground = scene () && scene ()->isDarkBackground ();
+    bool crossedBackground = scene () && scene ()->isCrossedBackground ();
 
-    if (darkBackground)
-    {
-        painter->fillRect (rect, QBrush (QColor (Qt::black)));
-    }
-    else
-    {
-        painter->fillRect (rect, QBrush (QColor (Qt::white)));
-    }
-
-    if (transform ().m11 () > 0.5)
-    {
-        QColor bgCrossColor;
-
-        if (darkBackground)
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
-        else
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
-
-        if (transform ().m11 () < 1.0)
-        {
-            int alpha = 255 * transform ().m11 () / 2;
-            bgCrossColor.setAlpha (alpha); // fade the crossing on small zooms
-        }
-
-        painter->setPen (bgCrossColor);
-
-        if (scene () && scene ()->isCrossedBackground ())
-        {
-            qreal firstY = ((int) (rect.y () / UBSettings::crossSize)) * UBSettings::crossSize;
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += UBSettings::crossSize)
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            qreal firstX = ((int) (rect.x () / UBSettings::crossSize)) * UBSettings::crossSize;
-
-            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += UBSettings::crossSize)
-            {
-                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-            }
-        }
-    }
+    UBBackgroundGrid::grid()->draw(painter, rect, darkBackground, crossedBackground, transform ().m11 ());
 
     if (!mFilterZIndex && scene ())
     {
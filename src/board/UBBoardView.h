@@ -118,12 +118,7 @@ private:
 
     void init();
 
-    inline bool shouldDisplayItem(QGraphicsItem *item)
-    {
-        bool ok;
-        int itemLayerType = item->data(UBGraphicsItemData::ItemLayerType).toInt(&ok);
-        return (ok && (itemLayerType >= mStartLayer && itemLayerType <= mEndLayer));
-    }
+    bool shouldDisplayItem(UBGraphicsScene *scene, QGraphicsItem *item);
 
     QList<QUrl> processMimeData(const QMimeData* pMimeData);
 
@@ -132,6 +127,10 @@ private:
     int mStartLayer, mEndLayer;
     bool mFilterZIndex;
 
+    // reused between frames by drawItems, they only grow
+    QVector<QGraphicsItem*> mFilteredItems;
+    QVector<QStyleOptionGraphicsItem> mFilteredOptions;
+
     bool mTabletStylusIsPressed;
     bool mUsingTabletEraser;
 
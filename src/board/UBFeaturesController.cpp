@@ -64,27 +64,20 @@ const QString UBFeaturesController::webSearchPath = rootPath + "/Web search";
 
 void UBFeaturesComputingThread::scanFS(const QUrl & currentPath, const QString & currVirtualPath, const QSet<QUrl> &pFavoriteSet)
 {
-//    Q_ASSERT(QFileInfo(currentPath.toLocalFile()).exists());
-//    if(QFileInfo(currentPath.toLocalFile()).exists())
-//        return;
+    QString dirPath = QDir(currentPath.toLocalFile()).absolutePath();
+    QList<QPair<QString, int> > entries = directoryEntries(dirPath);
 
-    QFileInfoList fileInfoList = UBFileSystemUtils::allElementsInDirectory(currentPath.toLocalFile());
-
-    QFileInfoList::iterator fileInfo;
-    for ( fileInfo = fileInfoList.begin(); fileInfo != fileInfoList.end(); fileInfo +=  1) {
+    for (int i = 0; i < entries.count(); i++) {
         if (abort) {
             return;
         }
 
-        QString fullFileName = fileInfo->absoluteFilePath();
-        UBFeatureElementType featureType = UBFeaturesController::fileTypeFromUrl(fullFileName);
-        QString fileName = fileInfo->fileName();
+        QString fileName = entries.at(i).first;
+        QString fullFileName = dirPath + "/" + fileName;
+        UBFeatureElementType featureType = (UBFeatureElementType)entries.at(i).second;
 
         QImage icon = UBFeaturesController::getIcon(fullFileName, featureType);
 
-        if ( fullFileName.contains(".thumbnail."))
-            continue;
-
         UBFeature testFeature(currVirtualPath + "/" + fileName, icon, fileName, QUrl::fromLocalFile(fullFileName), featureType);
 
         emit sendFeature(testFeature);
@@ -119,19 +112,18 @@ int UBFeaturesComputingThread::featuresCount(const QUrl &pPath)
 {
     int noItems = 0;
 
-    QFileInfoList fileInfoList = UBFileSystemUtils::allElementsInDirectory(pPath.toLocalFile());
+    QString dirPath = QDir(pPath.toLocalFile()).absolutePath();
+    QList<QPair<QString, int> > entries = directoryEntries(dirPath);
 
-    QFileInfoList::iterator fileInfo;
-    for ( fileInfo = fileInfoList.begin(); fileInfo != fileInfoList.end(); fileInfo +=  1) {
-        QString fullFileName = fileInfo->absoluteFilePath();
-        UBFeatureElementType featureType = UBFeaturesController::fileTypeFromUrl(fullFileName);
+    for (int i = 0; i < entries.count(); i++) {
+        UBFeatureElementType featureType = (UBFeatureElementType)entries.at(i).second;
 
-        if (featureType != FEATURE_INVALID && !fullFileName.contains(".thumbnail.")) {
+        if (featureType != FEATURE_INVALID) {
             noItems++;
         }
 
         if (featureType == FEATURE_FOLDER) {
-            noItems += featuresCount(QUrl::fromLocalFile(fullFileName));
+            noItems += featuresCount(QUrl::fromLocalFile(dirPath + "/" + entries.at(i).first));
         }
     }
 
@@ -149,11 +141,152 @@ int UBFeaturesComputingThread::featuresCountAll(QList<QPair<QUrl, UBFeature> > p
     return noItems;
 }
 
+QList<QPair<QString, int> > UBFeaturesComputingThread::directoryEntries(const QString &pDirPath)
+{
+    mScannedDirectories.insert(pDirPath);
+
+    // adding, removing or renaming an entry changes the modification time of its directory
+    qint64 modified = QFileInfo(pDirPath).lastModified().toMSecsSinceEpoch();
+
+    QHash<QString, UBFeaturesDirectoryIndex>::const_iterator cached = mIndex.constFind(pDirPath);
+    if (cached != mIndex.constEnd() && cached->modified == modified) {
+        return cached->entries;
+    }
+
+    UBFeaturesDirectoryIndex directoryIndex;
+    directoryIndex.modified = modified;
+
+    QFileInfoList fileInfoList = UBFileSystemUtils::allElementsInDirectory(pDirPath);
+
+    QFileInfoList::iterator fileInfo;
+    for ( fileInfo = fileInfoList.begin(); fileInfo != fileInfoList.end(); fileInfo +=  1) {
+        QString fullFileName = fileInfo->absoluteFilePath();
+
+        if ( fullFileName.contains(".thumbnail."))
+            continue;
+
+        directoryIndex.entries << QPair<QString, int>(fileInfo->fileName(), UBFeaturesController::fileTypeFromUrl(fullFileName));
+    }
+
+    mIndex.insert(pDirPath, directoryIndex);
+    mIndexModified = true;
+
+    return directoryIndex.entries;
+}
+
+static const quint32 featuresIndexMagic = 0x55424649; // "UBFI"
+static const quint32 featuresIndexVersion = 1;
+
+static QString featuresIndexPath()
+{
+    return UBSettings::userCacheDirectory() + "/features.index";
+}
+
+void UBFeaturesComputingThread::loadIndex()
+{
+    mIndexLoaded = true;
+
+    QFile indexFile(featuresIndexPath());
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&indexFile);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != featuresIndexMagic || version != featuresIndexVersion) {
+        return;
+    }
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString dirPath;
+        UBFeaturesDirectoryIndex directoryIndex;
+        stream >> dirPath >> directoryIndex.modified >> directoryIndex.entries;
+        mIndex.insert(dirPath, directoryIndex);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "discarding corrupted feature index" << indexFile.fileName();
+        mIndex.clear();
+    }
+}
+
+void UBFeaturesComputingThread::saveIndex()
+{
+    // directories that were not reached anymore have been removed or moved away
+    QHash<QString, UBFeaturesDirectoryIndex>::iterator it = mIndex.begin();
+    while (it != mIndex.end()) {
+        if (mScannedDirectories.contains(it.key())) {
+            ++it;
+        } else {
+            it = mIndex.erase(it);
+            mIndexModified = true;
+        }
+    }
+
+    if (!mIndexModified) {
+        return;
+    }
+
+    QSaveFile indexFile(featuresIndexPath());
+    if (!indexFile.open(QIODevice::WriteOnly)) {
+        qWarning() << "cannot write feature index" << indexFile.fileName();
+        return;
+    }
+
+    QDataStream stream(&indexFile);
+    stream << featuresIndexMagic << featuresIndexVersion << (quint32)mIndex.count();
+
+    for (it = mIndex.begin(); it != mIndex.end(); ++it) {
+        stream << it.key() << it->modified << it->entries;
+    }
+
+    if (indexFile.commit()) {
+        mIndexModified = false;
+    }
+}
+
+void UBFeaturesComputingThread::pruneThumbnailCache()
+{
+    // an edited, moved or deleted picture leaves its old thumbnail behind, only keep
+    // the ones of the pictures the scan has just indexed
+    QSet<QString> usedNames;
+
+    QHash<QString, UBFeaturesDirectoryIndex>::const_iterator it;
+    for (it = mIndex.constBegin(); it != mIndex.constEnd(); ++it) {
+        for (int i = 0; i < it->entries.count(); i++) {
+            if (it->entries.at(i).second == FEATURE_IMAGE) {
+                usedNames.insert(UBFeaturesController::thumbnailCacheName(it.key() + "/" + it->entries.at(i).first));
+            }
+        }
+    }
+
+    QDir cacheDir(UBSettings::userThumbnailCacheDirectory());
+    int removedCount = 0;
+
+    foreach (const QString &name, cacheDir.entryList(QStringList() << "*.png", QDir::Files)) {
+        if (abort) {
+            return;
+        }
+        if (!usedNames.contains(name) && cacheDir.remove(name)) {
+            removedCount++;
+        }
+    }
+
+    if (removedCount > 0) {
+        qDebug() << "removed" << removedCount << "stale library thumbnails";
+    }
+}
+
 UBFeaturesComputingThread::UBFeaturesComputingThread(QObject *parent) :
 QThread(parent)
 {
     restart = false;
     abort = false;
+    mIndexLoaded = false;
+    mIndexModified = false;
 }
 
 void UBFeaturesComputingThread::compute(const QList<QPair<QUrl, UBFeature> > &pScanningData, QSet<QUrl> *pFavoritesSet)
@@ -188,6 +321,11 @@ void UBFeaturesComputingThread::run()
             break;
         }
 
+        if (!mIndexLoaded) {
+            loadIndex();
+        }
+        mScannedDirectories.clear();
+
 //        QTime curTime = QTime::currentTime();
         int fsCnt = featuresCountAll(searchData);
 //        int msecsto = curTime.msecsTo(QTime::currentTime());
@@ -199,6 +337,10 @@ void UBFeaturesComputingThread::run()
 //        curTime = QTime::currentTime();
         scanAll(searchData, favoriteSet);
 //        qDebug() << "Time on finishing" << curTime.msecsTo(QTime::currentTime());
+        if (!abort) {
+            saveIndex();
+            pruneThumbnailCache();
+        }
         emit scanFinished();
 
         mMutex.lock();
@@ -310,6 +452,9 @@ bool UBFeature::inTrash() const
 
 UBFeaturesController::UBFeaturesController(QWidget *pParentWidget) :
     QObject(pParentWidget)
+    ,mLibraryWatcher(0)
+    ,mRescanTimer(0)
+    ,mScanning(false)
     ,featuresList(0)
     ,mLastItemOffsetIndex(0)
 {
@@ -373,6 +518,16 @@ UBFeaturesController::UBFeaturesController(QWidget *pParentWidget) :
     connect(&mCThread, SIGNAL(scanPath(QString)), this, SIGNAL(scanPath(QString)));
     connect(UBApplication::boardController, SIGNAL(npapiWidgetCreated(QString)), this, SLOT(createNpApiFeature(QString)));
 
+    mLibraryWatcher = new QFileSystemWatcher(this);
+    mRescanTimer = new QTimer(this);
+    mRescanTimer->setSingleShot(true);
+    mRescanTimer->setInterval(500);
+
+    connect(&mCThread, SIGNAL(scanStarted()), this, SLOT(onScanStarted()));
+    connect(&mCThread, SIGNAL(scanFinished()), this, SLOT(watchLibraryDirectories()));
+    connect(mLibraryWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(libraryDirectoryChanged(QString)));
+    connect(mRescanTimer, SIGNAL(timeout()), this, SLOT(rescanChangedDirectories()));
+
     QTimer::singleShot(0, this, SLOT(startThread()));
 }
 
@@ -397,9 +552,186 @@ void UBFeaturesController::startThread()
             <<  QPair<QUrl, UBFeature>(trashDirectoryPath, trashElement)
             <<  QPair<QUrl, UBFeature>(mLibSearchDirectoryPath, webSearchElement);
 
+    mScanningRoots = computingData;
+
+    // the thread only reports the start once it has counted the files, a rescan
+    // triggered before that would race the model it is about to fill
+    mScanning = true;
     mCThread.compute(computingData, favoriteSet);
 }
 
+void UBFeaturesController::onScanStarted()
+{
+    mScanning = true;
+}
+
+void UBFeaturesController::watchLibraryDirectories()
+{
+    mScanning = false;
+
+    QStringList directories;
+
+    for (int i = 0; i < mScanningRoots.count(); i++) {
+        QString rootPath = mScanningRoots.at(i).first.toLocalFile();
+        if (!rootPath.isEmpty() && QFileInfo(rootPath).isDir()) {
+            directories << QDir(rootPath).absolutePath();
+        }
+    }
+
+    foreach (UBFeature feature, *featuresList) {
+        if (feature.getType() == FEATURE_FOLDER && feature.getVirtualPath() != favoritePath) {
+            directories << feature.getFullPath().toLocalFile();
+        }
+    }
+
+    QStringList watched = mLibraryWatcher->directories();
+    QStringList toWatch;
+    foreach (QString directory, directories) {
+        if (!watched.contains(directory) && !toWatch.contains(directory)) {
+            toWatch << directory;
+        }
+    }
+
+    if (!toWatch.isEmpty()) {
+        mLibraryWatcher->addPaths(toWatch);
+    }
+
+    // changes reported while the scan was running
+    if (!mChangedDirectories.isEmpty()) {
+        mRescanTimer->start();
+    }
+}
+
+void UBFeaturesController::libraryDirectoryChanged(const QString &path)
+{
+    // several notifications come for a single copy, they are handled together
+    mChangedDirectories.insert(QDir(path).absolutePath());
+    mRescanTimer->start();
+}
+
+void UBFeaturesController::rescanChangedDirectories()
+{
+    // the model is being filled by the scanning thread, wait for it
+    if (mScanning) {
+        return;
+    }
+
+    QSet<QString> changedDirectories = mChangedDirectories;
+    mChangedDirectories.clear();
+
+    foreach (QString dirPath, changedDirectories) {
+        rescanDirectory(dirPath);
+    }
+
+    refreshModels();
+}
+
+QString UBFeaturesController::virtualPathForDirectory(const QString &dirPath) const
+{
+    for (int i = 0; i < mScanningRoots.count(); i++) {
+        if (QDir(mScanningRoots.at(i).first.toLocalFile()).absolutePath() == dirPath) {
+            return mScanningRoots.at(i).second.getFullVirtualPath();
+        }
+    }
+
+    foreach (UBFeature feature, *featuresList) {
+        if (feature.getType() == FEATURE_FOLDER && feature.getVirtualPath() != favoritePath
+                && feature.getFullPath().toLocalFile() == dirPath) {
+            return feature.getFullVirtualPath();
+        }
+    }
+
+    return QString();
+}
+
+void UBFeaturesController::rescanDirectory(const QString &dirPath)
+{
+    QString virtualPath = virtualPathForDirectory(dirPath);
+    if (virtualPath.isEmpty()) {
+        return;
+    }
+
+    // what the model shows for this directory, favorites are kept as they are
+    QSet<QString> shownFiles;
+    foreach (UBFeature feature, *featuresList) {
+        QString filePath = feature.getFullPath().toLocalFile();
+        if (!filePath.isEmpty() && feature.getVirtualPath() != favoritePath
+                && QFileInfo(filePath).absolutePath() == dirPath) {
+            shownFiles.insert(filePath);
+        }
+    }
+
+    QSet<QString> currentFiles;
+    QFileInfoList fileInfoList = UBFileSystemUtils::allElementsInDirectory(dirPath);
+
+    QFileInfoList::iterator fileInfo;
+    for ( fileInfo = fileInfoList.begin(); fileInfo != fileInfoList.end(); fileInfo +=  1) {
+        QString fullFileName = fileInfo->absoluteFilePath();
+        if ( fullFileName.contains(".thumbnail."))
+            continue;
+
+        currentFiles.insert(fullFileName);
+
+        if (shownFiles.contains(fullFileName))
+            continue;
+
+        QString fileName = fileInfo->fileName();
+        UBFeatureElementType featureType = fileTypeFromUrl(fullFileName);
+        QImage icon = getIcon(fullFileName, featureType);
+
+        featuresModel->addItem(UBFeature(virtualPath + "/" + fileName, icon, fileName, QUrl::fromLocalFile(fullFileName), featureType));
+
+        if (favoriteSet->find(QUrl::fromLocalFile(fullFileName)) != favoriteSet->end()) {
+            featuresModel->addItem(UBFeature(favoritePath + "/" + fileName, icon, fileName, QUrl::fromLocalFile(fullFileName), featureType));
+        }
+
+        if (featureType == FEATURE_FOLDER) {
+            addDirectoryContent(fullFileName, virtualPath + "/" + fileName);
+        }
+    }
+
+    QStringList removedFiles = (shownFiles - currentFiles).toList();
+    if (!removedFiles.isEmpty()) {
+        for (int i = featuresList->count() - 1; i >= 0; i--) {
+            const UBFeature &feature = featuresList->at(i);
+            if (feature.getVirtualPath() == favoritePath) {
+                continue;
+            }
+
+            QString filePath = feature.getFullPath().toLocalFile();
+            foreach (QString removedFile, removedFiles) {
+                if (filePath == removedFile || filePath.startsWith(removedFile + "/")) {
+                    featuresModel->removeRow(i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void UBFeaturesController::addDirectoryContent(const QString &dirPath, const QString &virtualPath)
+{
+    mLibraryWatcher->addPath(dirPath);
+
+    QFileInfoList fileInfoList = UBFileSystemUtils::allElementsInDirectory(dirPath);
+
+    QFileInfoList::iterator fileInfo;
+    for ( fileInfo = fileInfoList.begin(); fileInfo != fileInfoList.end(); fileInfo +=  1) {
+        QString fullFileName = fileInfo->absoluteFilePath();
+        if ( fullFileName.contains(".thumbnail."))
+            continue;
+
+        QString fileName = fileInfo->fileName();
+        UBFeatureElementType featureType = fileTypeFromUrl(fullFileName);
+
+        featuresModel->addItem(UBFeature(virtualPath + "/" + fileName, getIcon(fullFileName, featureType), fileName, QUrl::fromLocalFile(fullFileName), featureType));
+
+        if (featureType == FEATURE_FOLDER) {
+            addDirectoryContent(fullFileName, virtualPath + "/" + fileName);
+        }
+    }
+}
+
 void UBFeaturesController::createNpApiFeature(const QString &str)
 {
     Q_ASSERT(QFileInfo(str).exists() && QFileInfo(str).isDir());
@@ -681,11 +1013,9 @@ QImage UBFeaturesController::getIcon(const QString &path, UBFeatureElementType p
     } else if (pFType == FEATURE_VIDEO) {
         return QImage(":images/libpalette/movieIcon.svg");
     } else if (pFType == FEATURE_IMAGE) {
-        QImage pix(path);
+        QImage pix = cachedImageThumbnail(path);
         if (pix.isNull()) {
             pix = QImage(":images/libpalette/notFound.png");
-        } else {
-            pix = pix.scaledToWidth(qMin(UBSettings::maxThumbnailWidth, pix.width()));
         }
         return pix;
     }
@@ -722,9 +1052,8 @@ QImage UBFeaturesController::createThumbnail(const QString &path)
     } else if ( mimetype.contains("video")) {
         thumbnailPath = ":images/libpalette/movieIcon.svg";
     } else {
-        QImage pix(path);
+        QImage pix = cachedImageThumbnail(path);
         if (!pix.isNull()) {
-            pix = pix.scaledToWidth(qMin(UBSettings::maxThumbnailWidth, pix.width()), Qt::SmoothTransformation);
             return pix;
 
         } else {
@@ -736,6 +1065,44 @@ QImage UBFeaturesController::createThumbnail(const QString &path)
     return QImage(thumbnailPath);
 }
 
+QString UBFeaturesController::thumbnailCacheName(const QString &path)
+{
+    QFileInfo fileInfo(path);
+    QByteArray key = path.toUtf8() + "|" + QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch())
+                                   + "|" + QByteArray::number(fileInfo.size());
+
+    return QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex()) + ".png";
+}
+
+QImage UBFeaturesController::cachedImageThumbnail(const QString &path)
+{
+    // thumbnails are kept on disk under a key of path, modification time and size, so that a library
+    // scan only decodes the pictures that changed since the previous one
+    QString cachePath = UBSettings::userThumbnailCacheDirectory() + "/" + thumbnailCacheName(path);
+
+    QImage thumbnail(cachePath);
+    if (!thumbnail.isNull())
+        return thumbnail;
+
+    QImageReader reader(path);
+    QSize size = reader.size();
+    if (size.isValid() && size.width() > UBSettings::maxThumbnailWidth) {
+        reader.setScaledSize(QSize(UBSettings::maxThumbnailWidth,
+                                   qMax(1, size.height() * UBSettings::maxThumbnailWidth / size.width())));
+    }
+
+    thumbnail = reader.read();
+    if (thumbnail.isNull())
+        return thumbnail;
+
+    // scans and the palette may write the same entry concurrently, the last rename wins
+    QSaveFile cacheFile(cachePath);
+    if (cacheFile.open(QIODevice::WriteOnly) && thumbnail.save(&cacheFile, "PNG"))
+        cacheFile.commit();
+
+    return thumbnail;
+}
+
 void UBFeaturesController::importImage(const QImage &image, const QString &fileName)
 {
     importImage(image, currentElement, fileName);
@@ -943,9 +1310,11 @@ void UBFeaturesController::rescanModel()
 {
     featuresModel->removeRows(0, featuresList->count());
 
-    //Could implement infolder scanning for better perfomance
     scanFS();
     refreshModels();
+
+    // unchanged directories are taken from the index of the scanning thread
+    startThread();
 }
 
 void UBFeaturesController::siftElements(const QString &pSiftValue)
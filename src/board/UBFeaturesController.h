@@ -46,6 +46,8 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QListView>
+#include <QFileSystemWatcher>
+#include <QTimer>
 
 class UBFeaturesModel;
 class UBFeaturesItemDelegate;
@@ -57,6 +59,16 @@ class UBFeaturesListView;
 class UBFeature;
 
 
+// listing of a library directory as of its modification time, persisted between sessions so that
+// unchanged directories are not listed again
+struct UBFeaturesDirectoryIndex
+{
+    UBFeaturesDirectoryIndex() : modified(0) {}
+
+    qint64 modified;
+    QList<QPair<QString, int> > entries; // file name and UBFeatureElementType
+};
+
 class UBFeaturesComputingThread : public QThread
 {
     Q_OBJECT
@@ -84,8 +96,17 @@ private:
     void scanAll(QList<QPair<QUrl, UBFeature> > pScanningData, const QSet<QUrl> &pFavoriteSet);
     int featuresCount(const QUrl &pPath);
     int featuresCountAll(QList<QPair<QUrl, UBFeature> > pScanningData);
+    QList<QPair<QString, int> > directoryEntries(const QString &pDirPath);
+    void loadIndex();
+    void saveIndex();
+    void pruneThumbnailCache();
 
 private:
+    QHash<QString, UBFeaturesDirectoryIndex> mIndex;
+    QSet<QString> mScannedDirectories;
+    bool mIndexLoaded;
+    bool mIndexModified;
+
     QMutex mMutex;
     QWaitCondition mWaitCondition;
     QUrl mScanningPath;
@@ -208,6 +229,7 @@ public:
 
     static QString fileNameFromUrl( const QUrl &url );
     static QImage getIcon( const QString &path, UBFeatureElementType pFType );
+    static QString thumbnailCacheName( const QString &path );
     static bool isDeletable( const QUrl &url );
     static char featureTypeSplitter() {return ':';}
     static QString categoryNameForVirtualPath(const QString &str);
@@ -242,6 +264,10 @@ private slots:
     void addNewFolder(QString name);
     void startThread();
     void createNpApiFeature(const QString &str);
+    void onScanStarted();
+    void watchLibraryDirectories();
+    void libraryDirectoryChanged(const QString &path);
+    void rescanChangedDirectories();
 
 private:
 
@@ -256,14 +282,24 @@ private:
     QAbstractItemModel *curListModel;
     UBFeaturesComputingThread mCThread;
 
+    QList<QPair<QUrl, UBFeature> > mScanningRoots;
+    QFileSystemWatcher *mLibraryWatcher;
+    QTimer *mRescanTimer;
+    QSet<QString> mChangedDirectories;
+    bool mScanning;
+
 private:
 
     static QImage createThumbnail(const QString &path);
+    static QImage cachedImageThumbnail(const QString &path);
     //void addImageToCurrentPage( const QString &path );
     void loadFavoriteList();
     void saveFavoriteList();
     QString uniqNameForFeature(const UBFeature &feature, const QString &pName = "Imported", const QString &pExtention = "") const;
     QString adjustName(const QString &str);
+    QString virtualPathForDirectory(const QString &dirPath) const;
+    void rescanDirectory(const QString &dirPath);
+    void addDirectoryContent(const QString &dirPath, const QString &virtualPath);
 
     QList <UBFeature> *featuresList;
 
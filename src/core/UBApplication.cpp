@@ -42,6 +42,7 @@
 #include "UBSettings.h"
 #include "UBSetting.h"
 #include "UBPersistenceManager.h"
+#include "UBMediaStore.h"
 #include "UBDocumentManager.h"
 #include "UBPreferencesController.h"
 #include "UBIdleTimer.h"
@@ -59,17 +60,22 @@
 #include "gui/UBMainWindow.h"
 #include "gui/UBResources.h"
 
+#include "adaptors/UBExportQueue.h"
+#include "adaptors/UBDocumentArchiveExtractor.h"
 #include "adaptors/publishing/UBSvgSubsetRasterizer.h"
 
 #include "ui_mainWindow.h"
 
 #include "frameworks/UBCryptoUtils.h"
+#include "frameworks/UBDecodingQueue.h"
 #include "tools/UBToolsManager.h"
 
 #include "UBDisplayManager.h"
 #include "core/memcheck.h"
 
 QPointer<QUndoStack> UBApplication::undoStack;
+QPointer<QUndoGroup> UBApplication::undoGroup;
+QPointer<QUndoStack> UBApplication::defaultUndoStack;
 
 UBApplicationController* UBApplication::applicationController = 0;
 UBBoardController* UBApplication::boardController = 0;
@@ -120,8 +126,13 @@ UBApplication::UBApplication(const QString &id, int &argc, char **argv) : QtSing
 
     UBResources::resources();
 
-    if (!undoStack)
-        undoStack = new QUndoStack(staticMemoryCleaner);
+    if (!undoGroup)
+        undoGroup = new QUndoGroup(staticMemoryCleaner);
+
+    if (!defaultUndoStack)
+        defaultUndoStack = new QUndoStack(staticMemoryCleaner);
+
+    setActiveUndoStack(defaultUndoStack);
 
     UBPlatformUtils::init();
 
@@ -154,11 +165,21 @@ UBApplication::~UBApplication()
 
     UBFileSystemUtils::deleteAllTempDirCreatedDuringSession();
 
+    qDebug() << "file copies:" << UBFileSystemUtils::copyStatistics();
+
+    UBExportQueue::destroy();
+
+    UBDocumentArchiveExtractor::destroy();
+
     delete mainWindow;
     mainWindow = 0;
 
     UBPersistenceManager::destroy();
 
+    UBMediaStore::destroy();
+
+    UBDecodingQueue::destroy();
+
     UBDownloadManager::destroy();
 
     UBDrawingController::destroy();
@@ -182,6 +203,23 @@ UBApplication::~UBApplication()
     staticMemoryCleaner = 0;
 }
 
+void UBApplication::setActiveUndoStack(QUndoStack* stack)
+{
+    // without an active page, commands go to a stack of their own
+    if (!stack)
+        stack = defaultUndoStack;
+
+    if (undoGroup && stack)
+    {
+        if (!undoGroup->stacks().contains(stack))
+            undoGroup->addStack(stack);
+
+        undoGroup->setActiveStack(stack);
+    }
+
+    undoStack = stack;
+}
+
 QString UBApplication::checkLanguageAvailabilityForSankore(QString &language)
 {
     QStringList availableTranslations = UBPlatformUtils::availableTranslations();
@@ -294,6 +332,9 @@ int UBApplication::exec(const QString& pFileToImport)
     connect(mainWindow->actionQuit, SIGNAL(triggered()), this, SLOT(closing()));
     connect(mainWindow, SIGNAL(closeEvent_Signal(QCloseEvent*)), this, SLOT(closeEvent(QCloseEvent*)));
 
+    // media of documents imported in a previous session, before the board loads a page
+    UBDocumentArchiveExtractor::extractor()->resumePendingExtractions();
+
     boardController = new UBBoardController(mainWindow);
     boardController->init();
 
@@ -32,6 +32,7 @@
 
 #include <QtGui>
 #include <QUndoStack>
+#include <QUndoGroup>
 #include <QToolBar>
 #include <QMenu>
 
@@ -67,7 +68,10 @@ class UBApplication : public QtSingleApplication
 
         void cleanup();
 
+        // undo stack of the active page, the group follows it for the undo and redo actions
         static QPointer<QUndoStack> undoStack;
+        static QPointer<QUndoGroup> undoGroup;
+        static void setActiveUndoStack(QUndoStack* stack);
 
         static UBApplicationController *applicationController;
         static UBBoardController* boardController;
@@ -135,6 +139,8 @@ class UBApplication : public QtSingleApplication
         void onScreenCountChanged(int newCount);
 
     private:
+        static QPointer<QUndoStack> defaultUndoStack;
+
         void updateProtoActionsState();
         void setupTranslators(QStringList args);
         QList<QMenu*> mProtoMenus;
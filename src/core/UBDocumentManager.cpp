@@ -165,19 +165,22 @@ UBDocumentProxy* UBDocumentManager::importFile(const QFile& pFile, const QString
                     }
                 }
 
-                QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
-                int nPage = 0;
-                foreach(UBGraphicsItem* page, pages)
+                if (importAdaptor->importPages(document, uuid, filepath) < 0)
                 {
-                    UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
+                    QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
+                    int nPage = 0;
+                    foreach(UBGraphicsItem* page, pages)
+                    {
+                        UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
 #ifdef Q_OS_OSX
-                    //Workaround for issue 912
-                    QApplication::processEvents();
+                        //Workaround for issue 912
+                        QApplication::processEvents();
 #endif
-                    int pageIndex = document->pageCount();
-                    UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
-                    importAdaptor->placeImportedItemToScene(scene, page);
-                    UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                        int pageIndex = document->pageCount();
+                        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
+                        importAdaptor->placeImportedItemToScene(scene, page);
+                        UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                    }
                 }
 
                 UBPersistenceManager::persistenceManager()->persistDocumentMetadata(document);
@@ -231,16 +234,26 @@ int UBDocumentManager::addFilesToDocument(UBDocumentProxy* document, QStringList
                         }
                     }
 
-                    QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
-                    int nPage = 0;
-                    foreach(UBGraphicsItem* page, pages)
+                    int importedPages = importAdaptor->importPages(document, uuid, filepath);
+
+                    if (importedPages < 0)
                     {
-                        UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
-                        int pageIndex = document->pageCount();
-                        UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
-                        importAdaptor->placeImportedItemToScene(scene, page);
-                        UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
-                        UBApplication::boardController->addEmptyThumbPage();
+                        QList<UBGraphicsItem*> pages = importAdaptor->import(uuid, filepath);
+                        int nPage = 0;
+                        foreach(UBGraphicsItem* page, pages)
+                        {
+                            UBApplication::showMessage(tr("Inserting page %1 of %2").arg(++nPage).arg(pages.size()), true);
+                            int pageIndex = document->pageCount();
+                            UBGraphicsScene* scene = UBPersistenceManager::persistenceManager()->createDocumentSceneAt(document, pageIndex);
+                            importAdaptor->placeImportedItemToScene(scene, page);
+                            UBPersistenceManager::persistenceManager()->persistDocumentScene(document, scene, pageIndex);
+                            UBApplication::boardController->addEmptyThumbPage();
+                        }
+                    }
+                    else
+                    {
+                        for (int i = 0; i < importedPages; i++)
+                            UBApplication::boardController->addEmptyThumbPage();
                     }
 
                     UBPersistenceManager::persistenceManager()->persistDocumentMetadata(document);
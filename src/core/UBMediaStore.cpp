@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+#include "UBMediaStore.h"
+
+#include "core/UBSettings.h"
+#include "core/UBPersistenceManager.h"
+
+#include "frameworks/UBPlatformUtils.h"
+#include "frameworks/UBFileSystemUtils.h"
+
+#include "core/memcheck.h"
+
+
+QThreadPool* UBMediaStore::sWorkers = 0;
+
+
+class UBMediaStoreTask : public QRunnable
+{
+    public:
+        enum Kind
+        {
+            Store = 0, CollectGarbage
+        };
+
+        // the store directory is resolved on the GUI thread, the settings are not thread safe
+        UBMediaStoreTask(Kind kind, const QString& storeDirectory, const QString& filePath = QString())
+            : mKind(kind)
+            , mStoreDirectory(storeDirectory)
+            , mFilePath(filePath)
+        {
+            // NOOP
+        }
+
+        virtual void run()
+        {
+            if (mKind == Store)
+                UBMediaStore::storeFile(mStoreDirectory, mFilePath);
+            else
+                UBMediaStore::collectGarbage(mStoreDirectory);
+        }
+
+    private:
+        Kind mKind;
+        QString mStoreDirectory;
+        QString mFilePath;
+};
+
+
+QString UBMediaStore::storeDirectory()
+{
+    return UBSettings::userMediaStoreDirectory();
+}
+
+
+QThreadPool* UBMediaStore::workers()
+{
+    if (!sWorkers)
+    {
+        sWorkers = new QThreadPool();
+        sWorkers->setMaxThreadCount(1);
+    }
+
+    return sWorkers;
+}
+
+
+void UBMediaStore::destroy()
+{
+    if (sWorkers)
+        sWorkers->waitForDone();
+
+    delete sWorkers;
+    sWorkers = 0;
+}
+
+
+QString UBMediaStore::blobPath(const QString& storeDirectory, const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file))
+        return QString();
+
+    QString hex = QString::fromLatin1(hash.result().toHex());
+
+    return storeDirectory + "/" + hex.left(2) + "/" + hex;
+}
+
+
+void UBMediaStore::storeFile(const QString& storeDirectory, const QString& filePath)
+{
+    // the document may have been deleted in the meantime
+    QString blob = blobPath(storeDirectory, filePath);
+    if (blob.isEmpty())
+        return;
+
+    if (!QFile::exists(blob))
+    {
+        QDir().mkpath(QFileInfo(blob).absolutePath());
+        UBPlatformUtils::createHardLink(filePath, blob);
+        return;
+    }
+
+    // the content is stored already: the file becomes one more link to that blob. The link is
+    // made aside and moved over the file in one step, a scene reading it gets one or the other
+    QString linkPath = filePath + ".link";
+    QFile::remove(linkPath);
+
+    if (!UBPlatformUtils::createHardLink(blob, linkPath))
+        return;
+
+    if (!UBPlatformUtils::replaceFile(linkPath, filePath))
+        qDebug() << "cannot replace" << filePath << "by a link to" << blob;
+
+    // still there when the file already was a link to the blob
+    QFile::remove(linkPath);
+}
+
+
+void UBMediaStore::storeLater(const QString& filePath)
+{
+    workers()->start(new UBMediaStoreTask(UBMediaStoreTask::Store, storeDirectory(), filePath));
+}
+
+
+void UBMediaStore::storeDocumentMediaLater(const QString& documentPath)
+{
+    QStringList mediaDirectories;
+    mediaDirectories << UBPersistenceManager::imageDirectory << UBPersistenceManager::objectDirectory
+                     << UBPersistenceManager::videoDirectory << UBPersistenceManager::audioDirectory;
+
+    foreach (const QString& mediaDirectory, mediaDirectories)
+    {
+        foreach (QFileInfo mediaFile, QDir(documentPath + "/" + mediaDirectory).entryInfoList(QDir::Files))
+            storeLater(mediaFile.filePath());
+    }
+}
+
+
+bool UBMediaStore::shareFile(const QString& sourcePath, const QString& targetPath)
+{
+    if (!QFileInfo(sourcePath).isFile())
+    {
+        qDebug() << "file" << sourcePath << "does not present in fs";
+        return false;
+    }
+
+    if (QFile::exists(targetPath))
+        return false;
+
+    QDir().mkpath(QFileInfo(targetPath).absolutePath());
+
+    // already a name of a stored blob (or of another document copy)
+    bool stored = UBPlatformUtils::hardLinkCount(sourcePath) > 1;
+
+    if (UBPlatformUtils::createHardLink(sourcePath, targetPath))
+    {
+        // linking the copies together is enough to share them, hashing a video
+        // for the store can take seconds and is left to the worker
+        if (!stored)
+            storeLater(sourcePath);
+
+        return true;
+    }
+
+    return UBFileSystemUtils::copyFile(sourcePath, targetPath);
+}
+
+
+bool UBMediaStore::shareDir(const QString& sourceDirPath, const QString& targetDirPath)
+{
+    QDir dirSource(sourceDirPath);
+
+    if (!QDir().mkpath(targetDirPath))
+        return false;
+
+    foreach(QFileInfo dirContent, dirSource.entryInfoList(QDir::Files | QDir::Dirs
+            | QDir::NoDotAndDotDot | QDir::Hidden, QDir::Name))
+    {
+        QString targetPath = targetDirPath + "/" + dirContent.fileName();
+
+        bool success = dirContent.isDir() ? shareDir(dirContent.filePath(), targetPath)
+                                          : shareFile(dirContent.filePath(), targetPath);
+        if (!success)
+            return false;
+    }
+
+    return true;
+}
+
+
+void UBMediaStore::collectGarbageLater()
+{
+    workers()->start(new UBMediaStoreTask(UBMediaStoreTask::CollectGarbage, storeDirectory()));
+}
+
+
+qint64 UBMediaStore::collectGarbage(const QString& storeDirectory)
+{
+    qint64 freedBytes = 0;
+    int removedBlobs = 0;
+
+    QDir store(storeDirectory);
+
+    foreach(QFileInfo bucket, store.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        foreach(QFileInfo blob, QDir(bucket.filePath()).entryInfoList(QDir::Files | QDir::Hidden))
+        {
+            if (UBPlatformUtils::hardLinkCount(blob.filePath()) == 1)
+            {
+                qint64 size = blob.size();
+                if (QFile::remove(blob.filePath()))
+                {
+                    freedBytes += size;
+                    removedBlobs++;
+                }
+            }
+        }
+
+        store.rmdir(bucket.fileName()); // only succeeds once the bucket is empty
+    }
+
+    if (removedBlobs > 0)
+        qDebug() << "media store released" << removedBlobs << "blobs," << freedBytes << "bytes";
+
+    return freedBytes;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+#ifndef UBMEDIASTORE_H_
+#define UBMEDIASTORE_H_
+
+#include <QtCore>
+
+/*
+ * Content addressed store for the write-once media of documents (images, videos, audios, objects).
+ *
+ * Documents keep their usual layout; their media files are hard links to blobs named by the SHA-1
+ * of their content, so duplicating a document or a page only adds links, and media added or
+ * imported again are replaced by a link to the blob already holding their content. The link count
+ * of a blob is its reference count: a blob only linked from the store is garbage.
+ *
+ * Hashing and collecting read whole files, they run on a single worker thread so that they
+ * neither block the GUI nor race each other.
+ */
+class UBMediaStore
+{
+    public:
+        static QString storeDirectory();
+
+        // gives targetPath the content of sourcePath by linking it to the same file, falls back to a plain
+        // copy where hard links are not supported; the source is added to the store on the worker thread
+        static bool shareFile(const QString& sourcePath, const QString& targetPath);
+        static bool shareDir(const QString& sourceDirPath, const QString& targetDirPath);
+
+        // adds a media file just written to a document to the store, on the worker thread
+        static void storeLater(const QString& filePath);
+        static void storeDocumentMediaLater(const QString& documentPath);
+
+        // removes the blobs no document references anymore, on the worker thread
+        static void collectGarbageLater();
+
+        // waits for the work still queued
+        static void destroy();
+
+    private:
+        friend class UBMediaStoreTask;
+
+        static QString blobPath(const QString& storeDirectory, const QString& filePath);
+        static void storeFile(const QString& storeDirectory, const QString& filePath);
+        static qint64 collectGarbage(const QString& storeDirectory);
+
+        static QThreadPool* workers();
+        static QThreadPool* sWorkers;
+};
+
+#endif /* UBMEDIASTORE_H_ */
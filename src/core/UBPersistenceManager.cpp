@@ -34,14 +34,17 @@
 
 #include "frameworks/UBPlatformUtils.h"
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBDecodingQueue.h"
 
 #include "core/UBApplication.h"
 #include "core/UBSettings.h"
 #include "core/UBSetting.h"
+#include "core/UBMediaStore.h"
 
 #include "document/UBDocumentProxy.h"
 
 #include "adaptors/UBExportPDF.h"
+#include "adaptors/UBDocumentArchiveExtractor.h"
 #include "adaptors/UBSvgSubsetAdaptor.h"
 #include "adaptors/UBThumbnailAdaptor.h"
 #include "adaptors/UBMetadataDcSubsetAdaptor.h"
@@ -50,8 +53,10 @@
 #include "domain/UBGraphicsWidgetItem.h"
 #include "domain/UBGraphicsPixmapItem.h"
 #include "domain/UBGraphicsSvgItem.h"
+#include "domain/UBGraphicsPDFItem.h"
 
 #include "board/UBBoardController.h"
+#include "board/UBBoardView.h"
 #include "board/UBBoardPaletteManager.h"
 
 #include "core/memcheck.h"
@@ -69,6 +74,7 @@ UBPersistenceManager::UBPersistenceManager(QObject *pParent)
     , mHasPurgedDocuments(false)
     , mIsApplicationClosing(false)
     , mIsWorkerFinished(false)
+    , mMediaGarbageCollectionPending(false)
 {
 
     mDocumentSubDirectories << imageDirectory;
@@ -177,13 +183,39 @@ void UBPersistenceManager::errorString(QString error)
     qDebug() << "peristence thread return the error " << error;
 }
 
+void UBPersistenceManager::collectMediaGarbage()
+{
+    mMediaGarbageCollectionPending = false;
+
+    UBMediaStore::collectGarbageLater();
+}
+
 void UBPersistenceManager::onSceneLoaded(QByteArray scene, UBDocumentProxy* proxy, int sceneIndex)
 {
     qDebug() << "scene loaded " << sceneIndex;
     QTime time;
     time.start();
-    mSceneCache.insert(proxy,sceneIndex,UBSvgSubsetAdaptor::loadScene(proxy,scene));
+    UBGraphicsScene* loadedScene = UBSvgSubsetAdaptor::loadScene(proxy, scene, false);
+    mSceneCache.insert(proxy,sceneIndex,loadedScene);
     qDebug() << "millisecond for sceneCache " << time.elapsed();
+
+    prerenderPDFBackgrounds(loadedScene);
+}
+
+void UBPersistenceManager::prerenderPDFBackgrounds(UBGraphicsScene* pScene)
+{
+    if (!pScene || !UBApplication::boardController || !UBApplication::boardController->controlView())
+        return;
+
+    // the neighboring pages get their pdf rasterized at the zoom of the board, before they are shown
+    qreal viewScale = UBApplication::boardController->controlView()->viewportTransform().m11();
+
+    foreach (QGraphicsItem* item, pScene->items())
+    {
+        UBGraphicsPDFItem* pdfItem = qgraphicsitem_cast<UBGraphicsPDFItem*>(item);
+        if (pdfItem)
+            pdfItem->prerender(viewScale);
+    }
 }
 
 QList<QPointer<UBDocumentProxy> > UBPersistenceManager::allDocumentProxies()
@@ -401,8 +433,16 @@ void UBPersistenceManager::deleteDocument(UBDocumentProxy* pDocumentProxy)
 
     emit documentWillBeDeleted(pDocumentProxy);
 
+    UBDocumentArchiveExtractor::extractor()->forgetDocument(pDocumentProxy->persistencePath());
     UBFileSystemUtils::deleteDir(pDocumentProxy->persistencePath());
 
+    // deleting a selection of documents only needs a single pass over the store
+    if (!mMediaGarbageCollectionPending)
+    {
+        mMediaGarbageCollectionPending = true;
+        QTimer::singleShot(0, this, SLOT(collectMediaGarbage()));
+    }
+
     documentProxies.removeAll(QPointer<UBDocumentProxy>(pDocumentProxy));
     mDocumentCreatedDuringSession.removeAll(pDocumentProxy);
 
@@ -421,7 +461,8 @@ UBDocumentProxy* UBPersistenceManager::duplicateDocument(UBDocumentProxy* pDocum
 
     generatePathIfNeeded(copy);
 
-    UBFileSystemUtils::copyDir(pDocumentProxy->persistencePath(), copy->persistencePath());
+    UBDocumentArchiveExtractor::extractor()->extractAllEntries(pDocumentProxy->persistencePath());
+    copyDocumentDirectory(pDocumentProxy->persistencePath(), copy->persistencePath());
 
     // regenerate scenes UUIDs
     for(int i = 0; i < pDocumentProxy->pageCount(); i++)
@@ -452,6 +493,38 @@ UBDocumentProxy* UBPersistenceManager::duplicateDocument(UBDocumentProxy* pDocum
 }
 
 
+bool UBPersistenceManager::copyDocumentDirectory(const QString& sourcePath, const QString& targetPath)
+{
+    if (!QDir().mkpath(targetPath))
+        return false;
+
+    // media are write-once and can be shared through the media store, widgets write
+    // their preferences into their own folder and need a copy
+    QStringList sharedDirectories;
+    sharedDirectories << imageDirectory << objectDirectory << videoDirectory << audioDirectory;
+
+    bool success = true;
+
+    foreach(QFileInfo entry, QDir(sourcePath).entryInfoList(QDir::Files | QDir::Dirs
+            | QDir::NoDotAndDotDot | QDir::Hidden, QDir::Name))
+    {
+        QString target = targetPath + "/" + entry.fileName();
+
+        if (entry.isDir() && sharedDirectories.contains(entry.fileName()))
+            success = UBMediaStore::shareDir(entry.filePath(), target);
+        else if (entry.isDir())
+            success = UBFileSystemUtils::copyDir(entry.filePath(), target);
+        else
+            success = UBFileSystemUtils::cloneFile(entry.filePath(), target);
+
+        if (!success)
+            break;
+    }
+
+    return success;
+}
+
+
 void UBPersistenceManager::deleteDocumentScenes(UBDocumentProxy* proxy, const QList<int>& indexes)
 {
     checkIfDocumentRepositoryExists();
@@ -488,6 +561,8 @@ void UBPersistenceManager::deleteDocumentScenes(UBDocumentProxy* proxy, const QL
 
     foreach(int index, compactedIndexes)
     {
+        extractSceneMedia(proxy, index);
+
         UBGraphicsScene *scene = loadDocumentScene(proxy, index, false);
         if (scene)
         {
@@ -566,6 +641,8 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
 
     }
 
+    extractSceneMedia(proxy, index);
+
     copyPage(proxy, index , index + 1);
 
 
@@ -582,7 +659,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBMediaStore::shareFile(source,destination);
             mediaItem->setMediaFileUrl(QUrl::fromLocalFile(destination));
             continue;
         }
@@ -602,7 +679,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             screenshotDestinationPath = screenshotDestinationPath.replace(actualUuidString,newUUidString);
 
             UBFileSystemUtils::copyDir(widgetSourcePath,widgetDestinationPath);
-            QFile::copy(screenshotSourcePath,screenshotDestinationPath);
+            UBMediaStore::shareFile(screenshotSourcePath,screenshotDestinationPath);
 
             widget->setUuid(newUUid);
 
@@ -618,7 +695,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBMediaStore::shareFile(source,destination);
             pixmapItem->setUuid(newUuid);
             continue;
         }
@@ -630,7 +707,7 @@ void UBPersistenceManager::duplicateDocumentScene(UBDocumentProxy* proxy, int in
             QUuid newUuid = QUuid::createUuid();
             QString fileName = QFileInfo(source).completeBaseName();
             destination = destination.replace(fileName,newUuid.toString());
-            QFile::copy(source,destination);
+            UBMediaStore::shareFile(source,destination);
             svgItem->setUuid(newUuid);
             continue;
         }
@@ -670,6 +747,26 @@ UBGraphicsScene* UBPersistenceManager::createDocumentSceneAt(UBDocumentProxy* pr
 }
 
 
+int UBPersistenceManager::appendPDFPage(UBDocumentProxy* proxy, const QString& pdfFileName, int pdfPageNumber, const QSizeF& pdfPageSize)
+{
+    int index = proxy->pageCount();
+
+    if (!UBSvgSubsetAdaptor::persistPDFPageDescriptor(proxy, index, pdfFileName, pdfPageNumber, pdfPageSize))
+        return -1;
+
+    proxy->incPageCount();
+
+    return index;
+}
+
+
+void UBPersistenceManager::pagesAppended(UBDocumentProxy* proxy, int firstIndex)
+{
+    // once for the whole batch, listeners reload all the thumbnails
+    emit documentSceneCreated(proxy, firstIndex);
+}
+
+
 void UBPersistenceManager::insertDocumentSceneAt(UBDocumentProxy* proxy, UBGraphicsScene* scene, int index)
 {
     scene->setDocument(proxy);
@@ -739,7 +836,7 @@ UBGraphicsScene* UBPersistenceManager::loadDocumentScene(UBDocumentProxy* proxy,
     if (mSceneCache.contains(proxy, sceneIndex))
         scene = mSceneCache.value(proxy, sceneIndex);
     else {
-        scene = UBSvgSubsetAdaptor::loadScene(proxy, sceneIndex);
+        scene = UBSvgSubsetAdaptor::loadScene(proxy, sceneIndex, false);
 
         if (scene)
             mSceneCache.insert(proxy, sceneIndex, scene);
@@ -748,9 +845,13 @@ UBGraphicsScene* UBPersistenceManager::loadDocumentScene(UBDocumentProxy* proxy,
     if (cacheNeighboringScenes) {
         if(sceneIndex + 1 < proxy->pageCount() &&  !mSceneCache.contains(proxy, sceneIndex + 1))
             mWorker->readScene(proxy,sceneIndex+1);
+        else if (sceneIndex + 1 < proxy->pageCount())
+            prerenderPDFBackgrounds(mSceneCache.value(proxy, sceneIndex + 1));
 
         if(sceneIndex - 1 >= 0 &&  !mSceneCache.contains(proxy, sceneIndex - 1))
             mWorker->readScene(proxy,sceneIndex-1);
+        else if (sceneIndex - 1 >= 0)
+            prerenderPDFBackgrounds(mSceneCache.value(proxy, sceneIndex - 1));
     }
 
     return scene;
@@ -776,6 +877,9 @@ void UBPersistenceManager::persistDocumentScene(UBDocumentProxy* pDocumentProxy,
         if (pDocumentProxy->isModified())
             persistDocumentMetadata(pDocumentProxy, forceImmediateSaving);
 
+        // the thumbnail and the copy handed to the worker need the decoded images
+        UBDecodingQueue::queue()->waitForPendingDecodes(pScene);
+
         UBThumbnailAdaptor::persistScene(pDocumentProxy, pScene, pSceneIndex);
         if(forceImmediateSaving)
             UBSvgSubsetAdaptor::persistScene(pDocumentProxy,pScene,pSceneIndex);
@@ -815,13 +919,22 @@ void UBPersistenceManager::renamePage(UBDocumentProxy* pDocumentProxy, const int
 
 void UBPersistenceManager::copyPage(UBDocumentProxy* pDocumentProxy, const int sourceIndex, const int targetIndex)
 {
-    QFile svg(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg",sourceIndex));
-    svg.copy(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", targetIndex));
+    UBFileSystemUtils::cloneFile(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", sourceIndex),
+                                 pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.svg", targetIndex));
 
     UBSvgSubsetAdaptor::setSceneUuid(pDocumentProxy, targetIndex, QUuid::createUuid());
 
-    QFile thumb(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceIndex));
-    thumb.copy(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetIndex));
+    UBFileSystemUtils::cloneFile(pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", sourceIndex),
+                                 pDocumentProxy->persistencePath() + UBFileSystemUtils::digitFileFormat("/page%1.thumbnail.jpg", targetIndex));
+}
+
+
+void UBPersistenceManager::extractSceneMedia(UBDocumentProxy* proxy, int sceneIndex)
+{
+    UBDocumentArchiveExtractor* extractor = UBDocumentArchiveExtractor::extractor();
+
+    if (extractor->hasPendingEntries(proxy->persistencePath()))
+        extractor->extractReferencedEntries(proxy->persistencePath(), UBSvgSubsetAdaptor::loadSceneAsText(proxy, sceneIndex));
 }
 
 
@@ -939,7 +1052,7 @@ bool UBPersistenceManager::isEmpty(UBDocumentProxy* pDocumentProxy)
     if (pDocumentProxy->pageCount() > 1)
         return false;
 
-    UBGraphicsScene *theSoleScene = mSceneCache.value(pDocumentProxy, 0) ? mSceneCache.value(pDocumentProxy, 0) : UBSvgSubsetAdaptor::loadScene(pDocumentProxy, 0);
+    UBGraphicsScene *theSoleScene = mSceneCache.value(pDocumentProxy, 0) ? mSceneCache.value(pDocumentProxy, 0) : UBSvgSubsetAdaptor::loadScene(pDocumentProxy, 0, false);
 
     bool empty = false;
 
@@ -1028,8 +1141,12 @@ bool UBPersistenceManager::addFileToDocument(UBDocumentProxy* pDocumentProxy,
 
         if (data == NULL)
         {
-            QFile source(path);
-            return source.copy(destinationPath);
+            if (!UBFileSystemUtils::cloneFile(path, destinationPath))
+                return false;
+
+            // the same media added to another document ends up linked to the same blob
+            UBMediaStore::storeLater(destinationPath);
+            return true;
         }
         else
         {
@@ -1040,7 +1157,12 @@ bool UBPersistenceManager::addFileToDocument(UBDocumentProxy* pDocumentProxy,
                 qint64 n = newFile.write(*data);
                 newFile.flush();
                 newFile.close();
-                return n == data->size();
+
+                if (n != data->size())
+                    return false;
+
+                UBMediaStore::storeLater(destinationPath);
+                return true;
             }
             else
             {
@@ -81,6 +81,10 @@ class UBPersistenceManager : public QObject
 
         virtual UBGraphicsScene* createDocumentSceneAt(UBDocumentProxy* pDocumentProxy, int index, bool useUndoRedoStack = true);
 
+        // appends a page showing a pdf page of the document's objects, without creating its scene
+        int appendPDFPage(UBDocumentProxy* pDocumentProxy, const QString& pdfFileName, int pdfPageNumber, const QSizeF& pdfPageSize);
+        void pagesAppended(UBDocumentProxy* pDocumentProxy, int firstIndex);
+
         virtual void insertDocumentSceneAt(UBDocumentProxy* pDocumentProxy, UBGraphicsScene* scene, int index);
 
         virtual void moveSceneToIndex(UBDocumentProxy* pDocumentProxy, int source, int target);
@@ -88,6 +92,9 @@ class UBPersistenceManager : public QObject
         virtual UBGraphicsScene* loadDocumentScene(UBDocumentProxy* pDocumentProxy, int sceneIndex, bool cacheNeighboringScenes = true);
         UBGraphicsScene *getDocumentScene(UBDocumentProxy* pDocumentProxy, int sceneIndex) {return mSceneCache.value(pDocumentProxy, sceneIndex);}
 
+        // pages shown on the board may still wait for media of their imported document, code copying their files calls this first
+        void extractSceneMedia(UBDocumentProxy* pDocumentProxy, int sceneIndex);
+
         QList<QPointer<UBDocumentProxy> > documentProxies;
 
         virtual QStringList allShapes();
@@ -137,9 +144,12 @@ class UBPersistenceManager : public QObject
                 const int sourceIndex, const int targetIndex);
 
         void generatePathIfNeeded(UBDocumentProxy* pDocumentProxy);
+        bool copyDocumentDirectory(const QString& sourcePath, const QString& targetPath);
 
         void checkIfDocumentRepositoryExists();
 
+        void prerenderPDFBackgrounds(UBGraphicsScene* pScene);
+
         UBSceneCache mSceneCache;
 
         QStringList mDocumentSubDirectories;
@@ -159,6 +169,8 @@ class UBPersistenceManager : public QObject
 
         bool mIsApplicationClosing;
 
+        bool mMediaGarbageCollectionPending;
+
     private slots:
         void documentRepositoryChanged(const QString& path);
         void errorString(QString error);
@@ -166,6 +178,7 @@ class UBPersistenceManager : public QObject
         void onWorkerFinished();
         void onScenePersisted(UBGraphicsScene* scene);
         void onMetadataPersisted(UBDocumentProxy* proxy);
+        void collectMediaGarbage();
 };
 
 
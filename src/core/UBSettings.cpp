@@ -171,6 +171,10 @@ UBSettings::UBSettings(QObject *parent)
 
     mUserSettings = new QSettings(userSettingsFile, QSettings::IniFormat, parent);
 
+    // resolved once on the GUI thread, the library scanning thread reads them afterwards
+    userCacheDirectory();
+    userThumbnailCacheDirectory();
+
     init();
 }
 
@@ -368,12 +372,18 @@ void UBSettings::init()
     boardShowToolsPalette = new UBSetting(this, "Board", "ShowToolsPalette", "false");
     magnifierDrawingMode = new UBSetting(this, "Board", "MagnifierDrawingMode", "0");
     autoSaveInterval = new UBSetting(this, "Board", "AutoSaveIntervalInMinutes", "3");
+    // number of recently visited pages of a document that keep their undo history, 1 keeps the current page only
+    undoHistoryPagesPerDocument = new UBSetting(this, "Board", "UndoHistoryPagesPerDocument", "10");
+    // memory the off-scene items kept by those histories may hold, the current page is never trimmed
+    undoHistoryMegabytesPerDocument = new UBSetting(this, "Board", "UndoHistoryMegabytesPerDocument", "128");
 
     svgViewBoxMargin = new UBSetting(this, "SVG", "ViewBoxMargin", "50");
 
     pdfMargin = new UBSetting(this, "PDF", "Margin", "20");
     pdfPageFormat = new UBSetting(this, "PDF", "PageFormat", "A4");
     pdfResolution = new UBSetting(this, "PDF", "Resolution", "300");
+    // images painted smaller are downsampled to this resolution in exported pdf, 0 keeps their native resolution
+    pdfImageResolution = new UBSetting(this, "PDF", "ImageResolution", "0");
 
     podcastFramesPerSecond = new UBSetting(this, "Podcast", "FramesPerSecond", 10);
     podcastVideoSize = new UBSetting(this, "Podcast", "VideoSize", "Medium");
@@ -954,6 +964,38 @@ QString UBSettings::userDocumentDirectory()
     return documentDirectory;
 }
 
+QString UBSettings::userMediaStoreDirectory()
+{
+    // beside the document directory, so that its blobs are not taken for documents
+    // and stay on the same file system as the documents linking to them
+    static QString mediaStoreDirectory = "";
+    if(mediaStoreDirectory.isEmpty()){
+        mediaStoreDirectory = userDataDirectory() + "/media";
+        checkDirectory(mediaStoreDirectory);
+    }
+    return mediaStoreDirectory;
+}
+
+QString UBSettings::userCacheDirectory()
+{
+    static QString cacheDirectory = "";
+    if(cacheDirectory.isEmpty()){
+        cacheDirectory = userDataDirectory() + "/cache";
+        checkDirectory(cacheDirectory);
+    }
+    return cacheDirectory;
+}
+
+QString UBSettings::userThumbnailCacheDirectory()
+{
+    static QString thumbnailCacheDirectory = "";
+    if(thumbnailCacheDirectory.isEmpty()){
+        thumbnailCacheDirectory = userCacheDirectory() + "/thumbnails";
+        checkDirectory(thumbnailCacheDirectory);
+    }
+    return thumbnailCacheDirectory;
+}
+
 QString UBSettings::userFavoriteListFilePath()
 {
     static QString filePath = "";
@@ -130,6 +130,9 @@ class UBSettings : public QObject
         //user directories
         static QString userDataDirectory();
         static QString userDocumentDirectory();
+        static QString userMediaStoreDirectory();
+        static QString userCacheDirectory();
+        static QString userThumbnailCacheDirectory();
         static QString userFavoriteListFilePath();
         static QString userTrashDirPath();
         static QString userImageDirectory();
@@ -329,6 +332,7 @@ class UBSettings : public QObject
         UBSetting* pdfMargin;
         UBSetting* pdfPageFormat;
         UBSetting* pdfResolution;
+        UBSetting* pdfImageResolution;
 
         UBSetting* podcastFramesPerSecond;
         UBSetting* podcastVideoSize;
@@ -380,6 +384,8 @@ class UBSettings : public QObject
 
         UBSetting* magnifierDrawingMode;
         UBSetting* autoSaveInterval;
+        UBSetting* undoHistoryPagesPerDocument;
+        UBSetting* undoHistoryMegabytesPerDocument;
 
     public slots:
 
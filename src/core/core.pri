@@ -4,6 +4,7 @@ HEADERS      += src/core/UB.h \
                 src/core/UBSettings.h \
                 src/core/UBSetting.h \
                 src/core/UBPersistenceManager.h \
+                src/core/UBMediaStore.h \
                 src/core/UBSceneCache.h \
                 src/core/UBPreferencesController.h \
                 src/core/UBMimeData.h \
@@ -22,6 +23,7 @@ SOURCES      += src/core/main.cpp \
                 src/core/UBSettings.cpp \
                 src/core/UBSetting.cpp \
                 src/core/UBPersistenceManager.cpp \
+                src/core/UBMediaStore.cpp \
                 src/core/UBSceneCache.cpp \
                 src/core/UBPreferencesController.cpp \
                 src/core/UBMimeData.cpp \
@@ -44,6 +44,7 @@
 #include "core/UBSetting.h"
 
 #include "adaptors/UBExportPDF.h"
+#include "adaptors/UBExportQueue.h"
 #include "adaptors/UBThumbnailAdaptor.h"
 
 #include "adaptors/UBMetadataDcSubsetAdaptor.h"
@@ -516,7 +517,7 @@ void UBDocumentController::duplicateSelectedItem()
                 }
             }
         }
-        if (selectedSceneIndexes.count() > 0)
+        if (selectedSceneIndexes.count() > 0 && !UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
         {
             duplicatePages(selectedSceneIndexes);
             emit documentThumbnailsUpdated(this);
@@ -1203,6 +1204,9 @@ bool UBDocumentController::addFileToDocument(UBDocumentProxy* document)
 
 void UBDocumentController::moveSceneToIndex(UBDocumentProxy* proxy, int source, int target)
 {
+    if (UBExportQueue::queue()->blocksPageChanges(proxy))
+        return;
+
     if (UBDocumentContainer::movePageToIndex(source, target))
     {
         proxy->setMetaData(UBSettings::documentUpdatedAt, UBStringUtils::toUtcIsoDateTime(QDateTime::currentDateTime()));
@@ -1801,7 +1805,7 @@ void UBDocumentController::focusChanged(QWidget *old, QWidget *current)
 
 void UBDocumentController::deletePages(QList<QGraphicsItem *> itemsToDelete)
 {
-    if (itemsToDelete.count() > 0)
+    if (itemsToDelete.count() > 0 && !UBExportQueue::queue()->blocksPageChanges(selectedDocument()))
     {
         QList<int> sceneIndexes;
         UBDocumentProxy* proxy = 0;
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBBackgroundGrid.h"
+
+#include "core/UBSettings.h"
+#include "core/UBSetting.h"
+
+#include "core/memcheck.h"
+
+// above this tile size the few visible lines are cheaper to draw directly
+static const int maxTileSize = 1024;
+static const int maxCachedTiles = 64;
+
+UBBackgroundGrid* UBBackgroundGrid::sGrid = 0;
+
+UBBackgroundGrid* UBBackgroundGrid::grid()
+{
+    if (!sGrid)
+        sGrid = new UBBackgroundGrid();
+
+    return sGrid;
+}
+
+
+UBBackgroundGrid::UBBackgroundGrid()
+    : QObject(qApp)
+{
+    UBSettings *settings = UBSettings::settings();
+
+    connect(settings->boardCrossColorDarkBackground, SIGNAL(changed(QVariant)), this, SLOT(crossColorChanged()));
+    connect(settings->boardCrossColorLightBackground, SIGNAL(changed(QVariant)), this, SLOT(crossColorChanged()));
+
+    crossColorChanged();
+}
+
+
+UBBackgroundGrid::~UBBackgroundGrid()
+{
+    sGrid = 0;
+}
+
+
+void UBBackgroundGrid::crossColorChanged()
+{
+    QMutexLocker locker(&mTilesMutex);
+
+    mCrossColorDarkBackground = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
+    mCrossColorLightBackground = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
+
+    mTiles.clear();
+}
+
+
+QColor UBBackgroundGrid::crossColor(bool darkBackground, qreal zoomFactor) const
+{
+    QColor color = darkBackground ? mCrossColorDarkBackground : mCrossColorLightBackground;
+
+    if (zoomFactor < 1.0)
+    {
+        int alpha = 255 * zoomFactor / 2;
+        color.setAlpha (alpha); // fade the crossing on small zooms
+    }
+
+    return color;
+}
+
+
+void UBBackgroundGrid::draw(QPainter *painter, const QRectF& rect, bool darkBackground, bool crossedBackground, qreal zoomFactor)
+{
+    painter->fillRect (rect, QBrush (QColor (darkBackground ? Qt::black : Qt::white)));
+
+    if (!crossedBackground || zoomFactor <= 0.5)
+        return;
+
+    QColor color = crossColor(darkBackground, zoomFactor);
+
+    QTransform transform = painter->worldTransform();
+    QPaintEngine *engine = painter->paintEngine();
+
+    bool vectorDevice = engine && (engine->type() == QPaintEngine::Pdf
+                                   || engine->type() == QPaintEngine::Picture
+                                   || engine->type() == QPaintEngine::SVG
+                                   || engine->type() == QPaintEngine::MacPrinter
+                                   || engine->type() == QPaintEngine::Windows);
+
+    // quantize the device scale so that zooming around a value reuses the same tile
+    qreal deviceScale = qRound(qAbs(transform.m11()) * 16) / 16.0;
+    int pixelSize = qRound(UBSettings::crossSize * deviceScale);
+
+    if (vectorDevice || transform.type() > QTransform::TxScale || pixelSize < 2 || pixelSize > maxTileSize)
+    {
+        drawLines(painter, rect, color);
+        return;
+    }
+
+    QImage pattern = tile(color, pixelSize);
+
+    // one tile covers exactly one cross cell in scene coordinates, anchored at the scene origin
+    qreal tileScale = (qreal)UBSettings::crossSize / pixelSize;
+
+    QBrush brush(pattern);
+    brush.setTransform(QTransform::fromScale(tileScale, tileScale));
+
+    painter->save();
+    painter->setBrushOrigin(0, 0);
+    painter->fillRect(rect, brush);
+    painter->restore();
+}
+
+
+QImage UBBackgroundGrid::tile(const QColor& color, int pixelSize)
+{
+    quint64 key = ((quint64)color.rgba() << 32) | (quint32)pixelSize;
+
+    QMutexLocker locker(&mTilesMutex);
+
+    if (mTiles.contains(key))
+        return mTiles.value(key);
+
+    QImage image(pixelSize, pixelSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setPen(color);
+    painter.drawLine(0, 0, pixelSize - 1, 0);
+    painter.drawLine(0, 0, 0, pixelSize - 1);
+    painter.end();
+
+    if (mTiles.size() >= maxCachedTiles)
+        mTiles.clear();
+
+    mTiles.insert(key, image);
+
+    return image;
+}
+
+
+void UBBackgroundGrid::drawLines(QPainter *painter, const QRectF& rect, const QColor& color)
+{
+    painter->setPen (color);
+
+    qreal firstY = ((int) (rect.y () / UBSettings::crossSize)) * UBSettings::crossSize;
+
+    for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += UBSettings::crossSize)
+    {
+        painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
+    }
+
+    qreal firstX = ((int) (rect.x () / UBSettings::crossSize)) * UBSettings::crossSize;
+
+    for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += UBSettings::crossSize)
+    {
+        painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBBACKGROUNDGRID_H
+#define UBBACKGROUNDGRID_H
+
+#include <QtGui>
+
+/*
+ * Draws the board background (plain fill plus the optional crossing).
+ *
+ * The crossing is rendered once per (background, zoom step) into a small tile that is
+ * then used as a texture brush, so an expose costs a single fill whatever the zoom.
+ * Cross colors are read from the settings once and refreshed when they change.
+ */
+class UBBackgroundGrid : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static UBBackgroundGrid* grid();
+
+        void draw(QPainter *painter, const QRectF& rect, bool darkBackground, bool crossedBackground, qreal zoomFactor);
+
+    private slots:
+        void crossColorChanged();
+
+    private:
+        UBBackgroundGrid();
+        virtual ~UBBackgroundGrid();
+
+        QColor crossColor(bool darkBackground, qreal zoomFactor) const;
+        QImage tile(const QColor& color, int pixelSize);
+        void drawLines(QPainter *painter, const QRectF& rect, const QColor& color);
+
+        static UBBackgroundGrid* sGrid;
+
+        QColor mCrossColorDarkBackground;
+        QColor mCrossColorLightBackground;
+
+        QMutex mTilesMutex;
+        QHash<quint64, QImage> mTiles;
+};
+
+#endif // UBBACKGROUNDGRID_H
@@ -60,6 +60,7 @@ UBGraphicsGroupContainerItem::UBGraphicsGroupContainerItem(QGraphicsItem *parent
 
 UBGraphicsGroupContainerItem::~UBGraphicsGroupContainerItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 void UBGraphicsGroupContainerItem::addToGroup(QGraphicsItem *item)
@@ -141,6 +142,17 @@ void UBGraphicsGroupContainerItem::addToGroup(QGraphicsItem *item)
     itemsBoundingRect |= itemTransform.mapRect(item->boundingRect() | item->childrenBoundingRect());
     update();
 }
+
+void UBGraphicsGroupContainerItem::childGeometryChanged(QGraphicsItem *item)
+{
+    if (!item || item->parentItem() != this)
+        return;
+
+    prepareGeometryChange();
+    itemsBoundingRect |= item->mapRectToParent(item->boundingRect() | item->childrenBoundingRect());
+    update();
+}
+
 void UBGraphicsGroupContainerItem::removeFromGroup(QGraphicsItem *item)
 {
     if (!item) {
@@ -44,6 +44,7 @@ public:
 
     void addToGroup(QGraphicsItem *item);
     void removeFromGroup(QGraphicsItem *item);
+    void childGeometryChanged(QGraphicsItem *item);
     void setCurrentItem(QGraphicsItem *item){mCurrentItem = item;}
     QGraphicsItem *getCurrentItem() const {return mCurrentItem;}
     void deselectCurrentItem();
@@ -300,6 +300,32 @@ QVariant UBGraphicsItemDelegate::itemChange(QGraphicsItem::GraphicsItemChange ch
             ubScene->setModified(true);
         }
         break;
+
+    // keep the scene render index in sync, whatever way the item enters or leaves the scene
+    case QGraphicsItem::ItemSceneChange :
+        if (ubScene) {
+            ubScene->unindexItem(delegated());
+        }
+        break;
+
+    case QGraphicsItem::ItemSceneHasChanged :
+    case QGraphicsItem::ItemParentHasChanged :
+        if (ubScene) {
+            ubScene->itemLayerChanged(delegated());
+        }
+        break;
+
+    case QGraphicsItem::ItemChildAddedChange :
+        if (ubScene) {
+            ubScene->itemLayerChanged(qvariant_cast<QGraphicsItem*>(value));
+        }
+        break;
+
+    case QGraphicsItem::ItemChildRemovedChange :
+        if (ubScene) {
+            ubScene->unindexItem(qvariant_cast<QGraphicsItem*>(value));
+        }
+        break;
     }
 
     return value;
@@ -591,6 +617,11 @@ void UBGraphicsItemDelegate::showHide(bool show)
 {
     QVariant showFlag = QVariant(show ? UBItemLayerType::Object : UBItemLayerType::Control);
     showHideRecurs(showFlag, mDelegated);
+
+    UBGraphicsScene *ubScene = castUBGraphicsScene();
+    if (ubScene)
+        ubScene->itemLayerChanged(mDelegated);
+
     mDelegated->update();
 
     emit showOnDisplayChanged(show);
@@ -162,6 +162,8 @@ UBGraphicsVideoItem::UBGraphicsVideoItem(const QUrl &pMediaFileUrl, QGraphicsIte
 
 UBGraphicsMediaItem::~UBGraphicsMediaItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
+
     if (mMediaObject) {
         mMediaObject->stop();
         delete mMediaObject;
@@ -272,6 +274,13 @@ void UBGraphicsMediaItem::setMediaFileUrl(QUrl url)
     mMediaFileUrl = url;
 }
 
+void UBGraphicsMediaItem::reloadMedia()
+{
+    // the file was missing when the item was read, the player gave up on it
+    mErrorString = "";
+    mMediaObject->setMedia(mMediaFileUrl);
+}
+
 void UBGraphicsMediaItem::setInitialPos(qint64 p)
 {
     mInitialPos = p;
@@ -95,6 +95,7 @@ public:
 
     // Setters
     virtual void setMediaFileUrl(QUrl url);
+    void reloadMedia();
     void setInitialPos(qint64 p);
     void setMediaPos(qint64 p);
     virtual void setSourceUrl(const QUrl &pSourceUrl);
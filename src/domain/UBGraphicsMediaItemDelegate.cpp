@@ -294,6 +294,11 @@ void UBGraphicsMediaItemDelegate::showHide(bool show)
 {
     QVariant showFlag = QVariant(show ? UBItemLayerType::Object : UBItemLayerType::Control);
     showHideRecurs(showFlag, mDelegated);
+
+    UBGraphicsScene *ubScene = castUBGraphicsScene();
+    if (ubScene)
+        ubScene->itemLayerChanged(mDelegated);
+
     mDelegated->update();
 
     emit showOnDisplayChanged(show);
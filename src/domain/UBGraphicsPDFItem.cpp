@@ -49,6 +49,7 @@ UBGraphicsPDFItem::UBGraphicsPDFItem(PDFRenderer *renderer, int pageNumber, QGra
 
 UBGraphicsPDFItem::~UBGraphicsPDFItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 
@@ -102,6 +103,14 @@ void UBGraphicsPDFItem::paint(QPainter *painter, const QStyleOptionGraphicsItem
     Delegate()->postpaint(painter, option, widget);
 }
 
+bool UBGraphicsPDFItem::rendersProgressively() const
+{
+    // thumbnails and exports need the final rendering
+    UBGraphicsScene* pScene = qobject_cast<UBGraphicsScene*>(QGraphicsItem::scene());
+
+    return pScene && pScene->renderingContext() == UBGraphicsScene::Screen;
+}
+
 UBItem* UBGraphicsPDFItem::deepCopy() const
 {
     UBGraphicsPDFItem *copy =  new UBGraphicsPDFItem(mRenderer, mPageNumber, parentItem());
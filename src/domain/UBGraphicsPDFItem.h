@@ -73,6 +73,7 @@ class UBGraphicsPDFItem: public GraphicsPDFItem, public UBItem, public UBGraphic
         virtual void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
 
         virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+        virtual bool rendersProgressively() const;
         virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
 
 };
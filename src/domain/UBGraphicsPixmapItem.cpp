@@ -38,6 +38,7 @@
 #include "UBGraphicsItemDelegate.h"
 
 #include "frameworks/UBFileSystemUtils.h"
+#include "frameworks/UBExportImageCache.h"
 
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
@@ -46,8 +47,65 @@
 
 #include "core/memcheck.h"
 
+// below this zoom the pixmap is drawn from a downscaled level
+static const qreal lodThreshold = 0.5;
+static const int lodMaxLevel = 5;
+static const int lodMinLevelSize = 16;
+// smallest fraction of its native size an image source gets decoded at
+static const qreal minDecodeScale = 1.0 / 16;
+
+static qreal quantizedDecodeScale(qreal scale)
+{
+    qreal quantized = 1.0;
+
+    while (quantized / 2 >= scale && quantized / 2 >= minDecodeScale)
+        quantized /= 2;
+
+    return quantized;
+}
+
+/*
+ * Drag data of a pixmap item. The full resolution image is only read from the
+ * image source when a drop target asks for it, not each time the item is clicked.
+ */
+class UBPixmapItemMimeData : public QMimeData
+{
+    public:
+        UBPixmapItemMimeData(UBGraphicsPixmapItem* item)
+            : mItem(item)
+        {
+            // NOOP
+        }
+
+        virtual QStringList formats() const
+        {
+            return QStringList() << "application/x-qt-image";
+        }
+
+    protected:
+        virtual QVariant retrieveData(const QString& mimeType, QVariant::Type type) const
+        {
+            if (mimeType != "application/x-qt-image")
+                return QMimeData::retrieveData(mimeType, type);
+
+            if (mImage.isNull() && mItem)
+                mImage = mItem->fullResolutionPixmap().toImage();
+
+            return mImage;
+        }
+
+    private:
+        QPointer<UBGraphicsPixmapItem> mItem;
+        mutable QImage mImage;
+};
+
 UBGraphicsPixmapItem::UBGraphicsPixmapItem(QGraphicsItem* parent)
     : QGraphicsPixmapItem(parent)
+    , mLodSourceKey(0)
+    , mDecodedKey(0)
+    , mRequestedScale(1.0)
+    , mUpgradePending(false)
+    , mDecodePending(false)
 {
     setDelegate(new UBGraphicsItemDelegate(this, 0, GF_COMMON
                                            | GF_FLIPPABLE_ALL_AXIS
@@ -66,6 +124,7 @@ UBGraphicsPixmapItem::UBGraphicsPixmapItem(QGraphicsItem* parent)
 
 UBGraphicsPixmapItem::~UBGraphicsPixmapItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 QVariant UBGraphicsPixmapItem::itemChange(GraphicsItemChange change, const QVariant &value)
@@ -82,14 +141,17 @@ void UBGraphicsPixmapItem::setUuid(const QUuid &pUuid)
 
 void UBGraphicsPixmapItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
-    QMimeData* pMime = new QMimeData();
-    pMime->setImageData(pixmap().toImage());
-    Delegate()->setMimeData(pMime);
-    qreal k = (qreal)pixmap().width() / 100.0;
+    Delegate()->setMimeData(new UBPixmapItemMimeData(this));
 
-    QSize newSize((int)(pixmap().width() / k), (int)(pixmap().height() / k));
+    // while the picture is decoded the placeholder is null, the drag then goes without a pixmap
+    if (!pixmap().isNull())
+    {
+        qreal k = (qreal)pixmap().width() / 100.0;
 
-    Delegate()->setDragPixmap(pixmap().scaled(newSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+        QSize newSize((int)(pixmap().width() / k), (int)(pixmap().height() / k));
+
+        Delegate()->setDragPixmap(pixmap().scaled(newSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    }
 
     if (Delegate()->mousePressEvent(event))
     {
@@ -128,13 +190,216 @@ void UBGraphicsPixmapItem::paint(QPainter *painter, const QStyleOptionGraphicsIt
     QStyleOptionGraphicsItem styleOption = QStyleOptionGraphicsItem(*option);
 
     styleOption.state &= ~QStyle::State_Selected;
-    QGraphicsPixmapItem::paint(painter, &styleOption, widget);
+
+    qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    if (isImageSourceBacked() && pixmap().isNull())
+    {
+        // still being decoded
+        painter->fillRect(boundingRect(), QColor(128, 128, 128, 64));
+        Delegate()->postpaint(painter, option, widget);
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        return;
+    }
+
+    UBExportImageCache* exportImageCache = scene() ? scene()->exportImageCache() : 0;
+
+    if (exportImageCache && painter->device())
+    {
+        // size covered on the output, the cache downsamples and shares the pixmap from it
+        QRectF paintedRect = QRectF(offset(), nativeSize());
+        QSizeF paintedSize = painter->worldTransform().mapRect(paintedRect).size() / painter->device()->logicalDpiX();
+
+        QPixmap exportedPixmap = isImageSourceBacked()
+                ? exportImageCache->sharedSourcePixmap(mImageSource, mNativeSize, paintedSize)
+                : exportImageCache->sharedPixmap(pixmap(), paintedSize);
+
+        if (exportedPixmap.isNull())
+            exportedPixmap = pixmap();
+
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, transformationMode() == Qt::SmoothTransformation);
+        painter->drawPixmap(paintedRect, exportedPixmap, QRectF(exportedPixmap.rect()));
+
+        Delegate()->postpaint(painter, option, widget);
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        return;
+    }
+
+    if (isReduced() && !mUpgradePending && !mDecodePending && lod > (qreal)pixmap().width() / mNativeSize.width())
+    {
+        // painted bigger than decoded, get a sharper version outside of the paint event
+        mRequestedScale = quantizedDecodeScale(qMin(1.0, lod));
+        mUpgradePending = true;
+        UBDecodingQueue::queue()->decode(this, this, UBDecodingQueue::DecodeImage, mImageSource, mRequestedScale);
+    }
+
+    // level of detail relative to the decoded pixmap
+    qreal pixmapLod = pixmap().isNull() ? lod : lod * boundingRect().width() / pixmap().width();
+
+    if (pixmapLod > 0 && pixmapLod < lodThreshold && !pixmap().isNull())
+    {
+        int level = qMin(lodMaxLevel, (int)(log(1.0 / pixmapLod) / log(2.0)));
+        QPixmap levelPixmap = lodPixmap(level);
+
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, transformationMode() == Qt::SmoothTransformation);
+        painter->drawPixmap(boundingRect(), levelPixmap, QRectF(levelPixmap.rect()));
+    }
+    else if (isReduced())
+    {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, transformationMode() == Qt::SmoothTransformation);
+        painter->drawPixmap(boundingRect(), pixmap(), QRectF(pixmap().rect()));
+    }
+    else
+    {
+        QGraphicsPixmapItem::paint(painter, &styleOption, widget);
+    }
+
     Delegate()->postpaint(painter, option, widget);
 
     painter->setRenderHint(QPainter::Antialiasing, true);
 }
 
 
+void UBGraphicsPixmapItem::reloadImageSource()
+{
+    if (mImageSource.isEmpty())
+        return;
+
+    // decoded at the size the image is displayed, like when the page is read
+    QTransform itemTransform = transform();
+    qreal displayScale = qSqrt(itemTransform.m11() * itemTransform.m11() + itemTransform.m12() * itemTransform.m12());
+
+    setImageSource(mImageSource, displayScale, true);
+}
+
+
+bool UBGraphicsPixmapItem::isImageSourceBacked() const
+{
+    // a pixmap set directly with setPixmap replaces the image source
+    return !mImageSource.isEmpty() && pixmap().cacheKey() == mDecodedKey;
+}
+
+
+bool UBGraphicsPixmapItem::isReduced() const
+{
+    return isImageSourceBacked() && pixmap().size() != mNativeSize;
+}
+
+
+QSize UBGraphicsPixmapItem::nativeSize() const
+{
+    return isImageSourceBacked() ? mNativeSize : pixmap().size();
+}
+
+
+QRectF UBGraphicsPixmapItem::boundingRect() const
+{
+    if (!isReduced())
+        return QGraphicsPixmapItem::boundingRect();
+
+    return QRectF(offset(), mNativeSize);
+}
+
+
+QPainterPath UBGraphicsPixmapItem::shape() const
+{
+    if (!isReduced())
+        return QGraphicsPixmapItem::shape();
+
+    QPainterPath path;
+    path.addRect(boundingRect());
+
+    return path;
+}
+
+
+void UBGraphicsPixmapItem::setImageSource(const QString& path, qreal decodeScale, bool asynchronous)
+{
+    mImageSource = path;
+    mNativeSize = QImageReader(path).size();
+
+    // some formats cannot tell their size without decoding
+    qreal scale = mNativeSize.isValid() ? quantizedDecodeScale(decodeScale) : 1.0;
+
+    if (asynchronous && mNativeSize.isValid())
+    {
+        // the native size is known, so the geometry is right while the placeholder is shown
+        mDecodePending = true;
+        mRequestedScale = scale;
+        setDecodedPixmap(QPixmap());
+
+        UBDecodingQueue::queue()->decode(this, this, UBDecodingQueue::DecodeImage, path, scale);
+        return;
+    }
+
+    QImage image = UBDecodingQueue::decodeImage(path, scale);
+
+    if (!mNativeSize.isValid())
+        mNativeSize = image.size();
+
+    setDecodedPixmap(QPixmap::fromImage(image));
+}
+
+
+void UBGraphicsPixmapItem::decodingFinished(const UBDecodedContent& content)
+{
+    mDecodePending = false;
+    mUpgradePending = false;
+
+    // the pixmap was replaced while decoding
+    if (content.path != mImageSource || !isImageSourceBacked())
+        return;
+
+    // an upgrade never replaces a sharper pixmap decoded in the meantime
+    if (!content.image.isNull() && content.image.width() > pixmap().width())
+        setDecodedPixmap(QPixmap::fromImage(content.image));
+}
+
+
+void UBGraphicsPixmapItem::setDecodedPixmap(const QPixmap& decoded)
+{
+    setPixmap(decoded);
+    mDecodedKey = pixmap().cacheKey();
+}
+
+
+QPixmap UBGraphicsPixmapItem::fullResolutionPixmap() const
+{
+    if (!isReduced())
+        return pixmap();
+
+    QPixmap full(mImageSource);
+
+    return full.isNull() ? pixmap() : full;
+}
+
+
+QPixmap UBGraphicsPixmapItem::lodPixmap(int level)
+{
+    if (pixmap().cacheKey() != mLodSourceKey)
+    {
+        mLodPixmaps.clear();
+        mLodSourceKey = pixmap().cacheKey();
+    }
+
+    if (mLodPixmaps.isEmpty())
+        mLodPixmaps << pixmap();
+
+    // each level is computed once from the previous one
+    while (mLodPixmaps.size() <= level)
+    {
+        const QPixmap& previous = mLodPixmaps.last();
+
+        if (previous.width() / 2 < lodMinLevelSize || previous.height() / 2 < lodMinLevelSize)
+            break;
+
+        mLodPixmaps << previous.scaled(previous.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    return mLodPixmaps.at(qMin(level, mLodPixmaps.size() - 1));
+}
+
+
 UBItem* UBGraphicsPixmapItem::deepCopy() const
 {
    UBGraphicsPixmapItem* copy = new UBGraphicsPixmapItem();
@@ -154,6 +419,16 @@ void UBGraphicsPixmapItem::copyItemParameters(UBItem *copy) const
     if (cp)
     {
         cp->setPixmap(this->pixmap());
+        if (mDecodePending)
+        {
+            cp->setImageSource(mImageSource, mRequestedScale, true);
+        }
+        else if (isImageSourceBacked())
+        {
+            cp->mImageSource = mImageSource;
+            cp->mNativeSize = mNativeSize;
+            cp->mDecodedKey = cp->pixmap().cacheKey();
+        }
         cp->setPos(this->pos());
         cp->setTransform(this->transform());
         cp->setFlag(QGraphicsItem::ItemIsMovable, true);
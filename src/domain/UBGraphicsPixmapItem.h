@@ -36,9 +36,11 @@
 
 #include "UBItem.h"
 
+#include "frameworks/UBDecodingQueue.h"
+
 class UBGraphicsItemDelegate;
 
-class UBGraphicsPixmapItem : public QObject, public QGraphicsPixmapItem, public UBItem, public UBGraphicsItem
+class UBGraphicsPixmapItem : public QObject, public QGraphicsPixmapItem, public UBItem, public UBGraphicsItem, public UBDecodingTarget
 {
     Q_OBJECT
 
@@ -67,6 +69,29 @@ class UBGraphicsPixmapItem : public QObject, public QGraphicsPixmapItem, public
 
         virtual void setUuid(const QUuid &pUuid);
 
+        virtual QRectF boundingRect() const;
+        virtual QPainterPath shape() const;
+
+        /*
+         * Backs the item with an image file. The file is decoded at decodeScale of its
+         * native size (rounded up to a power of two fraction) and decoded again at a
+         * higher resolution when the item gets painted bigger than that.
+         * Asynchronous decoding shows a placeholder until the decoding queue delivers the image.
+         */
+        void setImageSource(const QString& path, qreal decodeScale = 1.0, bool asynchronous = false);
+        QString imageSource() const
+        {
+            return mImageSource;
+        }
+
+        // the file showed up after the item was read, e.g. extracted late from an imported document
+        void reloadImageSource();
+
+        QSize nativeSize() const;
+        QPixmap fullResolutionPixmap() const;
+
+        virtual void decodingFinished(const UBDecodedContent& content);
+
 protected:
 
         virtual void mousePressEvent(QGraphicsSceneMouseEvent *event);
@@ -76,6 +101,25 @@ protected:
         virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
         virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
+    private:
+
+        QPixmap lodPixmap(int level);
+
+        bool isImageSourceBacked() const;
+        bool isReduced() const;
+        void setDecodedPixmap(const QPixmap& pixmap);
+
+        QString mImageSource;
+        QSize mNativeSize;
+        qint64 mDecodedKey;
+        qreal mRequestedScale;
+        bool mUpgradePending;
+        bool mDecodePending;
+
+        // downscaled copies of the pixmap used when zoomed out, index n is the pixmap halved n times
+        QVector<QPixmap> mLodPixmaps;
+        qint64 mLodSourceKey;
 };
 
 #endif /* UBGRAPHICSPIXMAPITEM_H_ */
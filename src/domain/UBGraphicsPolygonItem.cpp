@@ -36,6 +36,12 @@
 
 #include "core/memcheck.h"
 
+// below this zoom the outline is drawn from a decimated polygon
+static const qreal lodThreshold = 0.5;
+// items smaller than this on screen (in pixels) are drawn as a plain rectangle
+static const qreal lodTinyItemSize = 2.0;
+static const int lodMaxLevel = 6;
+
 UBGraphicsPolygonItem::UBGraphicsPolygonItem (QGraphicsItem * parent)
     : QGraphicsPolygonItem(parent)
     , mHasAlpha(false)
@@ -111,6 +117,7 @@ void UBGraphicsPolygonItem::clearStroke()
 
 UBGraphicsPolygonItem::~UBGraphicsPolygonItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
     clearStroke();
 }
 
@@ -209,12 +216,55 @@ void UBGraphicsPolygonItem::copyItemParameters(UBItem *copy) const
 
 void UBGraphicsPolygonItem::paint ( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
+    // already painted as part of its stroke path
+    if (mpGroup && parentItem() == mpGroup && brush().isOpaque() && mpGroup->paintsOpaquePolygons())
+        return;
+
     if(mHasAlpha && scene() && scene()->isLightBackground())
         painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
 
     painter->setRenderHints(QPainter::Antialiasing);
 
-    QGraphicsPolygonItem::paint(painter, option, widget);
+    qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    if (lod >= lodThreshold)
+    {
+        QGraphicsPolygonItem::paint(painter, option, widget);
+        return;
+    }
+
+    QRectF bounds = boundingRect();
+
+    if (qMax(bounds.width(), bounds.height()) * lod < lodTinyItemSize)
+    {
+        // a couple of pixels on screen, the outline does not matter anymore
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->fillRect(bounds, brush());
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        return;
+    }
+
+    int level = qMin(lodMaxLevel, (int)(log(lodThreshold / lod) / log(2.0)));
+
+    painter->setPen(pen());
+    painter->setBrush(brush());
+    painter->drawPolygon(lodPolygon(level), fillRule());
+}
+
+
+QPolygonF UBGraphicsPolygonItem::lodPolygon(int level)
+{
+    if (mLodPolygons.size() <= level)
+        mLodPolygons.resize(level + 1);
+
+    if (mLodPolygons.at(level).isEmpty())
+    {
+        // about half a screen pixel at the zoom the level is used for
+        qreal tolerance = 0.5 * (1 << (level + 1));
+        mLodPolygons[level] = UBGeometryUtils::simplifyPolygon(polygon(), tolerance);
+    }
+
+    return mLodPolygons.at(level);
 }
 
 UBGraphicsScene* UBGraphicsPolygonItem::scene()
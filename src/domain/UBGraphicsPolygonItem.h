@@ -73,6 +73,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
                 {
                     mIsNominalLine = false;
                     QGraphicsPolygonItem::setPolygon(subtractedPolygon);
+                    mLodPolygons.clear();
                 }
             }
         }
@@ -85,6 +86,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
             {
                 mIsNominalLine = false;
                 QGraphicsPolygonItem::setPolygon(subtractedPolygon);
+                mLodPolygons.clear();
             }
         }
 
@@ -99,6 +101,7 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         {
             mIsNominalLine = false;
             QGraphicsPolygonItem::setPolygon(pPolygon);
+            mLodPolygons.clear();
         }
 
         virtual UBItem* deepCopy() const;
@@ -142,6 +145,8 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
 
         void clearStroke();
 
+        QPolygonF lodPolygon(int level);
+
         bool mHasAlpha;
 
         QLineF mOriginalLine;
@@ -154,6 +159,9 @@ class UBGraphicsPolygonItem : public QGraphicsPolygonItem, public UBItem
         UBGraphicsStroke* mStroke;
         UBGraphicsStrokesGroup* mpGroup;
 
+        // decimated outlines used when zoomed out, index n is for a zoom of 1/2^(n+1)
+        QVector<QPolygonF> mLodPolygons;
+
 };
 
 #endif // UBGRAPHICSPOLYGONITEM_H
@@ -58,6 +58,7 @@ UBGraphicsProxyWidget::UBGraphicsProxyWidget(QGraphicsItem* parent)
 
 UBGraphicsProxyWidget::~UBGraphicsProxyWidget()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 void UBGraphicsProxyWidget::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
@@ -44,6 +44,7 @@
 #include "core/UBDisplayManager.h"
 #include "core/UBPersistenceManager.h"
 #include "core/UBTextTools.h"
+#include "core/UBMimeData.h"
 
 #include "gui/UBMagnifer.h"
 #include "gui/UBMainWindow.h"
@@ -75,6 +76,7 @@
 #include "UBGraphicsTextItem.h"
 #include "UBGraphicsStrokesGroup.h"
 #include "UBSelectionFrame.h"
+#include "UBBackgroundGrid.h"
 #include "UBGraphicsItemZLevelUndoCommand.h"
 
 #include "domain/UBGraphicsGroupContainerItem.h"
@@ -327,6 +329,7 @@ UBGraphicsScene::UBGraphicsScene(UBDocumentProxy* parent, bool enableUndoRedoSta
     , mInputDeviceIsPressed(false)
     , mArcPolygonItem(0)
     , mRenderingContext(Screen)
+    , mExportImageCache(0)
     , mCurrentStroke(0)
     , mItemCount(0)
     , mUndoRedoStackEnabled(enableUndoRedoStack)
@@ -336,6 +339,7 @@ UBGraphicsScene::UBGraphicsScene(UBDocumentProxy* parent, bool enableUndoRedoSta
     , mpLastPolygon(NULL)
     , mCurrentPolygon(0)
     , mSelectionFrame(0)
+    , mUndoStack(0)
 {
     UBCoreGraphicsScene::setObjectName("BoardScene");
     setItemIndexMethod(BspTreeIndex);
@@ -355,11 +359,23 @@ UBGraphicsScene::UBGraphicsScene(UBDocumentProxy* parent, bool enableUndoRedoSta
 
 //    Just for debug. Do not delete please
 //    connect(this, SIGNAL(selectionChanged()), this, SLOT(selectionChangedProcessing()));
-    connect(UBApplication::undoStack.data(), SIGNAL(indexChanged(int)), this, SLOT(updateSelectionFrameWrapper(int)));
 }
 
 UBGraphicsScene::~UBGraphicsScene()
 {
+    // the commands reference items of this scene, they go first; the items only
+    // the history still holds are freed with their media, as on a page change
+    if (mUndoStack)
+    {
+        clearUndoHistory();
+
+        if (UBApplication::undoStack == mUndoStack)
+            UBApplication::setActiveUndoStack(0);
+
+        delete mUndoStack;
+        mUndoStack = 0;
+    }
+
     if (mCurrentStroke && mCurrentStroke->polygons().empty()){
         delete mCurrentStroke;
         mCurrentStroke = NULL;
@@ -639,8 +655,7 @@ bool UBGraphicsScene::inputDeviceRelease()
         if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
             UBGraphicsItemUndoCommand* udcmd = new UBGraphicsItemUndoCommand(this, mRemovedItems, mAddedItems); //deleted by the undoStack
 
-            if(UBApplication::undoStack)
-                UBApplication::undoStack->push(udcmd);
+            undoStack()->push(udcmd);
         }
 
         mRemovedItems.clear();
@@ -1128,6 +1143,141 @@ void UBGraphicsScene::updateSelectionFrame()
     }
 }
 
+QUndoStack* UBGraphicsScene::undoStack()
+{
+    if (!mUndoStack)
+    {
+        mUndoStack = new QUndoStack(this);
+        connect(mUndoStack, SIGNAL(indexChanged(int)), this, SLOT(updateSelectionFrameWrapper(int)));
+    }
+
+    return mUndoStack;
+}
+
+void UBGraphicsScene::findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem*> &itms)
+{
+    if (parent->childCount()) {
+        for (int i = 0; i < parent->childCount(); i++) {
+            findUniquesItems(parent->child(i), itms);
+        }
+    }
+
+    // Undo command transaction macros. Process separatedly
+    if (parent->text() == UBSettings::undoCommandTransactionName) {
+        return;
+    }
+
+    const UBUndoCommand *undoCmd = static_cast<const UBUndoCommand*>(parent);
+    if(undoCmd->getType() != UBUndoType::undotype_GRAPHICITEM)
+        return;
+
+    const UBGraphicsItemUndoCommand *cmd = dynamic_cast<const UBGraphicsItemUndoCommand*>(parent);
+
+    // go through all added and removed objects, for create list of unique objects
+    // grouped items will be deleted by groups, so we don't need do delete that items.
+    QSetIterator<QGraphicsItem*> itAdded(cmd->GetAddedList());
+    while (itAdded.hasNext())
+    {
+        QGraphicsItem* item = itAdded.next();
+        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
+            itms.insert(item);
+    }
+
+    QSetIterator<QGraphicsItem*> itRemoved(cmd->GetRemovedList());
+    while (itRemoved.hasNext())
+    {
+        QGraphicsItem* item = itRemoved.next();
+        if( !itms.contains(item) && !(item->parentItem() && UBGraphicsGroupContainerItem::Type == item->parentItem()->type()))
+            itms.insert(item);
+    }
+}
+
+void UBGraphicsScene::clearUndoHistory()
+{
+    QUndoStack* undoStack = this->undoStack();
+
+    QSet<QGraphicsItem*> uniqueItems;
+    // go through all stack command
+    for (int i = 0; i < undoStack->count(); i++) {
+        findUniquesItems(undoStack->command(i), uniqueItems);
+    }
+
+    // Get items from clipboard in order not to delete an item that was cut
+    // (using source URL of graphics items as a surrogate for equality testing)
+    // This ensures that we can cut and paste a media item, widget, etc. from one page to the next.
+    QClipboard *clipboard = QApplication::clipboard();
+    const QMimeData* data = clipboard->mimeData();
+    QList<QUrl> sourceURLs;
+
+    if (data && data->hasFormat(UBApplication::mimeTypeUniboardPageItem)) {
+        const UBMimeDataGraphicsItem* mimeDataGI = qobject_cast <const UBMimeDataGraphicsItem*>(data);
+
+        if (mimeDataGI) {
+            foreach (UBItem* sourceItem, mimeDataGI->items()) {
+                sourceURLs << sourceItem->sourceUrl();
+            }
+        }
+    }
+
+    // go through all unique items, and check, if they are on scene, or not.
+    // if not on scene, than item can be deleted
+    QSetIterator<QGraphicsItem*> itUniq(uniqueItems);
+    while (itUniq.hasNext())
+    {
+        QGraphicsItem* item = itUniq.next();
+        UBGraphicsScene *scene = NULL;
+        if (item->scene()) {
+            scene = dynamic_cast<UBGraphicsScene*>(item->scene());
+        }
+
+        bool inClipboard = false;
+        UBItem* ubi = dynamic_cast<UBItem*>(item);
+        if (ubi && sourceURLs.contains(ubi->sourceUrl()))
+            inClipboard = true;
+
+        if(!scene && !inClipboard)
+        {
+            if (!deleteItem(item)){
+                delete item;
+                item = 0;
+            }
+        }
+    }
+
+    // clear stack, and command list
+    undoStack->clear();
+}
+
+qint64 UBGraphicsScene::undoHistorySize()
+{
+    QUndoStack* undoStack = this->undoStack();
+
+    QSet<QGraphicsItem*> uniqueItems;
+    for (int i = 0; i < undoStack->count(); i++) {
+        findUniquesItems(undoStack->command(i), uniqueItems);
+    }
+
+    // decoded pixmaps dominate, the other items are counted at a flat rate
+    qint64 size = 0;
+
+    foreach (QGraphicsItem* item, uniqueItems)
+    {
+        if (item->scene())
+            continue;
+
+        UBGraphicsPixmapItem* pixmapItem = qgraphicsitem_cast<UBGraphicsPixmapItem*>(item);
+        if (pixmapItem)
+        {
+            QPixmap pixmap = pixmapItem->pixmap();
+            size += (qint64)pixmap.width() * pixmap.height() * pixmap.depth() / 8;
+        }
+
+        size += 1024;
+    }
+
+    return size;
+}
+
 void UBGraphicsScene::updateSelectionFrameWrapper(int)
 {
     updateSelectionFrame();
@@ -1312,7 +1462,7 @@ void UBGraphicsScene::clearContent(clearCase pCase)
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
 
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, removedItems, QSet<QGraphicsItem*>(), groupsMap);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     if (pCase == clearBackground) {
@@ -1338,7 +1488,7 @@ UBGraphicsPixmapItem* UBGraphicsScene::addPixmap(const QPixmap& pPixmap, QGraphi
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, replaceFor, pixmapItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     pixmapItem->setTransform(QTransform::fromScale(pScaleFactor, pScaleFactor), true);
@@ -1373,7 +1523,7 @@ UBGraphicsPixmapItem* UBGraphicsScene::addPixmap(const QPixmap& pPixmap, QGraphi
         QDir dir;
         dir.mkdir(documentPath + "/" + UBPersistenceManager::imageDirectory);
 
-        pixmapItem->pixmap().toImage().save(path, "PNG");
+        pixmapItem->fullResolutionPixmap().toImage().save(path, "PNG");
     }
 
     return pixmapItem;
@@ -1383,7 +1533,7 @@ void UBGraphicsScene::textUndoCommandAdded(UBGraphicsTextItem *textItem)
 {
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsTextItemUndoCommand* uc = new UBGraphicsTextItemUndoCommand(textItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 }
 UBGraphicsMediaItem* UBGraphicsScene::addMedia(const QUrl& pMediaFileUrl, bool shouldPlayAsap, const QPointF& pPos)
@@ -1409,7 +1559,7 @@ UBGraphicsMediaItem* UBGraphicsScene::addMedia(const QUrl& pMediaFileUrl, bool s
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, mediaItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     if (shouldPlayAsap)
@@ -1487,7 +1637,7 @@ void UBGraphicsScene::addGraphicsWidget(UBGraphicsWidgetItem* graphicsWidget, co
         graphicsWidget->setSelected(true);
         if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
             UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, graphicsWidget);
-            UBApplication::undoStack->push(uc);
+            undoStack()->push(uc);
         }
 
         setDocumentUpdated();
@@ -1553,7 +1703,7 @@ UBGraphicsGroupContainerItem *UBGraphicsScene::createGroup(QList<QGraphicsItem *
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemGroupUndoCommand* uc = new UBGraphicsItemGroupUndoCommand(this, groupItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     setDocumentUpdated();
@@ -1582,7 +1732,7 @@ void UBGraphicsScene::addGroup(UBGraphicsGroupContainerItem *groupItem)
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, groupItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     setDocumentUpdated();
@@ -1612,7 +1762,7 @@ UBGraphicsSvgItem* UBGraphicsScene::addSvg(const QUrl& pSvgFileUrl, const QPoint
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, svgItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     setDocumentUpdated();
@@ -1693,7 +1843,7 @@ UBGraphicsTextItem* UBGraphicsScene::addTextWithFont(const QString& pString, con
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, textItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     connect(textItem, SIGNAL(textUndoCommandAdded(UBGraphicsTextItem *)), this, SLOT(textUndoCommandAdded(UBGraphicsTextItem *)));
@@ -1717,7 +1867,7 @@ UBGraphicsTextItem *UBGraphicsScene::addTextHtml(const QString &pString, const Q
 
     if (mUndoRedoStackEnabled) { //should be deleted after scene own undo stack implemented
         UBGraphicsItemUndoCommand* uc = new UBGraphicsItemUndoCommand(this, 0, textItem);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     connect(textItem, SIGNAL(textUndoCommandAdded(UBGraphicsTextItem *)), this, SLOT(textUndoCommandAdded(UBGraphicsTextItem *)));
@@ -1750,6 +1900,8 @@ void UBGraphicsScene::addItem(QGraphicsItem* item)
       ++mItemCount;
 
     mFastAccessItems << item;
+
+    indexItemLayers(item);
 }
 
 void UBGraphicsScene::addItems(const QSet<QGraphicsItem*>& items)
@@ -1757,6 +1909,7 @@ void UBGraphicsScene::addItems(const QSet<QGraphicsItem*>& items)
     foreach(QGraphicsItem* item, items) {
         UBCoreGraphicsScene::addItem(item);
         UBGraphicsItem::assignZValue(item, mZLayerController->generateZLevel(item));
+        indexItemLayers(item);
     }
 
     mItemCount += items.size();
@@ -1774,6 +1927,7 @@ void UBGraphicsScene::removeItem(QGraphicsItem* item)
       --mItemCount;
 
     mFastAccessItems.removeAll(item);
+    unindexItemLayers(item);
     /* delete the item if it is cache to allow its reinstanciation, because Cache implements design pattern Singleton. */
     if (dynamic_cast<UBGraphicsCache*>(item))
         UBCoreGraphicsScene::deleteItem(item);
@@ -1786,8 +1940,10 @@ void UBGraphicsScene::removeItems(const QSet<QGraphicsItem*>& items)
 
     mItemCount -= items.size();
 
-    foreach(QGraphicsItem* item, items)
+    foreach(QGraphicsItem* item, items) {
         mFastAccessItems.removeAll(item);
+        unindexItemLayers(item);
+    }
 }
 
 void UBGraphicsScene::deselectAllItems()
@@ -1852,7 +2008,7 @@ QGraphicsItem* UBGraphicsScene::setAsBackgroundObject(QGraphicsItem* item, bool
         item->setFlag(QGraphicsItem::ItemIsSelectable, false);
         item->setFlag(QGraphicsItem::ItemIsMovable, false);
         item->setAcceptedMouseButtons(Qt::NoButton);
-        item->setData(UBGraphicsItemData::ItemLayerType, UBItemLayerType::FixedBackground);
+        UBGraphicsItem::assignLayer(item, UBItemLayerType::FixedBackground);
 
         if (pAdaptTransformation)
         {
@@ -2145,13 +2301,14 @@ void UBGraphicsScene::addCompass(QPointF center)
 {
     UBGraphicsCompass* compass = new UBGraphicsCompass(); // mem : owned and destroyed by the scene
     mTools << compass;
+
+    compass->setData(UBGraphicsItemData::ItemLayerType, QVariant(UBItemLayerType::Tool));
+
     addItem(compass);
 
     QRectF rect = compass->rect();
     compass->setRect(center.x() - rect.width() / 2, center.y() - rect.height() / 2, rect.width(), rect.height());
 
-    compass->setData(UBGraphicsItemData::ItemLayerType, QVariant(UBItemLayerType::Tool));
-
     compass->setVisible(true);
 }
 
@@ -2159,10 +2316,10 @@ void UBGraphicsScene::addCache()
 {
     UBGraphicsCache* cache = UBGraphicsCache::instance(this);
     if (!items().contains(cache)) {
-        addItem(cache);
-
         cache->setData(UBGraphicsItemData::ItemLayerType, QVariant(UBItemLayerType::Tool));
 
+        addItem(cache);
+
         cache->setVisible(true);
         cache->setSelected(true);
         UBApplication::boardController->notifyCache(true);
@@ -2252,6 +2409,37 @@ QList<QUrl> UBGraphicsScene::relativeDependencies() const
     return relativePathes;
 }
 
+void UBGraphicsScene::mediaFileExtracted(const QString& filePath)
+{
+    // the page was shown before this media of its imported document left the archive
+    QString cleanPath = QDir::cleanPath(filePath);
+
+    foreach (QGraphicsItem* item, items())
+    {
+        UBGraphicsPixmapItem* pixmapItem = qgraphicsitem_cast<UBGraphicsPixmapItem*>(item);
+        if (pixmapItem && QDir::cleanPath(pixmapItem->imageSource()) == cleanPath)
+        {
+            pixmapItem->reloadImageSource();
+            continue;
+        }
+
+        UBGraphicsSvgItem* svgItem = qgraphicsitem_cast<UBGraphicsSvgItem*>(item);
+        if (svgItem && mDocument)
+        {
+            QString svgPath = mDocument->persistencePath() + "/" + UBPersistenceManager::imageDirectory + "/" + svgItem->uuid().toString() + ".svg";
+
+            if (QDir::cleanPath(svgPath) == cleanPath)
+                svgItem->loadAsynchronously(filePath);
+
+            continue;
+        }
+
+        UBGraphicsMediaItem* mediaItem = dynamic_cast<UBGraphicsMediaItem*>(item);
+        if (mediaItem && QDir::cleanPath(mediaItem->mediaFileUrl().toLocalFile()) == cleanPath)
+            mediaItem->reloadMedia();
+    }
+}
+
 QSize UBGraphicsScene::nominalSize()
 {
     if (mDocument && !mNominalSize.isValid())
@@ -2319,7 +2507,7 @@ qreal UBGraphicsScene::changeZLevelTo(QGraphicsItem *item, UBZLayerController::m
 
     if(addUndo){
         UBGraphicsItemZLevelUndoCommand* uc = new UBGraphicsItemZLevelUndoCommand(this, item, previousZVal, dest);
-        UBApplication::undoStack->push(uc);
+        undoStack()->push(uc);
     }
 
     return res;
@@ -2337,60 +2525,107 @@ QGraphicsItem* UBGraphicsScene::rootItem(QGraphicsItem* item) const
     return root;
 }
 
-void UBGraphicsScene::drawItems (QPainter * painter, int numItems,
-        QGraphicsItem * items[], const QStyleOptionGraphicsItem options[], QWidget * widget)
+UBGraphicsScene::ItemRenderInfo UBGraphicsScene::computeRenderInfo(QGraphicsItem* item) const
 {
-    if (mRenderingContext == NonScreen || mRenderingContext == PdfExport)
-    {
-        int count = 0;
+    ItemRenderInfo info;
 
-        QGraphicsItem** itemsFiltered = new QGraphicsItem*[numItems];
-        QStyleOptionGraphicsItem *optionsFiltered = new QStyleOptionGraphicsItem[numItems];
+    info.type = item->type();
+    info.layer = item->data(UBGraphicsItemData::ItemLayerType).toInt(&info.hasLayer);
+    info.isTool = mTools.contains(rootItem(item));
+    info.isPDF = info.type == UBGraphicsPDFItem::Type;
 
-        for (int i = 0; i < numItems; i++)
-        {
-            if (!mTools.contains(rootItem(items[i])))
-            {
-                bool isPdfItem =  qgraphicsitem_cast<UBGraphicsPDFItem*> (items[i]) != NULL;
-                if(!isPdfItem || mRenderingContext == NonScreen)
-                {
-                    itemsFiltered[count] = items[i];
-                    optionsFiltered[count] = options[i];
-                    count++;
-                }
-            }
-        }
+    return info;
+}
+
+UBGraphicsScene::ItemRenderInfo UBGraphicsScene::renderInfo(QGraphicsItem* item)
+{
+    QHash<QGraphicsItem*, ItemRenderInfo>::iterator it = mItemRenderInfo.find(item);
 
-        QGraphicsScene::drawItems(painter, count, itemsFiltered, optionsFiltered, widget);
+    if (it != mItemRenderInfo.end())
+    {
+        // an item destroyed without unindexing leaves its entry to whatever item is
+        // allocated at the same address next, catch it in debug and repair it in release
+        Q_ASSERT(it->type == item->type());
 
-        delete[] optionsFiltered;
-        delete[] itemsFiltered;
+        if (it->type != item->type())
+            *it = computeRenderInfo(item);
 
+        return *it;
     }
-    else if (mRenderingContext == Podcast)
+
+    // items added behind our back (delegate frames and buttons) are not indexed, as nothing
+    // would tell us when they are destroyed
+    return computeRenderInfo(item);
+}
+
+void UBGraphicsScene::indexItemLayers(QGraphicsItem* item)
+{
+    mItemRenderInfo.insert(item, computeRenderInfo(item));
+
+    foreach (QGraphicsItem* child, item->childItems())
+        indexItemLayers(child);
+}
+
+void UBGraphicsScene::unindexItemLayers(QGraphicsItem* item)
+{
+    mItemRenderInfo.remove(item);
+
+    foreach (QGraphicsItem* child, item->childItems())
+        unindexItemLayers(child);
+}
+
+void UBGraphicsScene::itemLayerChanged(QGraphicsItem* item)
+{
+    if (item)
+        indexItemLayers(item);
+}
+
+void UBGraphicsScene::unindexItem(QGraphicsItem* item)
+{
+    if (item)
+        unindexItemLayers(item);
+}
+
+bool UBGraphicsScene::itemLayer(QGraphicsItem* item, int& layer)
+{
+    ItemRenderInfo info = renderInfo(item);
+    layer = info.layer;
+
+    return info.hasLayer;
+}
+
+void UBGraphicsScene::drawItems (QPainter * painter, int numItems,
+        QGraphicsItem * items[], const QStyleOptionGraphicsItem options[], QWidget * widget)
+{
+    if (mRenderingContext == NonScreen || mRenderingContext == PdfExport || mRenderingContext == Podcast)
     {
-        int count = 0;
+        if (mFilteredItems.size() < numItems)
+        {
+            mFilteredItems.resize(numItems);
+            mFilteredOptions.resize(numItems);
+        }
 
-        QGraphicsItem** itemsFiltered = new QGraphicsItem*[numItems];
-        QStyleOptionGraphicsItem *optionsFiltered = new QStyleOptionGraphicsItem[numItems];
+        int count = 0;
 
         for (int i = 0; i < numItems; i++)
         {
-            bool ok;
-            int itemLayerType = items[i]->data(UBGraphicsItemData::ItemLayerType).toInt(&ok);
-            if (ok && (itemLayerType >= UBItemLayerType::FixedBackground && itemLayerType <= UBItemLayerType::Tool))
+            ItemRenderInfo info = renderInfo(items[i]);
+            bool shouldDraw;
+
+            if (mRenderingContext == Podcast)
+                shouldDraw = info.hasLayer && (info.layer >= UBItemLayerType::FixedBackground && info.layer <= UBItemLayerType::Tool);
+            else
+                shouldDraw = !info.isTool && (!info.isPDF || mRenderingContext == NonScreen);
+
+            if (shouldDraw)
             {
-                itemsFiltered[count] = items[i];
-                optionsFiltered[count] = options[i];
+                mFilteredItems[count] = items[i];
+                mFilteredOptions[count] = options[i];
                 count++;
             }
         }
 
-        QGraphicsScene::drawItems(painter, count, itemsFiltered, optionsFiltered, widget);
-
-        delete[] optionsFiltered;
-        delete[] itemsFiltered;
-
+        QGraphicsScene::drawItems(painter, count, mFilteredItems.data(), mFilteredOptions.constData(), widget);
     }
     else
     {
@@ -2405,50 +2640,7 @@ void UBGraphicsScene::drawBackground(QPainter *painter, const QRectF &rect)
         QGraphicsScene::drawBackground (painter, rect);
         return;
     }
-    bool darkBackground = isDarkBackground ();
-
-    if (darkBackground)
-    {
-      painter->fillRect (rect, QBrush (QColor (Qt::black)));
-    }
-    else
-    {
-      painter->fillRect (rect, QBrush (QColor (Qt::white)));
-    }
-
-    if (mZoomFactor > 0.5)
-    {
-        QColor bgCrossColor;
-
-        if (darkBackground)
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorDarkBackground->get().toString());
-        else
-            bgCrossColor = QColor(UBSettings::settings()->boardCrossColorLightBackground->get().toString());
-        if (mZoomFactor < 1.0)
-        {
-            int alpha = 255 * mZoomFactor / 2;
-            bgCrossColor.setAlpha (alpha); // fade the crossing on small zooms
-        }
-
-        painter->setPen (bgCrossColor);
-
-        if (isCrossedBackground())
-        {
-            qreal firstY = ((int) (rect.y () / UBSettings::crossSize)) * UBSettings::crossSize;
-
-            for (qreal yPos = firstY; yPos < rect.y () + rect.height (); yPos += UBSettings::crossSize)
-            {
-                painter->drawLine (rect.x (), yPos, rect.x () + rect.width (), yPos);
-            }
-
-            qreal firstX = ((int) (rect.x () / UBSettings::crossSize)) * UBSettings::crossSize;
-
-            for (qreal xPos = firstX; xPos < rect.x () + rect.width (); xPos += UBSettings::crossSize)
-            {
-                painter->drawLine (xPos, rect.y (), xPos, rect.y () + rect.height ());
-            }
-        }
-    }
+    UBBackgroundGrid::grid()->draw(painter, rect, isDarkBackground(), isCrossedBackground(), mZoomFactor);
 }
 
 void UBGraphicsScene::keyReleaseEvent(QKeyEvent * keyEvent)
@@ -29,6 +29,7 @@
 #define UBGRAPHICSSCENE_H_
 
 #include <QtGui>
+#include <QUndoStack>
 
 #include "frameworks/UBCoreGraphicsScene.h"
 
@@ -60,6 +61,7 @@ class UBGraphicsCache;
 class UBGraphicsGroupContainerItem;
 class UBSelectionFrame;
 class UBBoardView;
+class UBExportImageCache;
 
 const double PI = 4.0 * atan(1.0);
 
@@ -300,13 +302,37 @@ class UBGraphicsScene: public UBCoreGraphicsScene, public UBItem
             return mRenderingContext;
         }
 
+        // set by exporters while rendering, so that pixmap items paint shared and downsampled images
+        void setExportImageCache(UBExportImageCache* pCache)
+        {
+            mExportImageCache = pCache;
+        }
+
+        UBExportImageCache* exportImageCache() const
+        {
+            return mExportImageCache;
+        }
+
+        // each page keeps its own undo history for as long as its scene lives
+        QUndoStack* undoStack();
+
+        // frees the off-scene items only the history still references, then clears it
+        void clearUndoHistory();
+        // rough memory held by those items
+        qint64 undoHistorySize();
+
         QSet<QGraphicsItem*> tools(){ return mTools;}
 
         void registerTool(QGraphicsItem* item)
         {
             mTools << item;
+            itemLayerChanged(item);
         }
 
+        bool itemLayer(QGraphicsItem* item, int& layer);
+        void itemLayerChanged(QGraphicsItem* item);
+        void unindexItem(QGraphicsItem* item);
+
         const QPointF& previousPoint()
         {
             return mPreviousPoint;
@@ -356,6 +382,8 @@ public slots:
         void changeMagnifierMode(int mode);
         void resizedMagnifier(qreal newPercent);
 
+        void mediaFileExtracted(const QString& filePath);
+
     protected:
 
         UBGraphicsPolygonItem* lineToPolygonItem(const QLineF& pLine, const qreal& pWidth);
@@ -387,6 +415,26 @@ public slots:
 
 
     private:
+        static void findUniquesItems(const QUndoCommand *parent, QSet<QGraphicsItem *> &itms);
+
+        // Rendering properties of an item, indexed when the item enters the scene so that
+        // the per-frame render filters need neither QVariant lookups nor parent walks.
+        // Entries are dropped when the item leaves the scene or is destroyed, see
+        // UBGraphicsItem::assignLayer() and UBGraphicsItem::forgetRenderInfo()
+        struct ItemRenderInfo
+        {
+            int type;
+            int layer;
+            bool hasLayer;
+            bool isTool;
+            bool isPDF;
+        };
+
+        ItemRenderInfo renderInfo(QGraphicsItem* item);
+        ItemRenderInfo computeRenderInfo(QGraphicsItem* item) const;
+        void indexItemLayers(QGraphicsItem* item);
+        void unindexItemLayers(QGraphicsItem* item);
+
         void setDocumentUpdated();
         void createEraiser();
         void createPointer();
@@ -427,6 +475,7 @@ public slots:
         QSize mNominalSize;
 
         RenderingContext mRenderingContext;
+        UBExportImageCache* mExportImageCache;
 
         UBGraphicsStroke* mCurrentStroke;
 
@@ -434,6 +483,12 @@ public slots:
 
         QList<QGraphicsItem*> mFastAccessItems; // a local copy as QGraphicsScene::items() is very slow in Qt 4.6
 
+        QHash<QGraphicsItem*, ItemRenderInfo> mItemRenderInfo;
+
+        // reused between frames by drawItems, they only grow
+        QVector<QGraphicsItem*> mFilteredItems;
+        QVector<QStyleOptionGraphicsItem> mFilteredOptions;
+
 
         bool mHasCache;
         //        tmp stub for divide addings scene objects from undo mechanism implementation
@@ -448,6 +503,7 @@ public slots:
         bool mDrawWithCompass;
         UBGraphicsPolygonItem *mCurrentPolygon;
         UBSelectionFrame *mSelectionFrame;
+        QUndoStack *mUndoStack;
 };
 
 
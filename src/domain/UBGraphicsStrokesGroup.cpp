@@ -31,6 +31,7 @@
 #include "UBGraphicsStroke.h"
 
 #include "domain/UBGraphicsPolygonItem.h"
+#include "domain/UBGraphicsScene.h"
 
 #include "core/memcheck.h"
 
@@ -56,6 +57,7 @@ UBGraphicsStrokesGroup::UBGraphicsStrokesGroup(QGraphicsItem *parent)
 
 UBGraphicsStrokesGroup::~UBGraphicsStrokesGroup()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 void UBGraphicsStrokesGroup::setUuid(const QUuid &pUuid)
@@ -208,12 +210,70 @@ void UBGraphicsStrokesGroup::paint(QPainter *painter, const QStyleOptionGraphics
     QStyle::State svState = option->state;
     styleOption.state &= ~QStyle::State_Selected;
     QGraphicsItemGroup::paint(painter, &styleOption, widget);
+
+    if (paintsOpaquePolygons())
+        paintPolygonsAsPaths(painter);
+
     //Restoring state
     styleOption.state |= svState;
 
     Delegate()->postpaint(painter, &styleOption, widget);
 }
 
+bool UBGraphicsStrokesGroup::paintsOpaquePolygons() const
+{
+    UBGraphicsScene* pScene = qobject_cast<UBGraphicsScene*>(QGraphicsItem::scene());
+
+    return pScene && (pScene->renderingContext() == UBGraphicsScene::NonScreen
+                      || pScene->renderingContext() == UBGraphicsScene::PdfExport);
+}
+
+void UBGraphicsStrokesGroup::paintPolygonsAsPaths(QPainter *painter)
+{
+    // a stroke is made of one polygon per segment; drawn one by one they end up as as many
+    // fill operations in a pdf, drawn as one path they are a single one
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+    QPen pen;
+    QBrush brush;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+
+    foreach(QGraphicsItem* item, childItems())
+    {
+        UBGraphicsPolygonItem* polygon = qgraphicsitem_cast<UBGraphicsPolygonItem*>(item);
+
+        if (!polygon || !polygon->isVisible() || !polygon->brush().isOpaque())
+            continue;
+
+        if (!path.isEmpty() && (polygon->pen() != pen || polygon->brush() != brush))
+        {
+            painter->setPen(pen);
+            painter->setBrush(brush);
+            painter->drawPath(path);
+
+            path = QPainterPath();
+            path.setFillRule(Qt::WindingFill);
+        }
+
+        pen = polygon->pen();
+        brush = polygon->brush();
+
+        path.addPolygon(polygon->mapToParent(polygon->polygon()));
+        path.closeSubpath();
+    }
+
+    if (!path.isEmpty())
+    {
+        painter->setPen(pen);
+        painter->setBrush(brush);
+        painter->drawPath(path);
+    }
+
+    painter->restore();
+}
+
 QVariant UBGraphicsStrokesGroup::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     if (debugTextEnabled && change == ItemZValueChange) {
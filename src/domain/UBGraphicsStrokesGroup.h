@@ -59,6 +59,9 @@ public:
     void setColor(const QColor &color, colorType pColorType = currentColor);
     QColor color(colorType pColorType = currentColor) const;
 
+    // in exports the group paints its opaque polygons as one path per run of polygons sharing pen and brush
+    bool paintsOpaquePolygons() const;
+
 protected:
 
     virtual QPainterPath shape () const;
@@ -69,6 +72,8 @@ protected:
     virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
     virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
 
+    void paintPolygonsAsPaths(QPainter *painter);
+
     // Graphical display of stroke Z-level
     bool debugTextEnabled;
     QGraphicsSimpleTextItem * mDebugText;
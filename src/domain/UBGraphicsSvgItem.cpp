@@ -34,6 +34,7 @@
 #include "UBGraphicsScene.h"
 #include "UBGraphicsItemDelegate.h"
 #include "UBGraphicsPixmapItem.h"
+#include "UBGraphicsGroupContainerItem.h"
 
 #include "core/UBApplication.h"
 #include "core/UBPersistenceManager.h"
@@ -44,8 +45,16 @@
 
 #include "core/memcheck.h"
 
+UBGraphicsSvgItem::UBGraphicsSvgItem(QGraphicsItem* parent)
+    : QGraphicsSvgItem(parent)
+    , mDecodePending(false)
+{
+    init();
+}
+
 UBGraphicsSvgItem::UBGraphicsSvgItem(const QString& pFilePath, QGraphicsItem* parent)
     : QGraphicsSvgItem(pFilePath, parent)
+    , mDecodePending(false)
 {
     init();
 
@@ -60,6 +69,7 @@ UBGraphicsSvgItem::UBGraphicsSvgItem(const QString& pFilePath, QGraphicsItem* pa
 
 UBGraphicsSvgItem::UBGraphicsSvgItem(const QByteArray& pFileData, QGraphicsItem* parent)
     : QGraphicsSvgItem(parent)
+    , mDecodePending(false)
 {
     init();
 
@@ -92,15 +102,45 @@ void UBGraphicsSvgItem::init()
 
 UBGraphicsSvgItem::~UBGraphicsSvgItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 
 QByteArray UBGraphicsSvgItem::fileData() const
 {
+    if (mDecodePending)
+        UBDecodingQueue::queue()->waitForTargetDecodes(this);
+
     return mFileData;
 }
 
 
+void UBGraphicsSvgItem::loadAsynchronously(const QString& pFilePath)
+{
+    mDecodePending = true;
+    UBDecodingQueue::queue()->decode(this, this, UBDecodingQueue::DecodeSvg, pFilePath);
+}
+
+
+void UBGraphicsSvgItem::decodingFinished(const UBDecodedContent& content)
+{
+    mDecodePending = false;
+    mFileData = content.data;
+
+    if (!content.renderer)
+        return;
+
+    content.renderer->setParent(this);
+    setSharedRenderer(content.renderer);
+    setMaximumCacheSize(boundingRect().size().toSize() * UB_MAX_ZOOM);
+
+    // the item got its size after being grouped
+    UBGraphicsGroupContainerItem* group = qgraphicsitem_cast<UBGraphicsGroupContainerItem*>(parentItem());
+    if (group)
+        group->childGeometryChanged(this);
+}
+
+
 QVariant UBGraphicsSvgItem::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     QVariant newValue = Delegate()->itemChange(change, value);
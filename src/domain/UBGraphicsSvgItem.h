@@ -37,12 +37,15 @@
 
 #include "core/UB.h"
 
+#include "frameworks/UBDecodingQueue.h"
+
 class UBGraphicsItemDelegate;
 class UBGraphicsPixmapItem;
 
-class UBGraphicsSvgItem: public QGraphicsSvgItem, public UBItem, public UBGraphicsItem
+class UBGraphicsSvgItem: public QGraphicsSvgItem, public UBItem, public UBGraphicsItem, public UBDecodingTarget
 {
     public:
+        UBGraphicsSvgItem(QGraphicsItem* parent = 0);
         UBGraphicsSvgItem(const QString& pFile, QGraphicsItem* parent = 0);
         UBGraphicsSvgItem(const QByteArray& pFileData, QGraphicsItem* parent = 0);
 
@@ -78,6 +81,10 @@ class UBGraphicsSvgItem: public QGraphicsSvgItem, public UBItem, public UBGraphi
 
         virtual void clearSource();
 
+        // the file is read and parsed by the decoding queue, the item is empty until then
+        void loadAsynchronously(const QString& pFilePath);
+        virtual void decodingFinished(const UBDecodedContent& content);
+
     protected:
 
         virtual void mousePressEvent(QGraphicsSceneMouseEvent *event);
@@ -89,6 +96,7 @@ class UBGraphicsSvgItem: public QGraphicsSvgItem, public UBItem, public UBGraphi
         virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value);
 
         QByteArray mFileData;
+        bool mDecodePending;
 };
 
 #endif /* UBGRAPHICSSVGITEM_H_ */
@@ -79,6 +79,7 @@ UBGraphicsTextItem::UBGraphicsTextItem(QGraphicsItem * parent)
 
 UBGraphicsTextItem::~UBGraphicsTextItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 void UBGraphicsTextItem::setSelected(bool selected)
@@ -109,7 +109,7 @@ UBGraphicsWidgetItem::UBGraphicsWidgetItem(const QUrl &pWidgetUrl, QGraphicsItem
 
 UBGraphicsWidgetItem::~UBGraphicsWidgetItem()
 {
-    /* NOOP */
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 void UBGraphicsWidgetItem::initialize()
@@ -77,6 +77,25 @@ void UBGraphicsItem::assignZValue(QGraphicsItem *item, qreal value)
     item->setData(UBGraphicsItemData::ItemOwnZValue, value);
 }
 
+void UBGraphicsItem::assignLayer(QGraphicsItem *item, int layer)
+{
+    item->setData(UBGraphicsItemData::ItemLayerType, QVariant(layer));
+
+    // setData() does not notify the item, so the scene render index has to be told
+    UBGraphicsScene *ubScene = dynamic_cast<UBGraphicsScene*>(item->scene());
+    if (ubScene)
+        ubScene->itemLayerChanged(item);
+}
+
+void UBGraphicsItem::forgetRenderInfo(QGraphicsItem *item)
+{
+    // to be called from the destructors of items that may be deleted while still in a scene,
+    // as QGraphicsItem does not notify its scene through any virtual on destruction
+    UBGraphicsScene *ubScene = dynamic_cast<UBGraphicsScene*>(item->scene());
+    if (ubScene)
+        ubScene->unindexItem(item);
+}
+
 bool UBGraphicsItem::isFlippable(QGraphicsItem *item)
 {
     return item->data(UBGraphicsItemData::ItemFlippable).toBool();
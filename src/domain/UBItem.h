@@ -116,6 +116,8 @@ public:
     UBGraphicsItemDelegate *Delegate() const;
 
     static void assignZValue(QGraphicsItem*, qreal value);
+    static void assignLayer(QGraphicsItem* item, int layer);
+    static void forgetRenderInfo(QGraphicsItem* item);
     static bool isRotatable(QGraphicsItem *item);
     static bool isFlippable(QGraphicsItem *item);
     static bool isLocked(QGraphicsItem *item);
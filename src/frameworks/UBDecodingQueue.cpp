@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBDecodingQueue.h"
+
+#include <QSvgRenderer>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+
+#include "core/memcheck.h"
+
+UBDecodingQueue* UBDecodingQueue::sQueue = 0;
+
+
+class UBDecodingJob : public QRunnable
+{
+    public:
+        UBDecodingJob(UBDecodingQueue* queue, const UBDecodingQueue::Job& job)
+            : mQueue(queue)
+            , mJob(job)
+        {
+            // NOOP
+        }
+
+        virtual void run()
+        {
+            if (mJob.kind == UBDecodingQueue::DecodeImage)
+            {
+                mJob.content.image = UBDecodingQueue::decodeImage(mJob.content.path, mJob.scale);
+            }
+            else
+            {
+                QFile file(mJob.content.path);
+
+                if (file.open(QIODevice::ReadOnly))
+                {
+                    mJob.content.data = file.readAll();
+                    file.close();
+
+                    QSvgRenderer* renderer = new QSvgRenderer(mJob.content.data);
+                    renderer->moveToThread(QCoreApplication::instance()->thread());
+                    mJob.content.renderer = renderer;
+                }
+                else
+                {
+                    qWarning() << "cannot open svg file" << mJob.content.path;
+                }
+            }
+
+            mQueue->jobFinished(mJob);
+        }
+
+    private:
+        UBDecodingQueue* mQueue;
+        UBDecodingQueue::Job mJob;
+};
+
+
+UBDecodingQueue* UBDecodingQueue::queue()
+{
+    if (!sQueue)
+        sQueue = new UBDecodingQueue();
+
+    return sQueue;
+}
+
+
+void UBDecodingQueue::destroy()
+{
+    delete sQueue;
+    sQueue = 0;
+}
+
+
+UBDecodingQueue::UBDecodingQueue()
+    : QObject(0)
+    , mPendingJobs(0)
+{
+    // leave a core to the GUI thread
+    mPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+
+UBDecodingQueue::~UBDecodingQueue()
+{
+    mPool.waitForDone();
+
+    foreach (const Job& job, mFinishedJobs)
+        delete job.content.renderer;
+}
+
+
+QImage UBDecodingQueue::decodeImage(const QString& path, qreal scale)
+{
+    QImageReader reader(path);
+    QSize size = reader.size();
+
+    if (size.isValid() && scale < 1.0)
+    {
+        QSize scaledSize = (QSizeF(size) * scale).toSize().expandedTo(QSize(1, 1));
+        reader.setScaledSize(scaledSize);
+    }
+
+    QImage image = reader.read();
+
+    if (image.isNull())
+        qWarning() << "cannot decode image" << path << reader.errorString();
+
+    return image;
+}
+
+
+void UBDecodingQueue::decode(QObject* targetObject, UBDecodingTarget* target, DecodingKind kind, const QString& path, qreal scale)
+{
+    Job job;
+    job.targetObject = targetObject;
+    job.targetKey = targetObject;
+    job.target = target;
+    job.kind = kind;
+    job.scale = scale;
+    job.content.path = path;
+
+    {
+        QMutexLocker locker(&mMutex);
+        mPendingJobs++;
+        mRunningTargets[targetObject]++;
+    }
+
+    mPool.start(new UBDecodingJob(this, job));
+}
+
+
+void UBDecodingQueue::jobFinished(const Job& job)
+{
+    bool firstFinished;
+
+    {
+        QMutexLocker locker(&mMutex);
+        firstFinished = mFinishedJobs.isEmpty();
+        mFinishedJobs << job;
+
+        const QObject* targetObject = job.targetKey;
+        if (--mRunningTargets[targetObject] <= 0)
+            mRunningTargets.remove(targetObject);
+
+        mJobFinished.wakeAll();
+    }
+
+    // one delivery per batch of finished jobs
+    if (firstFinished)
+        QMetaObject::invokeMethod(this, "deliverDecodedContent", Qt::QueuedConnection);
+}
+
+
+void UBDecodingQueue::deliverDecodedContent()
+{
+    QList<Job> finishedJobs;
+
+    {
+        QMutexLocker locker(&mMutex);
+        finishedJobs = mFinishedJobs;
+        mFinishedJobs.clear();
+        mPendingJobs -= finishedJobs.size();
+    }
+
+    foreach (const Job& job, finishedJobs)
+    {
+        if (job.targetObject)
+            job.target->decodingFinished(job.content);
+        else
+            delete job.content.renderer;
+    }
+}
+
+
+bool UBDecodingQueue::hasPendingDecodes()
+{
+    QMutexLocker locker(&mMutex);
+    return mPendingJobs > 0;
+}
+
+
+void UBDecodingQueue::waitForPendingDecodes(QGraphicsScene* scene)
+{
+    if (!scene || !hasPendingDecodes())
+        return;
+
+    QSet<const QObject*> targetObjects;
+
+    foreach (QGraphicsItem* item, scene->items())
+    {
+        QObject* targetObject = dynamic_cast<QObject*>(item);
+        if (targetObject)
+            targetObjects.insert(targetObject);
+    }
+
+    waitForTargets(targetObjects);
+}
+
+
+void UBDecodingQueue::waitForTargetDecodes(const QObject* targetObject)
+{
+    if (!targetObject || !hasPendingDecodes())
+        return;
+
+    waitForTargets(QSet<const QObject*>() << targetObject);
+}
+
+
+void UBDecodingQueue::waitForTargets(const QSet<const QObject*>& targetObjects)
+{
+    {
+        QMutexLocker locker(&mMutex);
+
+        forever
+        {
+            bool running = false;
+
+            foreach (const QObject* runningTarget, mRunningTargets.keys())
+            {
+                if (targetObjects.contains(runningTarget))
+                {
+                    running = true;
+                    break;
+                }
+            }
+
+            if (!running)
+                break;
+
+            mJobFinished.wait(&mMutex);
+        }
+    }
+
+    // delivers the other finished jobs along, they are ready anyway
+    deliverDecodedContent();
+}
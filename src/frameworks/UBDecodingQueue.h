@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBDECODINGQUEUE_H_
+#define UBDECODINGQUEUE_H_
+
+#include <QtGui>
+#include <QThreadPool>
+#include <QPointer>
+
+class QSvgRenderer;
+class QGraphicsScene;
+
+struct UBDecodedContent
+{
+    UBDecodedContent()
+        : renderer(0)
+    {
+        // NOOP
+    }
+
+    QString path;
+    QImage image;
+    QByteArray data;
+    QSvgRenderer* renderer; // owned by the receiver, created in the GUI thread affinity
+};
+
+
+class UBDecodingTarget
+{
+    public:
+        virtual ~UBDecodingTarget() {}
+
+        // always called in the GUI thread
+        virtual void decodingFinished(const UBDecodedContent& content) = 0;
+};
+
+
+/*
+ * Decodes images and parses SVG files on a thread pool while a scene is being built.
+ * Results are handed back to their target in the GUI thread; targets deleted in the meantime
+ * are skipped. Code that renders or persists a scene calls waitForPendingDecodes() first; it only
+ * waits for the decodes of that scene, not for the ones of the board page or of prefetched scenes.
+ */
+class UBDecodingQueue : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum DecodingKind
+        {
+            DecodeImage = 0,
+            DecodeSvg
+        };
+
+        static UBDecodingQueue* queue();
+        static void destroy();
+
+        // target must be both the QObject and the UBDecodingTarget of the same item
+        void decode(QObject* targetObject, UBDecodingTarget* target, DecodingKind kind, const QString& path, qreal scale = 1.0);
+
+        // waits for the decodes of the items of scene, resp. of a single target, and delivers them
+        void waitForPendingDecodes(QGraphicsScene* scene);
+        void waitForTargetDecodes(const QObject* targetObject);
+        bool hasPendingDecodes();
+
+        static QImage decodeImage(const QString& path, qreal scale);
+
+    private slots:
+        void deliverDecodedContent();
+
+    private:
+        UBDecodingQueue();
+        virtual ~UBDecodingQueue();
+
+        friend class UBDecodingJob;
+
+        struct Job
+        {
+            QPointer<QObject> targetObject;
+            const QObject* targetKey;
+            UBDecodingTarget* target;
+            DecodingKind kind;
+            qreal scale;
+            UBDecodedContent content;
+        };
+
+        void jobFinished(const Job& job);
+        void waitForTargets(const QSet<const QObject*>& targetObjects);
+
+        static UBDecodingQueue* sQueue;
+
+        QThreadPool mPool;
+        QMutex mMutex;
+        QWaitCondition mJobFinished;
+        QList<Job> mFinishedJobs;
+        int mPendingJobs;
+        // running jobs per target, the keys are only compared: their objects may be gone
+        QHash<const QObject*, int> mRunningTargets;
+};
+
+#endif /* UBDECODINGQUEUE_H_ */
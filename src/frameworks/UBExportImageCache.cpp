@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "UBExportImageCache.h"
+
+#include "core/memcheck.h"
+
+
+// in kilobytes
+static const int sSharedPixmapsBudget = 128 * 1024;
+
+
+UBExportImageCache::UBExportImageCache(int targetDpi)
+    : mTargetDpi(targetDpi)
+    , mSharedPixmaps(sSharedPixmapsBudget)
+{
+    // NOOP
+}
+
+
+UBExportImageCache::~UBExportImageCache()
+{
+    // NOOP
+}
+
+
+QSize UBExportImageCache::exportedSize(const QSize& nativeSize, const QSizeF& paintedSize) const
+{
+    if (mTargetDpi <= 0 || nativeSize.isEmpty())
+        return nativeSize;
+
+    qreal scale = qMax(paintedSize.width() * mTargetDpi / nativeSize.width(),
+                       paintedSize.height() * mTargetDpi / nativeSize.height());
+
+    // rounded up to sixteenths, so that an image painted at about the same size on several pages is embedded once
+    scale = qCeil(scale * 16) / 16.0;
+
+    if (scale >= 1.0)
+        return nativeSize;
+
+    return (QSizeF(nativeSize) * scale).toSize().expandedTo(QSize(1, 1));
+}
+
+
+QPixmap UBExportImageCache::insertShared(const QByteArray& key, const QPixmap& pixmap)
+{
+    qint64 cost = qMax((qint64)1, (qint64)pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+
+    // an image bigger than the whole budget is not shared, it would only flush the others
+    if (cost <= mSharedPixmaps.maxCost())
+        mSharedPixmaps.insert(key, new QPixmap(pixmap), (int)cost);
+
+    return pixmap;
+}
+
+
+QPixmap UBExportImageCache::sharedPixmap(const QPixmap& pixmap, const QSizeF& paintedSize)
+{
+    if (pixmap.isNull())
+        return pixmap;
+
+    QByteArray hash = mPixmapHashes.value(pixmap.cacheKey());
+
+    if (hash.isEmpty())
+    {
+        QImage image = pixmap.toImage();
+
+        QCryptographicHash content(QCryptographicHash::Sha1);
+        content.addData(reinterpret_cast<const char*>(image.constBits()), image.byteCount());
+
+        hash = content.result().toHex() + "/" + QByteArray::number(image.width()) + "x" + QByteArray::number(image.height())
+                + "/" + QByteArray::number((int)image.format());
+
+        mPixmapHashes.insert(pixmap.cacheKey(), hash);
+    }
+
+    QSize size = exportedSize(pixmap.size(), paintedSize);
+    QByteArray key = hash + "@" + QByteArray::number(size.width());
+
+    QPixmap* shared = mSharedPixmaps.object(key);
+    if (shared)
+        return *shared;
+
+    if (size == pixmap.size())
+        return insertShared(key, pixmap);
+
+    return insertShared(key, pixmap.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+}
+
+
+QPixmap UBExportImageCache::sharedSourcePixmap(const QString& path, const QSize& nativeSize, const QSizeF& paintedSize)
+{
+    QByteArray hash = mFileHashes.value(path);
+
+    if (hash.isEmpty())
+    {
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            qWarning() << "cannot open image file" << path;
+            return QPixmap();
+        }
+
+        QCryptographicHash content(QCryptographicHash::Sha1);
+        content.addData(&file);
+        file.close();
+
+        // files are keyed apart from decoded pixmaps, their pixels are never hashed
+        hash = "file/" + content.result().toHex();
+
+        mFileHashes.insert(path, hash);
+    }
+
+    QSize size = exportedSize(nativeSize, paintedSize);
+    QByteArray key = hash + "@" + QByteArray::number(size.width());
+
+    QPixmap* shared = mSharedPixmaps.object(key);
+    if (shared)
+        return *shared;
+
+    QImageReader reader(path);
+
+    if (size != nativeSize)
+        reader.setScaledSize(size);
+
+    QImage image = reader.read();
+
+    if (image.isNull())
+    {
+        qWarning() << "cannot decode image" << path << reader.errorString();
+        return QPixmap();
+    }
+
+    return insertShared(key, QPixmap::fromImage(image));
+}
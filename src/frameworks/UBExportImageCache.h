@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef UBEXPORTIMAGECACHE_H_
+#define UBEXPORTIMAGECACHE_H_
+
+#include <QtGui>
+
+/*
+ * Lives for one export. The pdf engine embeds a pixmap once per cache key, so images with the
+ * same content painted on several pages are handed out as the very same QPixmap; with a target
+ * resolution, images painted smaller than their native size are downsampled to it first.
+ * The shared pixmaps are kept within a memory budget, an image evicted and painted again is
+ * embedded a second time.
+ */
+class UBExportImageCache
+{
+    public:
+        // targetDpi 0 keeps the images at their native resolution
+        UBExportImageCache(int targetDpi = 0);
+        virtual ~UBExportImageCache();
+
+        // paintedSize is the size the image covers on the output, in inches
+        QPixmap sharedPixmap(const QPixmap& pixmap, const QSizeF& paintedSize);
+        QPixmap sharedSourcePixmap(const QString& path, const QSize& nativeSize, const QSizeF& paintedSize);
+
+    private:
+        QSize exportedSize(const QSize& nativeSize, const QSizeF& paintedSize) const;
+        QPixmap insertShared(const QByteArray& key, const QPixmap& pixmap);
+
+        int mTargetDpi;
+
+        QHash<qint64, QByteArray> mPixmapHashes;
+        QHash<QString, QByteArray> mFileHashes;
+        QCache<QByteArray, QPixmap> mSharedPixmaps;
+};
+
+#endif /* UBEXPORTIMAGECACHE_H_ */
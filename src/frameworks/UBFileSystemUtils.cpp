@@ -33,10 +33,13 @@
 
 #include "core/UBApplication.h"
 
+#include "frameworks/UBPlatformUtils.h"
+
 #include "globals/UBGlobals.h"
 
 THIRD_PARTY_WARNINGS_DISABLE
 #include "quazipfile.h"
+#include <zlib.h>
 #include <openssl/md5.h>
 THIRD_PARTY_WARNINGS_ENABLE
 
@@ -44,6 +47,26 @@ THIRD_PARTY_WARNINGS_ENABLE
 
 QStringList UBFileSystemUtils::sTempDirToCleanUp;
 
+enum UBFileCopyMethod
+{
+    UBFileCopyReflink = 0,
+    UBFileCopyKernel,
+    UBFileCopyBuffered,
+    UBFileCopyMethodCount
+};
+
+struct UBFileCopyCounter
+{
+    UBFileCopyCounter() : files(0), bytes(0), msecs(0) {}
+
+    int files;
+    qint64 bytes;
+    qint64 msecs;
+};
+
+static QMutex sFileCopyCountersMutex;
+static UBFileCopyCounter sFileCopyCounters[UBFileCopyMethodCount];
+
 
 UBFileSystemUtils::UBFileSystemUtils()
 {
@@ -111,7 +134,54 @@ bool UBFileSystemUtils::copyFile(const QString &source, const QString &destinati
             }
         }
     }
-    return QFile::copy(source, normalizedDestination);
+    return cloneFile(source, normalizedDestination);
+}
+
+
+bool UBFileSystemUtils::cloneFile(const QString &source, const QString &destination)
+{
+    if (QFile::exists(destination))
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    UBFileCopyMethod method = UBFileCopyBuffered;
+    bool cloned = false;
+
+    if (UBPlatformUtils::fastCopyFile(source, destination, &cloned))
+        method = cloned ? UBFileCopyReflink : UBFileCopyKernel;
+    else if (!QFile::copy(source, destination))
+        return false;
+
+    qint64 elapsed = timer.elapsed();
+    qint64 size = QFileInfo(destination).size();
+
+    QMutexLocker locker(&sFileCopyCountersMutex);
+    sFileCopyCounters[method].files++;
+    sFileCopyCounters[method].bytes += size;
+    sFileCopyCounters[method].msecs += elapsed;
+
+    return true;
+}
+
+
+QString UBFileSystemUtils::copyStatistics()
+{
+    static const char* methodNames[UBFileCopyMethodCount] = { "reflink", "kernel copy", "buffered copy" };
+
+    QMutexLocker locker(&sFileCopyCountersMutex);
+
+    QStringList statistics;
+    for (int i = 0; i < UBFileCopyMethodCount; i++)
+    {
+        statistics << QString("%1: %2 files, %3 KB in %4 ms").arg(methodNames[i])
+                                                             .arg(sFileCopyCounters[i].files)
+                                                             .arg(sFileCopyCounters[i].bytes / 1024)
+                                                             .arg(sFileCopyCounters[i].msecs);
+    }
+
+    return statistics.join(", ");
 }
 
 bool UBFileSystemUtils::copy(const QString &source, const QString &destination, bool overwrite)
@@ -300,8 +370,7 @@ bool UBFileSystemUtils::copyDir(const QString& pSourceDirPath, const QString& pT
             }
             else
             {
-                QFile f(pSourceDirPath + "/" + dirContent.fileName());
-                successSoFar = f.copy(pTargetDirPath + "/" + dirContent.fileName());
+                successSoFar = cloneFile(pSourceDirPath + "/" + dirContent.fileName(), pTargetDirPath + "/" + dirContent.fileName());
             }
         }
         else
@@ -639,7 +708,132 @@ QString UBFileSystemUtils::getFirstExistingFileFromList(const QString& path, con
 }
 
 
-bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestPath, QuaZipFile *pOutZipFile, bool pRootDocumentFolder, UBProcessingProgressListener* progressListener)
+// entries of a document archive, in the order they are written
+struct UBZipEntry
+{
+    QString filePath;
+    QString entryName;
+    QString objectType;
+    int index;
+    int total;
+    bool reportsProgress;
+    bool deflated;
+
+    // filled by the deflating job
+    QByteArray data;
+    quint32 crc;
+    qint64 size;
+    bool done;
+    bool failed;
+};
+
+
+// shared by the deflating jobs and the thread writing the archive
+struct UBZipEntries
+{
+    QList<UBZipEntry> entries;
+    QMutex mutex;
+    QWaitCondition entryDone;
+};
+
+
+// formats that are compressed already: deflating them again costs cpu for no size gain
+static bool isCompressedFormat(const QString& suffix)
+{
+    static QStringList compressedSuffixes = QStringList()
+            << "jpg" << "jpeg" << "png" << "gif" << "webp"
+            << "mp4" << "m4v" << "mov" << "avi" << "mkv" << "webm" << "ogv" << "flv" << "wmv"
+            << "mp3" << "m4a" << "aac" << "ogg" << "oga" << "wma"
+            << "pdf" << "zip" << "ubz" << "wgz" << "swf";
+
+    return compressedSuffixes.contains(suffix.toLower());
+}
+
+
+class UBZipDeflateJob : public QRunnable
+{
+    public:
+        UBZipDeflateJob(UBZipEntries* entries, int entryIndex)
+            : mEntries(entries)
+            , mEntryIndex(entryIndex)
+        {
+            // NOOP
+        }
+
+        virtual void run()
+        {
+            QString filePath;
+            {
+                QMutexLocker locker(&mEntries->mutex);
+                filePath = mEntries->entries.at(mEntryIndex).filePath;
+            }
+
+            QByteArray data;
+            quint32 crc = 0;
+            qint64 size = 0;
+            bool failed = !deflateFile(filePath, data, crc, size);
+
+            QMutexLocker locker(&mEntries->mutex);
+
+            UBZipEntry& entry = mEntries->entries[mEntryIndex];
+            entry.data = data;
+            entry.crc = crc;
+            entry.size = size;
+            entry.failed = failed;
+            entry.done = true;
+
+            mEntries->entryDone.wakeAll();
+        }
+
+    private:
+        // raw deflate block, as stored in a zip entry
+        static bool deflateFile(const QString& filePath, QByteArray& compressed, quint32& crc, qint64& size)
+        {
+            QFile inFile(filePath);
+            if (!inFile.open(QIODevice::ReadOnly))
+            {
+                qWarning() << "Compression of file" << filePath << " failed. Cause: inFile.open(): " << inFile.errorString();
+                return false;
+            }
+
+            QByteArray content = inFile.readAll();
+            inFile.close();
+
+            size = content.size();
+            crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(content.constData()), content.size());
+
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return false;
+
+            compressed.resize(deflateBound(&stream, content.size()));
+
+            stream.next_in = reinterpret_cast<Bytef*>(content.data());
+            stream.avail_in = content.size();
+            stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+            stream.avail_out = compressed.size();
+
+            int result = deflate(&stream, Z_FINISH);
+            compressed.resize(stream.total_out);
+            deflateEnd(&stream);
+
+            if (result != Z_STREAM_END)
+            {
+                qWarning() << "Compression of file" << filePath << " failed. Cause: deflate(): " << result;
+                return false;
+            }
+
+            return true;
+        }
+
+        UBZipEntries* mEntries;
+        int mEntryIndex;
+};
+
+
+static void collectZipEntries(const QDir& pDir, const QString& pDestPath, bool pRootDocumentFolder, QList<UBZipEntry>& entries)
 {
     QFileInfoList files = pDir.entryInfoList(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
 
@@ -652,77 +846,171 @@ bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestP
         if (file.isDir())
         {
             QDir dir(file.absoluteFilePath());
-            if (!compressDirInZip(dir, pDestPath + dir.dirName() + "/" , pOutZipFile, false))
-            {
-                return false;
-            }
+            collectZipEntries(dir, pDestPath + dir.dirName() + "/", false, entries);
         }
 
         if (file.isFile())
         {
-            QString objectType;
+            UBZipEntry entry;
+            entry.filePath = file.absoluteFilePath();
+            entry.entryName = pDestPath + file.fileName();
+            entry.deflated = !isCompressedFormat(file.suffix());
+            entry.crc = 0;
+            entry.size = 0;
+            entry.done = false;
+            entry.failed = false;
+
             if (pRootDocumentFolder)
             {
-                objectType = "Page";
+                // we ignore thumbnails message because it is very fast.
+                entry.objectType = "Page";
+                entry.reportsProgress = file.suffix() == "svg";
+                entry.index = pageFiles.indexOf(file);
+                entry.total = pageFiles.size();
             }
             else
             {
-                objectType = pDir.dirName();
+                entry.objectType = pDir.dirName();
+                entry.reportsProgress = true;
+                entry.index = files.indexOf(file);
+                entry.total = files.size();
             }
 
-            if (!pRootDocumentFolder)
-            {
-                if (progressListener)
-                    progressListener->processing(objectType, files.indexOf(file), files.size());
-            }
-            // we ignore thumbnails message because it is very fast.
-            else if (progressListener && file.suffix() == "svg")
-            {
-                progressListener->processing(objectType, pageFiles.indexOf(file), pageFiles.size());
-            }
+            entries << entry;
+        }
+    }
+}
 
-            QFile inFile(file.absoluteFilePath());
-            if(!inFile.open(QIODevice::ReadOnly))
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: inFile.open(): " << inFile.errorString();
-                return false;
-            }
 
-            qDebug() << "will open" << pDestPath << file.fileName() << inFile.fileName();
+static bool writeStoredEntry(const UBZipEntry& entry, QuaZipFile *pOutZipFile)
+{
+    QFile inFile(entry.filePath);
+    if(!inFile.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: inFile.open(): " << inFile.errorString();
+        return false;
+    }
 
-            if(!pOutZipFile->open(QIODevice::WriteOnly, QuaZipNewInfo(pDestPath + file.fileName(), inFile.fileName())))
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.open(): " << pOutZipFile->getZipError();
-                inFile.close();
-                return false;
-            }
+    if(!pOutZipFile->open(QIODevice::WriteOnly, QuaZipNewInfo(entry.entryName, inFile.fileName()), NULL, 0, 0, 0))
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.open(): " << pOutZipFile->getZipError();
+        return false;
+    }
 
-            pOutZipFile->write(inFile.readAll());
-            if(pOutZipFile->getZipError() != UNZ_OK)
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.write(): " << pOutZipFile->getZipError();
+    // media can be big, they are copied by chunks
+    QByteArray buffer;
+    while (!inFile.atEnd() && pOutZipFile->getZipError() == UNZ_OK)
+    {
+        buffer = inFile.read(1024 * 1024);
+        pOutZipFile->write(buffer);
+    }
 
-                inFile.close();
-                pOutZipFile->close();
-                return false;
-            }
+    if(pOutZipFile->getZipError() != UNZ_OK)
+    {
+        qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.write(): " << pOutZipFile->getZipError();
+        pOutZipFile->close();
+        return false;
+    }
 
-            pOutZipFile->close();
-            if(pOutZipFile->getZipError() != UNZ_OK)
-            {
-                qWarning() << "Compression of file" << inFile.fileName() << " failed. Cause: outFile.close(): " << pOutZipFile->getZipError();
+    pOutZipFile->close();
 
-                inFile.close();
-                return false;
+    return pOutZipFile->getZipError() == UNZ_OK;
+}
+
+
+static bool writeDeflatedEntry(const UBZipEntry& entry, QuaZipFile *pOutZipFile)
+{
+    // the entry was deflated by a job, it is written as is
+    if(!pOutZipFile->open(QIODevice::WriteOnly, QuaZipNewInfo(entry.entryName, entry.filePath), NULL, entry.crc, Z_DEFLATED, Z_DEFAULT_COMPRESSION, true))
+    {
+        qWarning() << "Compression of file" << entry.filePath << " failed. Cause: outFile.open(): " << pOutZipFile->getZipError();
+        return false;
+    }
+
+    pOutZipFile->write(entry.data);
+
+    if(pOutZipFile->getZipError() != UNZ_OK)
+    {
+        qWarning() << "Compression of file" << entry.filePath << " failed. Cause: outFile.write(): " << pOutZipFile->getZipError();
+        pOutZipFile->closeRaw(entry.size, entry.crc);
+        return false;
+    }
+
+    pOutZipFile->closeRaw(entry.size, entry.crc);
+
+    return pOutZipFile->getZipError() == UNZ_OK;
+}
+
+
+bool UBFileSystemUtils::compressDirInZip(const QDir& pDir, const QString& pDestPath, QuaZipFile *pOutZipFile, bool pRootDocumentFolder, UBProcessingProgressListener* progressListener)
+{
+    UBZipEntries zipEntries;
+    collectZipEntries(pDir, pDestPath, pRootDocumentFolder, zipEntries.entries);
+
+    int entryCount = zipEntries.entries.size();
+
+    // entries are deflated ahead on a pool and written in order; the window bounds the memory held by deflated entries
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    int window = pool.maxThreadCount() * 2;
+    int nextEntryToDeflate = 0;
+
+    QTime time;
+    time.start();
+    qint64 bytesWritten = 0;
+    bool success = true;
+
+    for (int i = 0; i < entryCount && success; i++)
+    {
+        for (; nextEntryToDeflate < entryCount && nextEntryToDeflate < i + window; nextEntryToDeflate++)
+        {
+            if (zipEntries.entries.at(nextEntryToDeflate).deflated)
+                pool.start(new UBZipDeflateJob(&zipEntries, nextEntryToDeflate));
+        }
+
+        if (progressListener && progressListener->isCancelled())
+        {
+            success = false;
+            break;
+        }
+
+        UBZipEntry entry;
+        {
+            QMutexLocker locker(&zipEntries.mutex);
+
+            if (zipEntries.entries.at(i).deflated)
+            {
+                while (!zipEntries.entries.at(i).done)
+                    zipEntries.entryDone.wait(&zipEntries.mutex);
             }
 
-            inFile.close();
+            entry = zipEntries.entries.at(i);
+            // the written entry does not need its deflated data anymore
+            zipEntries.entries[i].data = QByteArray();
         }
+
+        if (progressListener && entry.reportsProgress)
+            progressListener->processing(entry.objectType, entry.index, entry.total);
+
+        if (entry.deflated)
+            success = !entry.failed && writeDeflatedEntry(entry, pOutZipFile);
+        else
+            success = writeStoredEntry(entry, pOutZipFile);
+
+        bytesWritten += entry.deflated ? entry.data.size() : QFileInfo(entry.filePath).size();
+
+        if (progressListener)
+            progressListener->bytesProcessed(bytesWritten, time.elapsed());
     }
 
-    return true;
-}
+    pool.waitForDone();
 
+    int elapsed = qMax(1, time.elapsed());
+    qDebug() << "compressed" << entryCount << "files," << bytesWritten / 1024 << "KB in" << elapsed << "ms,"
+             << (bytesWritten * 1000 / elapsed) / (1024 * 1024) << "MB/s";
+
+    return success;
+}
 
 
 bool UBFileSystemUtils::expandZipToDir(const QFile& pZipFile, const QDir& pTargetDir)
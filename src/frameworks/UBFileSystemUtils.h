@@ -70,6 +70,10 @@ class UBFileSystemUtils : public QObject
 
         static bool copy(const QString &source, const QString &Destination, bool overwrite = false);
 
+        // copies to a new file with a reflink, then an in-kernel copy, then a buffered copy
+        static bool cloneFile(const QString &source, const QString &destination);
+        static QString copyStatistics();
+
         static QString cleanName(const QString& name);
 
         static QString digitFileFormat(const QString& s, int digit);
@@ -137,6 +141,19 @@ class UBProcessingProgressListener
 
         virtual void processing(const QString& pOpType, int pCurrent, int pTotal) = 0;
 
+        // bytes written so far by the operation and the time it took, for throughput
+        virtual void bytesProcessed(qint64 pBytes, qint64 pElapsedMSecs)
+        {
+            Q_UNUSED(pBytes);
+            Q_UNUSED(pElapsedMSecs);
+        }
+
+        // long operations check it between two steps and give up when it becomes true
+        virtual bool isCancelled() const
+        {
+            return false;
+        }
+
 };
 
 #endif /* UBFILESYSTEMUTILS_H_ */
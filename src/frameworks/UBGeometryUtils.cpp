@@ -286,3 +286,36 @@ void UBGeometryUtils::crashPointList(QVector<QPointF> &points)
         }
     }
 }
+
+
+/**
+ * Drops the vertices closer than tolerance to the last kept one (radial distance decimation).
+ * The first and last vertices are always kept, so closed polygons stay closed.
+ */
+QPolygonF UBGeometryUtils::simplifyPolygon(const QPolygonF& polygon, qreal tolerance)
+{
+    if (polygon.size() < 4 || tolerance <= 0)
+        return polygon;
+
+    qreal squaredTolerance = tolerance * tolerance;
+
+    QPolygonF result;
+    result.reserve(polygon.size());
+    result << polygon.first();
+
+    for (int i = 1; i < polygon.size() - 1; i++)
+    {
+        QPointF delta = polygon.at(i) - result.last();
+
+        if (delta.x() * delta.x() + delta.y() * delta.y() >= squaredTolerance)
+            result << polygon.at(i);
+    }
+
+    result << polygon.last();
+
+    // a polygon needs at least three vertices to be filled
+    if (result.size() < 3)
+        return polygon;
+
+    return result;
+}
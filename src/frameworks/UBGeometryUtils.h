@@ -53,6 +53,8 @@ class UBGeometryUtils
 
         static void crashPointList(QVector<QPointF> &points);
 
+        static QPolygonF simplifyPolygon(const QPolygonF& polygon, qreal tolerance);
+
         const static int centimeterGraduationHeight;
         const static int halfCentimeterGraduationHeight;
         const static int millimeterGraduationHeight;
@@ -209,6 +209,11 @@ public:
         static void setFrontProcess();
         static void showFullScreen(QWidget * pWidget);
         static void showOSK(bool show);
+        static bool createHardLink(const QString& existingFilePath, const QString& newFilePath);
+        static int hardLinkCount(const QString& filePath);
+        // moves sourcePath over an existing targetPath in one step
+        static bool replaceFile(const QString& sourcePath, const QString& targetPath);
+        static bool fastCopyFile(const QString& source, const QString& destination, bool* cloned);
 
 #ifdef Q_OS_OSX
         static void SetMacLocaleByIdentifier(const QString& id);
@@ -33,6 +33,12 @@
 #include <QApplication>
 
 #include <unistd.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <linux/fs.h>
 #include <X11/keysym.h>
 
 #include "frameworks/UBFileSystemUtils.h"
@@ -115,6 +121,88 @@ QString UBPlatformUtils::computerName()
         return "NOT FOUND";
 }
 
+bool UBPlatformUtils::createHardLink(const QString& existingFilePath, const QString& newFilePath)
+{
+    return ::link(QFile::encodeName(existingFilePath).constData(), QFile::encodeName(newFilePath).constData()) == 0;
+}
+
+int UBPlatformUtils::hardLinkCount(const QString& filePath)
+{
+    struct stat fileStat;
+    if (::stat(QFile::encodeName(filePath).constData(), &fileStat) != 0)
+        return 0;
+
+    return fileStat.st_nlink;
+}
+
+bool UBPlatformUtils::replaceFile(const QString& sourcePath, const QString& targetPath)
+{
+    return ::rename(QFile::encodeName(sourcePath).constData(), QFile::encodeName(targetPath).constData()) == 0;
+}
+
+bool UBPlatformUtils::fastCopyFile(const QString& source, const QString& destination, bool* cloned)
+{
+    int in = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        return false;
+
+    struct stat sourceStat;
+    if (::fstat(in, &sourceStat) != 0)
+    {
+        ::close(in);
+        return false;
+    }
+
+    int out = ::open(QFile::encodeName(destination).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, sourceStat.st_mode & 0777);
+    if (out < 0)
+    {
+        ::close(in);
+        return false;
+    }
+
+    bool success = false;
+
+#ifdef FICLONE
+    // btrfs, XFS, ... share the extents of the source, nothing is copied
+    if (::ioctl(out, FICLONE, in) == 0)
+    {
+        success = true;
+        *cloned = true;
+    }
+#endif
+
+#ifdef __NR_copy_file_range
+    // the kernel copies without user space buffers and NFS 4.2 copies on the server side
+    if (!success)
+    {
+        off_t remaining = sourceStat.st_size;
+        success = true;
+
+        while (remaining > 0)
+        {
+            ssize_t copied = ::syscall(__NR_copy_file_range, in, NULL, out, NULL, (size_t)remaining, 0);
+            if (copied <= 0)
+            {
+                success = false;
+                break;
+            }
+            remaining -= copied;
+        }
+
+        *cloned = false;
+    }
+#endif
+
+    ::close(in);
+    if (::close(out) != 0)
+        success = false;
+
+    if (!success)
+        ::unlink(QFile::encodeName(destination).constData());
+
+    return success;
+}
+
 void UBPlatformUtils::setWindowNonActivableFlag(QWidget* widget, bool nonAcivable)
 {
     Q_UNUSED(widget);
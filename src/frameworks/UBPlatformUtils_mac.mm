@@ -33,6 +33,14 @@
 #include "frameworks/UBFileSystemUtils.h"
 
 #include <QWidget>
+#include <QFile>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#if __has_include(<sys/clonefile.h>)
+#include <sys/clonefile.h>
+#endif
 
 #import <Foundation/NSAutoreleasePool.h>
 #import <Cocoa/Cocoa.h>
@@ -299,6 +307,42 @@ QString UBPlatformUtils::computerName()
     return computerName;
 }
 
+bool UBPlatformUtils::createHardLink(const QString& existingFilePath, const QString& newFilePath)
+{
+    return ::link(QFile::encodeName(existingFilePath).constData(), QFile::encodeName(newFilePath).constData()) == 0;
+}
+
+int UBPlatformUtils::hardLinkCount(const QString& filePath)
+{
+    struct stat fileStat;
+    if (::stat(QFile::encodeName(filePath).constData(), &fileStat) != 0)
+        return 0;
+
+    return fileStat.st_nlink;
+}
+
+bool UBPlatformUtils::replaceFile(const QString& sourcePath, const QString& targetPath)
+{
+    return ::rename(QFile::encodeName(sourcePath).constData(), QFile::encodeName(targetPath).constData()) == 0;
+}
+
+bool UBPlatformUtils::fastCopyFile(const QString& source, const QString& destination, bool* cloned)
+{
+#if __has_include(<sys/clonefile.h>)
+    // APFS copy-on-write clone, nothing is copied
+    if (::clonefile(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData(), 0) == 0)
+    {
+        *cloned = true;
+        return true;
+    }
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(destination);
+    Q_UNUSED(cloned);
+#endif
+    return false;
+}
+
 void UBPlatformUtils::setWindowNonActivableFlag(QWidget* widget, bool nonAcivable)
 {
     Q_UNUSED(widget);
@@ -121,6 +121,41 @@ QString UBPlatformUtils::computerName()
     return computerName;
 }
 
+bool UBPlatformUtils::createHardLink(const QString& existingFilePath, const QString& newFilePath)
+{
+    return CreateHardLinkW((LPCWSTR)QDir::toNativeSeparators(newFilePath).utf16(),
+                           (LPCWSTR)QDir::toNativeSeparators(existingFilePath).utf16(), NULL) != 0;
+}
+
+int UBPlatformUtils::hardLinkCount(const QString& filePath)
+{
+    HANDLE file = CreateFileW((LPCWSTR)QDir::toNativeSeparators(filePath).utf16(), 0,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    int count = GetFileInformationByHandle(file, &info) ? (int)info.nNumberOfLinks : 0;
+    CloseHandle(file);
+
+    return count;
+}
+
+bool UBPlatformUtils::replaceFile(const QString& sourcePath, const QString& targetPath)
+{
+    // fails while another process has the target open without sharing its deletion
+    return MoveFileExW((LPCWSTR)QDir::toNativeSeparators(sourcePath).utf16(),
+                       (LPCWSTR)QDir::toNativeSeparators(targetPath).utf16(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+bool UBPlatformUtils::fastCopyFile(const QString& source, const QString& destination, bool* cloned)
+{
+    Q_UNUSED(source);
+    Q_UNUSED(destination);
+    Q_UNUSED(cloned);
+    return false;
+}
+
 
 void UBPlatformUtils::setDesktopMode(bool desktop)
 {
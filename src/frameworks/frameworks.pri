@@ -6,7 +6,9 @@ HEADERS      += src/frameworks/UBGeometryUtils.h \
                 src/frameworks/UBVersion.h \
                 src/frameworks/UBCoreGraphicsScene.h \
                 src/frameworks/UBCryptoUtils.h \
-                src/frameworks/UBBase32.h
+                src/frameworks/UBBase32.h \
+                src/frameworks/UBDecodingQueue.h \
+                src/frameworks/UBExportImageCache.h
 
 SOURCES      += src/frameworks/UBGeometryUtils.cpp \
                 src/frameworks/UBPlatformUtils.cpp \
@@ -15,7 +17,9 @@ SOURCES      += src/frameworks/UBGeometryUtils.cpp \
                 src/frameworks/UBVersion.cpp \
                 src/frameworks/UBCoreGraphicsScene.cpp \
                 src/frameworks/UBCryptoUtils.cpp \
-                src/frameworks/UBBase32.cpp
+                src/frameworks/UBBase32.cpp \
+                src/frameworks/UBDecodingQueue.cpp \
+                src/frameworks/UBExportImageCache.cpp
 
 
 win32 {
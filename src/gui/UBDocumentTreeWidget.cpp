@@ -39,6 +39,7 @@
 
 #include "adaptors/UBThumbnailAdaptor.h"
 #include "adaptors/UBSvgSubsetAdaptor.h"
+#include "adaptors/UBExportQueue.h"
 #include "frameworks/UBFileSystemUtils.h"
 
 #include "core/memcheck.h"
@@ -259,7 +260,7 @@ void UBDocumentTreeWidget::dropEvent(QDropEvent *event)
 
                 const UBMimeData *mimeData = qobject_cast <const UBMimeData*>(event->mimeData());
 
-                if (mimeData && mimeData->items().size() > 0)
+                if (mimeData && mimeData->items().size() > 0 && !UBExportQueue::queue()->blocksPageChanges(targetProxyTreeItem->proxy()))
                 {
                         int count = 0;
                         int total = mimeData->items().size();
@@ -273,6 +274,7 @@ void UBDocumentTreeWidget::dropEvent(QDropEvent *event)
                         UBApplication::applicationController->showMessage(tr("Copying page %1/%2").arg(count).arg(total), true);
 
                         // TODO UB 4.x Move following code to some controller class
+                        UBPersistenceManager::persistenceManager()->extractSceneMedia(sourceItem.documentProxy(), sourceItem.sceneIndex());
                         UBGraphicsScene *scene = UBPersistenceManager::persistenceManager()->loadDocumentScene(sourceItem.documentProxy(), sourceItem.sceneIndex());
                         if (scene)
                         {
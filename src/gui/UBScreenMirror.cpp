@@ -46,6 +46,8 @@ UBScreenMirror::UBScreenMirror(QWidget* parent)
     : QWidget(parent)
     , mScreenIndex(0)
     , mSourceWidget(0)
+    , mFullRefresh(true)
+    , mGrabbing(false)
     , mTimerID(0)
 {
     // NOOP
@@ -54,39 +56,159 @@ UBScreenMirror::UBScreenMirror(QWidget* parent)
 
 UBScreenMirror::~UBScreenMirror()
 {
-    // NOOP
+    if (mSourceWidget)
+        unwatchWidget(mSourceWidget);
 }
 
 
 void UBScreenMirror::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
-
     QPainter painter(this);
 
-    painter.fillRect(0, 0, width(), height(), QBrush(Qt::black));
+    painter.fillRect(event->rect(), QBrush(Qt::black));
 
     if (!mLastPixmap.isNull())
     {
-        int x = (width() - mLastPixmap.width()) / 2;
-        int y = (height() - mLastPixmap.height()) / 2;
-
-        painter.drawPixmap(x, y, mLastPixmap);
+        painter.drawPixmap(pixmapOrigin(), mLastPixmap);
     }
 }
 
 
+void UBScreenMirror::resizeEvent(QResizeEvent *event)
+{
+    invalidate();
+
+    QWidget::resizeEvent(event);
+}
+
+
 void UBScreenMirror::timerEvent(QTimerEvent *event)
 {
     Q_UNUSED(event);
 
-    grabPixmap();
+    if (!isVisible())
+        return;
 
-    update();
+    if (mSourceWidget)
+        grabDirtyRegion();
+    else
+        grabDesktop();
+}
+
+
+bool UBScreenMirror::eventFilter(QObject *obj, QEvent *event)
+{
+    // paint events sent by our own grab() calls are not damage
+    if (mGrabbing || !mSourceWidget || !obj->isWidgetType())
+        return QWidget::eventFilter(obj, event);
+
+    QWidget *widget = static_cast<QWidget*>(obj);
+
+    switch (event->type())
+    {
+        case QEvent::Paint:
+        {
+            QRegion region = static_cast<QPaintEvent*>(event)->region();
+
+            if (widget != mSourceWidget)
+            {
+                if (mSourceWidget->isAncestorOf(widget))
+                    region.translate(widget->mapTo(mSourceWidget, QPoint(0, 0)));
+                else
+                    region = mSourceWidget->rect();
+            }
+
+            mDirtyRegion += region & mSourceWidget->rect();
+            break;
+        }
+        case QEvent::Resize:
+        {
+            if (widget == mSourceWidget)
+                invalidate();
+            break;
+        }
+        case QEvent::ChildAdded:
+        {
+            QObject *child = static_cast<QChildEvent*>(event)->child();
+            if (child && child->isWidgetType())
+                watchWidget(static_cast<QWidget*>(child));
+            break;
+        }
+        default:
+            break;
+    }
+
+    return QWidget::eventFilter(obj, event);
 }
 
+
+void UBScreenMirror::watchWidget(QWidget *widget)
+{
+    widget->installEventFilter(this);
+
+    foreach (QWidget *child, widget->findChildren<QWidget*>())
+        child->installEventFilter(this);
+}
+
+
+void UBScreenMirror::unwatchWidget(QWidget *widget)
+{
+    widget->removeEventFilter(this);
+
+    foreach (QWidget *child, widget->findChildren<QWidget*>())
+        child->removeEventFilter(this);
+}
+
+
+void UBScreenMirror::invalidate()
+{
+    mFullRefresh = true;
+    mDirtyRegion = QRegion();
+}
+
+
+QPoint UBScreenMirror::pixmapOrigin() const
+{
+    return QPoint((width() - mLastPixmap.width()) / 2, (height() - mLastPixmap.height()) / 2);
+}
+
+
+QRect UBScreenMirror::scaledRect(const QRect& sourceRect) const
+{
+    if (mSourceSize.isEmpty())
+        return QRect();
+
+    qreal sx = (qreal)mLastPixmap.width() / mSourceSize.width();
+    qreal sy = (qreal)mLastPixmap.height() / mSourceSize.height();
+
+    QRectF scaled(sourceRect.x() * sx, sourceRect.y() * sy, sourceRect.width() * sx, sourceRect.height() * sy);
+
+    return scaled.toAlignedRect() & mLastPixmap.rect();
+}
+
+
+void UBScreenMirror::updateScaledRegion(const QPixmap& source, const QRect& sourceRect, const QRect& clipRect)
+{
+    if (source.isNull() || mLastPixmap.isNull() || mSourceSize.isEmpty())
+        return;
+
+    qreal sx = (qreal)mLastPixmap.width() / mSourceSize.width();
+    qreal sy = (qreal)mLastPixmap.height() / mSourceSize.height();
+
+    QRectF target(sourceRect.x() * sx, sourceRect.y() * sy, sourceRect.width() * sx, sourceRect.height() * sy);
+
+    QPainter painter(&mLastPixmap);
+    painter.setClipRect(clipRect);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter.drawPixmap(target, source, QRectF(source.rect()));
+}
+
+
 void UBScreenMirror::grabPixmap()
 {
+    mDirtyRegion = QRegion();
+    mFullRefresh = false;
+
     if (mSourceWidget)
     {
         QPoint topLeft = mSourceWidget->mapToGlobal(mSourceWidget->geometry().topLeft());
@@ -94,7 +216,12 @@ void UBScreenMirror::grabPixmap()
 
         mRect.setTopLeft(topLeft);
         mRect.setBottomRight(bottomRight);
+
+        mGrabbing = true;
         mLastPixmap = mSourceWidget->grab();
+        mGrabbing = false;
+
+        mSourceSize = mSourceWidget->size();
     }
     else{
         // WHY HERE?
@@ -103,16 +230,157 @@ void UBScreenMirror::grabPixmap()
         QDesktopWidget * desktop = QApplication::desktop();
         QScreen * screen = UBApplication::controlScreen();
         mLastPixmap = screen->grabWindow(desktop->effectiveWinId(), mRect.x(), mRect.y(), mRect.width(), mRect.height());
+
+        mLastDesktopImage = mLastPixmap.toImage();
+        mSourceSize = mLastDesktopImage.size();
     }
 
     if (!mLastPixmap.isNull())
+    {
         mLastPixmap = mLastPixmap.scaled(width(), height(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        mLastPixmap.setDevicePixelRatio(1);
+    }
+}
+
+
+void UBScreenMirror::grabDirtyRegion()
+{
+    if (mFullRefresh || mLastPixmap.isNull() || mSourceSize != mSourceWidget->size())
+    {
+        grabPixmap();
+        update();
+        return;
+    }
+
+    // static board : nothing was painted since the last tick
+    if (mDirtyRegion.isEmpty())
+        return;
+
+    QVector<QRect> rects = mDirtyRegion.rects();
+
+    // many small damages (e.g. a stroke being drawn) are cheaper to grab in one go
+    if (rects.size() > 8)
+    {
+        rects.clear();
+        rects << mDirtyRegion.boundingRect();
+    }
+
+    mDirtyRegion = QRegion();
+
+    // grab a few more source pixels so that the smooth scaling does not leave seams at tile borders
+    qreal scale = (qreal)mLastPixmap.width() / mSourceSize.width();
+    int margin = scale > 0 ? qCeil(1.0 / scale) + 1 : 1;
+
+    foreach (const QRect& rect, rects)
+    {
+        QRect grabRect = rect.adjusted(-margin, -margin, margin, margin) & mSourceWidget->rect();
+        if (grabRect.isEmpty())
+            continue;
+
+        mGrabbing = true;
+        QPixmap piece = mSourceWidget->grab(grabRect);
+        mGrabbing = false;
+
+        // the margin only feeds the filter, the damaged area alone is refreshed
+        QRect target = scaledRect(rect);
+        updateScaledRegion(piece, grabRect, target);
+
+        update(target.translated(pixmapOrigin()));
+    }
+}
+
+
+void UBScreenMirror::grabDesktop()
+{
+    QImage lastImage = mLastDesktopImage;
+
+    if (mFullRefresh || mLastPixmap.isNull() || lastImage.isNull())
+    {
+        grabPixmap();
+        update();
+        return;
+    }
+
+    // there is no damage notification for the desktop, so compare the new grab with the previous one
+    // and only rescale the tiles that actually changed
+    QDesktopWidget * desktop = QApplication::desktop();
+    QScreen * screen = UBApplication::controlScreen();
+    QPixmap raw = screen->grabWindow(desktop->effectiveWinId(), mRect.x(), mRect.y(), mRect.width(), mRect.height());
+    QImage image = raw.toImage();
+
+    if (image.size() != lastImage.size() || image.format() != lastImage.format())
+    {
+        grabPixmap();
+        update();
+        return;
+    }
+
+    const int tileSize = 64;
+    const int bytesPerPixel = image.depth() / 8;
+    QRegion dirty;
+
+    for (int ty = 0; ty < image.height(); ty += tileSize)
+    {
+        int tileHeight = qMin(tileSize, image.height() - ty);
+
+        for (int tx = 0; tx < image.width(); tx += tileSize)
+        {
+            int tileWidth = qMin(tileSize, image.width() - tx);
+
+            for (int y = ty; y < ty + tileHeight; y++)
+            {
+                if (memcmp(image.constScanLine(y) + tx * bytesPerPixel, lastImage.constScanLine(y) + tx * bytesPerPixel, tileWidth * bytesPerPixel) != 0)
+                {
+                    dirty += QRect(tx, ty, tileWidth, tileHeight);
+                    break;
+                }
+            }
+        }
+    }
+
+    mLastDesktopImage = image;
+
+    if (dirty.isEmpty())
+        return;
+
+    qreal scale = (qreal)mLastPixmap.width() / mSourceSize.width();
+    int margin = scale > 0 ? qCeil(1.0 / scale) + 1 : 1;
+
+    foreach (const QRect& rect, dirty.rects())
+    {
+        QRect grabRect = rect.adjusted(-margin, -margin, margin, margin) & image.rect();
+        QRect target = scaledRect(rect);
+
+        updateScaledRegion(raw.copy(grabRect), grabRect, target);
+
+        update(target.translated(pixmapOrigin()));
+    }
+}
+
+
+void UBScreenMirror::setSourceRect(const QRect& pRect)
+{
+    if (mSourceWidget)
+        unwatchWidget(mSourceWidget);
+
+    mRect = pRect;
+    mSourceWidget = 0;
+    mLastDesktopImage = QImage();
+
+    invalidate();
 }
 
 
 void UBScreenMirror::setSourceWidget(QWidget *sourceWidget)
 {
+    if (mSourceWidget)
+        unwatchWidget(mSourceWidget);
+
     mSourceWidget = sourceWidget;
+    mLastDesktopImage = QImage();
+
+    if (mSourceWidget)
+        watchWidget(mSourceWidget);
 
     mScreenIndex = qApp->desktop()->screenNumber(sourceWidget);
 
@@ -138,6 +406,8 @@ void UBScreenMirror::start()
             ms = 1000 / fps;
         }
 
+        invalidate();
+
         mTimerID = startTimer(ms);
     }
     else
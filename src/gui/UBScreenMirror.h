@@ -32,6 +32,7 @@
 
 #include <QtGui>
 #include <QWidget>
+#include <QPointer>
 
 class UBScreenMirror : public QWidget
 {
@@ -43,16 +44,14 @@ class UBScreenMirror : public QWidget
 
         virtual void paintEvent (QPaintEvent * event);
         virtual void timerEvent(QTimerEvent *event);
+        virtual void resizeEvent(QResizeEvent *event);
+        virtual bool eventFilter(QObject *obj, QEvent *event);
 
     public slots:
 
         void setSourceWidget(QWidget *sourceWidget);
 
-        void setSourceRect(const QRect& pRect)
-        {
-            mRect = pRect;
-            mSourceWidget = 0;
-        }
+        void setSourceRect(const QRect& pRect);
 
         void start();
 
@@ -61,15 +60,37 @@ class UBScreenMirror : public QWidget
     private:
 
         void grabPixmap();
+        void grabDirtyRegion();
+        void grabDesktop();
+        void updateScaledRegion(const QPixmap& source, const QRect& sourceRect, const QRect& clipRect);
+
+        void watchWidget(QWidget *widget);
+        void unwatchWidget(QWidget *widget);
+        void invalidate();
+
+        QRect scaledRect(const QRect& sourceRect) const;
+        QPoint pixmapOrigin() const;
 
         int mScreenIndex;
 
-        QWidget* mSourceWidget;
+        QPointer<QWidget> mSourceWidget;
 
         QRect mRect;
 
         QPixmap mLastPixmap;
 
+        // Last raw desktop grab, used to find the tiles that changed between two ticks
+        QImage mLastDesktopImage;
+
+        // Damaged area since the last tick, in source widget coordinates
+        QRegion mDirtyRegion;
+
+        bool mFullRefresh;
+
+        bool mGrabbing;
+
+        QSize mSourceSize;
+
         long mTimerID;
 
 };
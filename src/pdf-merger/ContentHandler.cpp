@@ -96,8 +96,10 @@ string ContentHandler::_getStreamFromReferencies(merge_lib::Object * objectWithA
 //get stream from Object
 string ContentHandler::_getStreamFromContent(merge_lib::Object * objectWithStream)
 {
-   Filter filter(objectWithStream);    
    string decodedStream;
+   if(objectWithStream->takeDecodedStream(decodedStream))
+      return decodedStream;
+   Filter filter(objectWithStream);    
    filter.getDecodedStream(decodedStream);
 
    return decodedStream;
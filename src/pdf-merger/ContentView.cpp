@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "ContentView.h"
+#include <stdexcept>
+#include <string.h>
+
+#include "core/memcheck.h"
+
+using namespace merge_lib;
+
+size_t ContentView::find(const std::string & pattern, size_t from) const
+{
+   if(pattern.empty())
+      return from <= _size ? from : npos;
+   if(from >= _size || pattern.size() > _size - from)
+      return npos;
+   const char * current = _data + from;
+   const char * last = _data + _size - pattern.size();
+   while(current <= last)
+   {
+      current = static_cast<const char *>(memchr(current, pattern[0], last - current + 1));
+      if(!current)
+         return npos;
+      if(!memcmp(current, pattern.data(), pattern.size()))
+         return current - _data;
+      ++current;
+   }
+   return npos;
+}
+
+size_t ContentView::rfind(const std::string & pattern, size_t from) const
+{
+   if(pattern.size() > _size)
+      return npos;
+   size_t position = _size - pattern.size();
+   if(from < position)
+      position = from;
+   while(1)
+   {
+      if(!memcmp(_data + position, pattern.data(), pattern.size()))
+         return position;
+      if(position == 0)
+         break;
+      --position;
+   }
+   return npos;
+}
+
+size_t ContentView::find_first_of(const std::string & characters, size_t from) const
+{
+   for(size_t i = from; i < _size; ++i)
+   {
+      if(memchr(characters.data(), _data[i], characters.size()))
+         return i;
+   }
+   return npos;
+}
+
+size_t ContentView::find_first_not_of(const std::string & characters, size_t from) const
+{
+   for(size_t i = from; i < _size; ++i)
+   {
+      if(!memchr(characters.data(), _data[i], characters.size()))
+         return i;
+   }
+   return npos;
+}
+
+size_t ContentView::find_last_of(const std::string & characters, size_t from) const
+{
+   if(_size == 0)
+      return npos;
+   size_t position = from < _size ? from : _size - 1;
+   while(1)
+   {
+      if(memchr(characters.data(), _data[position], characters.size()))
+         return position;
+      if(position == 0)
+         break;
+      --position;
+   }
+   return npos;
+}
+
+std::string ContentView::substr(size_t position, size_t length) const
+{
+   if(position > _size)
+      throw std::out_of_range("ContentView::substr");
+   if(length > _size - position)
+      length = _size - position;
+   return std::string(_data + position, length);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#if !defined ContentView_h
+#define ContentView_h
+
+#include <string>
+
+namespace merge_lib
+{
+   //Read-only view on bytes owned by somebody else (memory mapped pdf file
+   //or a std::string). It provides the subset of std::string search methods
+   //the parser needs so that file content can be scanned without copying it.
+   //The owner of bytes must outlive the view.
+   class ContentView
+   {
+   public:
+      static const size_t npos = static_cast<size_t>(-1);
+
+      ContentView(): _data(0), _size(0) {}
+      ContentView(const char * data, size_t size): _data(data), _size(size) {}
+      ContentView(const std::string & content): _data(content.data()), _size(content.size()) {}
+
+      const char * data() const { return _data; }
+      size_t       size() const { return _size; }
+      bool         empty() const { return _size == 0; }
+
+      //like std::string, position equal to size() gives '\0'
+      const char & operator[](size_t position) const
+      {
+         static const char endOfContent = '\0';
+         return position < _size ? _data[position] : endOfContent;
+      }
+
+      size_t      find(const std::string & pattern, size_t from = 0) const;
+      size_t      rfind(const std::string & pattern, size_t from = npos) const;
+      size_t      find_first_of(const std::string & characters, size_t from = 0) const;
+      size_t      find_first_not_of(const std::string & characters, size_t from = 0) const;
+      size_t      find_last_of(const std::string & characters, size_t from = npos) const;
+      std::string substr(size_t position, size_t length = npos) const;
+
+   private:
+      const char * _data;
+      size_t       _size;
+   };
+}
+#endif
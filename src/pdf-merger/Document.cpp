@@ -33,17 +33,19 @@
 #include "Utils.h"
 #include "Parser.h"
 #include "Exception.h"
+#include "MappedFile.h"
 #include <fstream>
 #include <iostream>
-#include <iomanip>
+#include <stdio.h>
 
 #include "core/memcheck.h"
 
 using namespace merge_lib;
 const std::string firstObj("%PDF-1.4\n1 0 obj\n<<\n/Title ()/Creator ()/Producer (Qt 4.5.0 (C) 1992-2009 Nokia Corporation and/or its subsidiary(-ies))/CreationDate (D:20090424120829)\n>>\nendobj\n");
 const std::string zeroStr("0000000000");
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
 Document::Document(const char * fileName):
-    _root(0), _pages(), _documentName(fileName), _maxObjectNumber(0)
+    _root(0), _pages(), _documentName(fileName), _maxObjectNumber(0), _mappedFile(0)
 {
 
 }
@@ -60,6 +62,9 @@ Document::~Document()
       delete (*it).second;
    }
    _pages.clear();
+
+   if(_mappedFile)
+      _mappedFile->release();
 }
 
 
@@ -84,11 +89,9 @@ void Document::saveAs(const char * newFileName)
    _root->recalculateObjectNumbers(fromObjNumber);
    _root->retrieveMaxObjectNumber(_maxObjectNumber);
    
-   //sizes of all objects
-   //key - object number
-   //value - size of object
-   std :: map < unsigned int, std::pair<unsigned long long, unsigned int > > sizesAndGenerationNumbers;
+   std::vector<char> outBuffer(OUTPUT_BUFFER_SIZE);
    std::ofstream out;
+   out.rdbuf()->pubsetbuf(&outBuffer[0], outBuffer.size());
    out.open(newFileName, std::ios::binary);
    if(!out.is_open())
    {      
@@ -98,33 +101,38 @@ void Document::saveAs(const char * newFileName)
    }
 
    out << firstObj.c_str();
-   _root->serialize( out, sizesAndGenerationNumbers);
-   
-   std::map< unsigned int, std::pair<unsigned long long, unsigned int > >::iterator sizeIterator;
-
-   unsigned int numberOfObjects = 2;
-   for ( sizeIterator = sizesAndGenerationNumbers.begin() ; sizeIterator != sizesAndGenerationNumbers.end(); sizeIterator++ )
+   Object::XrefEntries xrefEntries;
+   _root->serialize(out, xrefEntries);
+   unsigned long long startOfXref = static_cast<unsigned long long>(out.tellp());
+
+   unsigned int numberOfObjects = xrefEntries.size() + 2;
+
+   //create xref, each entry is exactly 20 bytes long
+   std::string xref;
+   xref.reserve(20 * (numberOfObjects + 2));
+   xref.append("xref\n0 ");
+   xref.append(Utils::uIntToStr(numberOfObjects));
+   xref.append("\n0000000000 65535 f \n0000000009 00000 n \n");
+
+   char entry[21];
+   Object::XrefEntries::const_iterator entryIterator;
+   for ( entryIterator = xrefEntries.begin() ; entryIterator != xrefEntries.end(); entryIterator++ )
    {
-      numberOfObjects++;
+      snprintf(entry, sizeof(entry), "%010llu %05u n \n", (*entryIterator).second.first, (*entryIterator).second.second);
+      xref.append(entry, 20);
    }
-   
-   //create xref
-   out << "xref\n"
-      << "0 " << numberOfObjects  << "\n"
-      << "0000000000 65535 f \n"
-      << "0000000009 00000 n \n";
-
+   out.write(xref.data(), xref.size());
 
-   unsigned long long sizeInXref = firstObj.size();
+   out << "trailer\n<<\n/Size " << numberOfObjects  << "\n/Info 1 0 R\n"
+      << "/Root " << _root->getObjectNumber() << " 0 R\n >>\nstartxref\n" << startOfXref << "\n%%EOF";
 
-   for ( sizeIterator = sizesAndGenerationNumbers.begin() ; sizeIterator != sizesAndGenerationNumbers.end(); sizeIterator++ )
+   out.close();
+   if(out.fail())
    {
-      out << std::setfill('0')<<std::setw(10)<<sizeInXref << " " << std::setw(5) << (*sizeIterator).second.second << " n \n";
-      sizeInXref = sizeInXref + (*sizeIterator).second.first;
+      std::string error("Cannot write file ");
+      error.append(newFileName);
+      throw Exception(error);
    }
-   out << "trailer\n<<\n/Size " << numberOfObjects  << "\n/Info 1 0 R\n"
-      << "/Root " << _root->getObjectNumber() << " 0 R\n >>\nstartxref\n" << sizeInXref << "\n%%EOF";
-
 }
 
 Object * Document::getDocumentObject()
@@ -35,6 +35,8 @@
 
 namespace merge_lib
 {
+   class MappedFile;
+
    //this class contains all info about pdf document
    class Document
    {
@@ -83,6 +85,9 @@ namespace merge_lib
       //max number of all document's objects
       unsigned int _maxObjectNumber;
 
+      //mapping of the source file, objects read their streams from it
+      MappedFile * _mappedFile;
+
    };
 }
 #endif
@@ -42,16 +42,14 @@
 #include "core/memcheck.h"
 
 using namespace merge_lib;
-std::map<std::string, Decoder *> Filter::_allDecoders;
 
 Filter::~Filter()
 {
-   std::map<std::string, Decoder *>::iterator it = _allDecoders.begin();
-   for(; it != _allDecoders.end(); ++it)
+   for(size_t i = 0; i < _decoders.size(); ++i)
    {
-      delete (*it).second;
+      delete _decoders[i];
    }
-   _allDecoders.clear();
+   _decoders.clear();
 }
 
 //replace coded stream with decoded
@@ -85,11 +83,10 @@ std::vector <Decoder * > Filter::_getDecoders()
       unsigned int endOfDecoder = streamHeader.find_first_of(whitespacesAndDelimeters, startOfDecoder);
       if((int)endOfDecoder == -1)
          break;
-      std::map<std::string, Decoder *>::iterator foundDecoder = 
-         _allDecoders.find(streamHeader.substr(startOfDecoder, endOfDecoder - startOfDecoder));
-      if(foundDecoder == _allDecoders.end())
+      Decoder * decoder = _createDecoder(streamHeader.substr(startOfDecoder, endOfDecoder - startOfDecoder));
+      if(!decoder)
          break;
-      Decoder * decoder = foundDecoder->second;
+      _decoders.push_back(decoder);
       decoder->initialize(_objectWithStream);
       result.push_back(decoder);
    }
@@ -98,19 +95,24 @@ std::vector <Decoder * > Filter::_getDecoders()
 
 }
 
-void Filter::_createAllDecodersSet()
+Decoder * Filter::_createDecoder(const std::string & decoderName)
 {
-
-   if(!_allDecoders.empty())
-      return;
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("ASCIIHexDecode"), new ASCIIHexDecode()));
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("ASCII85Decode"), new ASCII85Decode()));   
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("LZWDecode"), new LZWDecode()));   
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("FlateDecode"), new FlateDecode()));   
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("RunLengthDecode"), new RunLengthDecode()));   
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("CCITTFaxDecode"), new CCITTFaxDecode()));   
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("JBIG2Decode"), new JBIG2Decode())); 
-   _allDecoders.insert(std::pair<std::string, Decoder *> (std::string("DCTDecode"), new DCTDecode())); 
+   if(decoderName == "ASCIIHexDecode")
+      return new ASCIIHexDecode();
+   if(decoderName == "ASCII85Decode")
+      return new ASCII85Decode();
+   if(decoderName == "LZWDecode")
+      return new LZWDecode();
+   if(decoderName == "FlateDecode")
+      return new FlateDecode();
+   if(decoderName == "RunLengthDecode")
+      return new RunLengthDecode();
+   if(decoderName == "CCITTFaxDecode")
+      return new CCITTFaxDecode();
+   if(decoderName == "JBIG2Decode")
+      return new JBIG2Decode();
+   if(decoderName == "DCTDecode")
+      return new DCTDecode();
+   return 0;
 }
 
-
@@ -39,13 +39,14 @@ namespace merge_lib
    class Object;
     class Decoder;
    //this class is needed to parse object in order to create
-   //all decoders to decode object's stream
+   //all decoders to decode object's stream.
+   //Decoders keep per-stream state, so every Filter creates its own ones
+   //and filters of different objects can be used in parallel
    class Filter
    {
    public:
-      Filter(Object * objectWithStream): _objectWithStream(objectWithStream)
+      Filter(Object * objectWithStream): _objectWithStream(objectWithStream), _decoders()
       {
-         _createAllDecodersSet();
       }
       virtual ~Filter();
       //replace coded stream with decoded
@@ -56,11 +57,11 @@ namespace merge_lib
       //parse object's content and fill out vector with
       //necessary decoders
       std::vector <Decoder * > _getDecoders();
-      void _createAllDecodersSet();
+      static Decoder * _createDecoder(const std::string & decoderName);
 
       //members
       Object * _objectWithStream;
-      static std::map<std::string, Decoder *> _allDecoders;
+      std::vector <Decoder * > _decoders;
    };
 }
 #endif
@@ -261,6 +261,7 @@ bool FilterPredictor::decode(std::string &content)
 
    int inSize = content.size();
    std::string  out = "";
+   out.reserve(rows * _rowLen);
 
    if( inSize%(isPNG?_rowLen+1:_rowLen) != 0 )
    {
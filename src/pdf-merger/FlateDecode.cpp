@@ -33,17 +33,23 @@
 #include "zlib.h"
 #include "Utils.h"
 #include <string.h>
+#include <algorithm>
 
 #include "core/memcheck.h"
 
 using namespace merge_lib;
+
+const std::string DECODED_LENGTH_TOKEN = "/DL";
 #define ZLIB_MEM_DELTA 65535
+#define ZLIB_EXPECTED_RATIO 4
+// /DL comes from the file, a larger announced ratio is left to the doubling loop
+#define ZLIB_MAX_HINT_RATIO 64
 #define ZLIB_CHECK_ERR(err,msg) \
    if( err != Z_OK) {\
    std::cout<<msg<<" ZLIB error:"<<err<<std::endl; \
    }\
 
-FlateDecode::FlateDecode():_predict(NULL)
+FlateDecode::FlateDecode():_predict(NULL), _decodedSizeHint(0)
 {
 }
 
@@ -64,17 +70,20 @@ void FlateDecode::initialize(Object * objectWithStream)
 
       if((int) head.find(FilterPredictor::DECODE_PARAM_TOKEN)  != -1 )
       {
+         delete _predict;
          _predict = new FilterPredictor();
          _predict->initialize(objectWithStream);
       }
 
+      // PDF 1.5 streams may announce their decoded length
+      std::string decodedLength = objectWithStream->getNameSimpleValue(head, DECODED_LENGTH_TOKEN);
+      _decodedSizeHint = decodedLength.empty() ? 0 : Utils::stringToInt(decodedLength);
    }
 }
 
 /** @brief encode
 *
-* @todo:
-document this function
+* deflates the whole buffer at once into output sized by deflateBound
 */
 bool FlateDecode::encode(std::string &decoded)
 {   
@@ -84,70 +93,44 @@ bool FlateDecode::encode(std::string &decoded)
    stream.zfree = (free_func)0;
    stream.opaque = (voidpf)0;
 
-   size_t out_len = 0;
-   unsigned char *out_p = NULL;
-
-   stream.next_out = out_p;
-   stream.avail_out = (uInt)out_len;
-
-   stream.next_in = (unsigned char*)decoded.c_str();
-   stream.avail_in = (uInt)decoded.size();
-
    int err = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
    ZLIB_CHECK_ERR(err, "deflateInit");
    if ( err != Z_OK )
    {
       return false;
    }
-   bool toContinue = false;
-   int flush = Z_NO_FLUSH;
-   do
-   {
-      toContinue = false;
-      flush = (stream.avail_in == 0)?Z_FINISH:Z_NO_FLUSH;
 
-      if ( !stream.avail_out )
-      {
-         // increase the space
-         out_p = (unsigned char*)realloc(out_p,out_len + ZLIB_MEM_DELTA);
-
-         // init new memory
-         unsigned char *new_out_start = out_p + out_len;
-         memset(new_out_start,0,ZLIB_MEM_DELTA);
-
-         // Point next_out to the next unused byte
-         stream.next_out = new_out_start;
+   std::string encoded;
+   encoded.resize(deflateBound(&stream, (uLong)decoded.size()));
 
-         // Update the size of the buffer
-         stream.avail_out = (uInt)ZLIB_MEM_DELTA;
-         out_len += ZLIB_MEM_DELTA;
-      }
-
-      err = deflate(&stream,flush);
-      if ( err == Z_OK && stream.avail_out == 0 )
-      {
-         toContinue = true;
-      }
+   stream.next_in = (unsigned char*)decoded.data();
+   stream.avail_in = (uInt)decoded.size();
+   stream.next_out = (unsigned char*)&encoded[0];
+   stream.avail_out = (uInt)encoded.size();
 
+   err = deflate(&stream, Z_FINISH);
+   if( err != Z_STREAM_END )
+   {
+      ZLIB_CHECK_ERR(err, "deflate");
+      deflateEnd(&stream);
+      return false;
    }
-   while ( toContinue || flush == Z_NO_FLUSH );
 
    err = deflateEnd(&stream);
    ZLIB_CHECK_ERR(err, "deflateEnd");
    if( err != Z_OK )
    {
-      free(out_p);
       return false;
    }
 
-   decoded = std::string((char*)out_p,stream.total_out);
-   free(out_p);
+   encoded.resize(stream.total_out);
+   decoded.swap(encoded);
    return true;
 }
 
 /** @brief decode
 *
-* @todo: document this function
+* output starts from the announced (or estimated) decoded size and grows geometrically
 */
 bool FlateDecode::decode(std::string & encoded)
 {
@@ -158,9 +141,7 @@ bool FlateDecode::decode(std::string & encoded)
    stream.zfree = (free_func)0;
    stream.opaque = (voidpf)0;
 
-   //trace_hex((char*)encoded.c_str(),encoded.size());
-
-   stream.next_in  = (unsigned char*)encoded.c_str();
+   stream.next_in  = (unsigned char*)encoded.data();
    stream.avail_in = (uInt)encoded.size();
 
    int err = inflateInit(&stream);
@@ -169,30 +150,22 @@ bool FlateDecode::decode(std::string & encoded)
    {
       return false;
    }
-   unsigned char *out_p = NULL;
-   int out_len = 0;
 
-   stream.next_out = out_p;
-   stream.avail_out = out_len;
+   std::string decoded;
+   size_t decodedSize = _decodedSizeHint ? std::min(_decodedSizeHint, encoded.size() * ZLIB_MAX_HINT_RATIO)
+                                         : encoded.size() * ZLIB_EXPECTED_RATIO;
+   decoded.resize(std::max(decodedSize, (size_t)ZLIB_MEM_DELTA));
 
    for (;;)
    {
-      if ( !stream.avail_out)
+      if ( stream.total_out == decoded.size() )
       {
-         // there is no more space for deallocation - increase the space
-         out_p = (unsigned char*)realloc(out_p,out_len + ZLIB_MEM_DELTA);
-
-         // init new memory
-         unsigned char *new_out_start = out_p + out_len;
-         memset(new_out_start,0,ZLIB_MEM_DELTA);
-
-         // Point next_out to the next unused byte
-         stream.next_out = new_out_start;
-
-         // Update the size of the uncompressed buffer
-         stream.avail_out = (uInt)ZLIB_MEM_DELTA;
-         out_len += ZLIB_MEM_DELTA;
+         // there is no more space for decompression - double it
+         decoded.resize(decoded.size() * 2);
       }
+      stream.next_out = (unsigned char*)&decoded[stream.total_out];
+      stream.avail_out = (uInt)(decoded.size() - stream.total_out);
+
       err = inflate(&stream,Z_NO_FLUSH);
 
       if ( err == Z_STREAM_END)
@@ -202,10 +175,7 @@ bool FlateDecode::decode(std::string & encoded)
       ZLIB_CHECK_ERR(err,"Deflate");
       if ( err != Z_OK )
       {         
-         if( out_p )
-         {
-            free(out_p);
-         }
+         inflateEnd(&stream);
          return false;
       }
    }
@@ -213,15 +183,10 @@ bool FlateDecode::decode(std::string & encoded)
    ZLIB_CHECK_ERR(err,"InflateEnd");
    if( err != Z_OK )
    {
-      if( out_p )
-      {
-         free(out_p);
-      }
       return false;
    }
-   encoded = std::string((char*)out_p,stream.total_out);
-   free(out_p);
-   //    trace_hex((char*)encoded.c_str(),encoded.size());
+   decoded.resize(stream.total_out);
+   encoded.swap(decoded);
    // if predictor exists for that object, then lets decode it
    if( _predict )
    {
@@ -230,4 +195,3 @@ bool FlateDecode::decode(std::string & encoded)
 
    return true;
 }
-
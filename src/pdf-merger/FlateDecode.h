@@ -49,6 +49,7 @@ namespace merge_lib
          void initialize(Object * objectWithStream);
       private:
          FilterPredictor *_predict;
+         size_t _decodedSizeHint;
    };
 }
 #endif // FLATEDECODE_H_INCLUDED
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "MappedFile.h"
+#include <string.h>
+#include <QMutexLocker>
+
+#include "core/memcheck.h"
+
+using namespace merge_lib;
+
+std::map<std::string, MappedFile *> MappedFile::_mappedFiles;
+QMutex MappedFile::_mappedFilesMutex;
+
+MappedFile::MappedFile(const std::string & fileName):
+   _fileName(fileName), _file(QString::fromLocal8Bit(fileName.c_str())), _data(0), _size(0), _references(1)
+{
+   if(_file.open(QIODevice::ReadOnly) && _file.size() > 0)
+   {
+      _size = _file.size();
+      _data = _file.map(0, _file.size());
+   }
+}
+
+MappedFile::~MappedFile()
+{
+   if(_data)
+      _file.unmap(_data);
+   _file.close();
+}
+
+MappedFile * MappedFile::acquire(const std::string & fileName)
+{
+   QMutexLocker locker(&_mappedFilesMutex);
+   std::map<std::string, MappedFile *>::iterator it = _mappedFiles.find(fileName);
+   if(it != _mappedFiles.end())
+   {
+      ++(*it).second->_references;
+      return (*it).second;
+   }
+   MappedFile * mappedFile = new MappedFile(fileName);
+   if(!mappedFile->_data)
+   {
+      delete mappedFile;
+      return 0;
+   }
+   _mappedFiles[fileName] = mappedFile;
+   return mappedFile;
+}
+
+void MappedFile::release()
+{
+   QMutexLocker locker(&_mappedFilesMutex);
+   if(--_references > 0)
+      return;
+   _mappedFiles.erase(_fileName);
+   delete this;
+}
+
+bool MappedFile::read(const std::string & fileName, size_t offset, size_t length, std::string & out)
+{
+   QMutexLocker locker(&_mappedFilesMutex);
+   std::map<std::string, MappedFile *>::const_iterator it = _mappedFiles.find(fileName);
+   if(it == _mappedFiles.end())
+      return false;
+   const MappedFile * mappedFile = (*it).second;
+   if(offset > mappedFile->_size || length > mappedFile->_size - offset)
+      return false;
+   out.assign(mappedFile->data() + offset, length);
+   return true;
+}
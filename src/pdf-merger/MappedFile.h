@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2015-2016 Département de l'Instruction Publique (DIP-SEM)
+ *
+ * Copyright (C) 2013 Open Education Foundation
+ *
+ * Copyright (C) 2010-2013 Groupement d'Intérêt Public pour
+ * l'Education Numérique en Afrique (GIP ENA)
+ *
+ * This file is part of OpenBoard.
+ *
+ * OpenBoard is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License,
+ * with a specific linking exception for the OpenSSL project's
+ * "OpenSSL" library (or with modified versions of it that use the
+ * same license as the "OpenSSL" library).
+ *
+ * OpenBoard is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenBoard. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#if !defined MappedFile_h
+#define MappedFile_h
+
+#include <QFile>
+#include <QMutex>
+
+#include <map>
+#include <string>
+
+namespace merge_lib
+{
+   //Read-only memory mapping of a pdf file shared by everybody who works
+   //with this file: the parser scans it, objects read their streams from it.
+   //Mapping is reference counted and unmapped when the last user releases it.
+   class MappedFile
+   {
+   public:
+      //returns 0 if the file can not be mapped
+      static MappedFile * acquire(const std::string & fileName);
+      void                release();
+
+      //copies [offset, offset + length) of the file if it is mapped now
+      static bool read(const std::string & fileName, size_t offset, size_t length, std::string & out);
+
+      const char * data() const { return reinterpret_cast<const char *>(_data); }
+      size_t       size() const { return _size; }
+
+   private:
+      MappedFile(const std::string & fileName);
+      ~MappedFile();
+
+      std::string _fileName;
+      QFile       _file;
+      uchar *     _data;
+      size_t      _size;
+      int         _references;
+
+      static std::map<std::string, MappedFile *> _mappedFiles;
+      static QMutex                              _mappedFilesMutex;
+   };
+}
+#endif
@@ -31,9 +31,15 @@
 #include "Parser.h"
 #include "OverlayDocumentParser.h"
 #include "Exception.h"
+#include "Filter.h"
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <iostream>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include "core/memcheck.h"
 
@@ -41,6 +47,42 @@ using namespace merge_lib;
 
 Parser Merger::_parser;
 
+//number of pages whose content streams are decoded ahead of merging,
+//limits memory used by decoded streams
+const size_t DECODED_PAGES = 32;
+
+namespace
+{
+   //decodes one content stream on a worker thread,
+   //decoded stream is taken by ContentHandler during merge
+   class ContentStreamDecoding : public QRunnable
+   {
+   public:
+      ContentStreamDecoding(Object * objectWithStream): _objectWithStream(objectWithStream)
+      {
+      }
+
+      void run()
+      {
+         std::string decodedStream;
+         try
+         {
+            Filter filter(_objectWithStream);
+            filter.getDecodedStream(decodedStream);
+         }
+         catch(std::exception &)
+         {
+            //stream will be decoded again during merge, which reports the error
+            return;
+         }
+         _objectWithStream->setDecodedStream(decodedStream);
+      }
+
+   private:
+      Object * _objectWithStream;
+   };
+}
+
 Merger::Merger():_baseDocuments(),_overlayDocument(0)
 {
 
@@ -101,9 +143,16 @@ void Merger::merge(const char * overlayDocName, const MergeDescription & pagesTo
          throw Exception("Error loading overlay document!");
       }
    }
+   std::vector<Object *> decodedObjects;
    MergeDescription::const_iterator pageIterator = pagesToMerge.begin();
    for(; pageIterator != pagesToMerge.end(); ++pageIterator )
    {            
+      size_t pageIndex = pageIterator - pagesToMerge.begin();
+      if(pageIndex % DECODED_PAGES == 0)
+      {
+         _forgetDecodedStreams(decodedObjects);
+         decodedObjects = _decodeContentStreams(pagesToMerge, pageIndex, DECODED_PAGES);
+      }
       Page * destinationPage = _overlayDocument->getPage( (*pageIterator).overlayPageNumber);
       if( destinationPage == 0 )
       {
@@ -130,7 +179,54 @@ void Merger::merge(const char * overlayDocName, const MergeDescription & pagesTo
 
       destinationPage->merge(sourcePage, _overlayDocument, const_cast<MergePageDescription&>((*pageIterator)), isPageDuplicated);
    }
+   _forgetDecodedStreams(decodedObjects);
+}
+
+std::vector<Object *> Merger::_decodeContentStreams(const MergeDescription & pagesToMerge, size_t firstPage, size_t numberOfPages)
+{
+   std::vector<Object *> contentStreams;
+   size_t lastPage = std::min(firstPage + numberOfPages, pagesToMerge.size());
+   for(size_t i = firstPage; i < lastPage; ++i)
+   {
+      const MergePageDescription & description = pagesToMerge[i];
+      if(!description.skipOverlayPage)
+      {
+         Page * overlayPage = _overlayDocument->getPage(description.overlayPageNumber);
+         if(overlayPage)
+            overlayPage->getContentStreams(contentStreams);
+      }
+      if(!description.skipBasePage)
+      {
+         std::map<std::string, Document *>::const_iterator baseDocument = _baseDocuments.find(description.baseDocumentName);
+         Page * basePage = (baseDocument == _baseDocuments.end()) ? 0 : (*baseDocument).second->getPage(description.basePageNumber);
+         if(basePage)
+            basePage->getContentStreams(contentStreams);
+      }
+   }
 
+   //pages may share content streams
+   std::set<Object *> uniqueStreams(contentStreams.begin(), contentStreams.end());
+   std::vector<Object *> decodedObjects(uniqueStreams.begin(), uniqueStreams.end());
+
+   QThreadPool pool;
+   pool.setMaxThreadCount(QThread::idealThreadCount());
+   for(size_t i = 0; i < decodedObjects.size(); ++i)
+   {
+      pool.start(new ContentStreamDecoding(decodedObjects[i]));
+   }
+   pool.waitForDone();
+   return decodedObjects;
+}
+
+//streams which were not taken (e.g. pages cloned instead of merged) are not needed anymore
+void Merger::_forgetDecodedStreams(std::vector<Object *> & decodedObjects)
+{
+   std::string unused;
+   for(size_t i = 0; i < decodedObjects.size(); ++i)
+   {
+      decodedObjects[i]->takeDecodedStream(unused);
+   }
+   decodedObjects.clear();
 }
 // Method performs saving of merged documents into selected file
 void Merger::saveMergedDocumentsAs(const char * outDocumentName)
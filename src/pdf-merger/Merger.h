@@ -57,6 +57,11 @@ namespace merge_lib
       void merge(const char *overlayDocName, const MergeDescription & pagesToMerge);
 
    private:
+      //decodes content streams of pages [firstPage, firstPage + numberOfPages) in parallel
+      //and returns objects which got decoded stream
+      std::vector<Object *> _decodeContentStreams(const MergeDescription & pagesToMerge, size_t firstPage, size_t numberOfPages);
+      void                  _forgetDecodedStreams(std::vector<Object *> & decodedObjects);
+
       std::map<std::string, Document * > _baseDocuments;
       static Parser _parser;
       Document * _overlayDocument;
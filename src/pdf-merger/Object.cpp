@@ -30,6 +30,7 @@
 #include "Object.h"
 #include "Parser.h"
 #include "Exception.h"
+#include "MappedFile.h"
 #include <string.h>
 #include <algorithm>
 #include <fstream>
@@ -261,33 +262,23 @@ void Object::insertToContent(unsigned int position, const char * insertedStr, un
    _content.insert(position, insertedStr, length);    
 }
 
-//vector <object number, its size>
-void Object::serialize(std::ofstream & out, std::map< unsigned int, std::pair<unsigned long long, unsigned int > > & sizesAndGenerationNumbers)
+void Object::serialize(std::ofstream & out, XrefEntries & xrefEntries)
 {
    //is this element already printed
-   if(sizesAndGenerationNumbers.find(_number) != sizesAndGenerationNumbers.end()) return;
+   if(xrefEntries.find(_number) != xrefEntries.end()) return;
 
-   std::string stream;
-   if(_hasStream && !_hasStreamInContent)
-   {       
-      getStream(stream);
-      stream.append("endstream\n");       
-   }
-   // xxxx + " " + "0" + " " + "obj" + "\n" + _content.size() + "endobj\n", where x - is a digit
-   unsigned long long objectSizeForXref = (static_cast<unsigned int>(std::log10(static_cast<double>(_number))) + 1) + 14 + _content.size() + stream.size();    
-
-   sizesAndGenerationNumbers.insert(std::pair<unsigned int, std::pair<unsigned long long, unsigned int > >(_number, std::make_pair(objectSizeForXref, _generationNumber)));
+   //xref is built while writing, so offsets are taken from the stream itself
+   unsigned long long offset = static_cast<unsigned long long>(out.tellp());
+   xrefEntries.insert(std::make_pair(_number, std::make_pair(offset, _generationNumber)));
 
-   _serialize(out, stream);
-   stream.clear();
-   stream.reserve();
+   _serialize(out);
 
    //call serialize of each child
    Children::iterator it;
    for ( it=_children.begin() ; it != _children.end(); it++ )
    {
       Object * currentChild = (*it).second.first;
-      currentChild->serialize(out, sizesAndGenerationNumbers);
+      currentChild->serialize(out, xrefEntries);
    }
 }
 void Object::recalculateObjectNumbers(unsigned int & newNumber)
@@ -429,10 +420,34 @@ void Object::_addParent(Object * child)
 {
    _parents.insert(child);
 }
-void Object::_serialize(std::ofstream  & out, const std::string & stream)
+void Object::_serialize(std::ofstream  & out)
+{
+   out << _number << " " << _generationNumber << " obj\n" << _content;
+   if(_hasStream && !_hasStreamInContent)
+   {
+      _writeStream(out);
+      out << "endstream\n";
+   }
+   out << "endobj\n";
+}
+
+//unchanged streams are copied from the source file mapping to the output
+//without loading them into memory
+void Object::_writeStream(std::ofstream & out)
 {
-    out << _number << " " << _generationNumber << " obj\n" << _content << stream << "endobj\n";
-   out.flush();
+   MappedFile * mappedFile = MappedFile::acquire(_fileName);
+   if(mappedFile)
+   {
+      bool isInFile = (_streamBounds.first <= _streamBounds.second) && (_streamBounds.second <= mappedFile->size());
+      if(isInFile)
+         out.write(mappedFile->data() + _streamBounds.first, _streamBounds.second - _streamBounds.first);
+      mappedFile->release();
+      if(isInFile)
+         return;
+   }
+   std::string stream;
+   getStream(stream);
+   out.write(stream.data(), stream.size());
 }
 
 /** @brief getStream
@@ -451,6 +466,11 @@ bool Object::getStream(std::string & stream)
          return false;
    }
 
+   // get length of file:
+   int length = _streamBounds.second - _streamBounds.first;
+   if(MappedFile::read(_fileName, _streamBounds.first, length, stream))
+      return true;
+
    std::ifstream pdfFile;
    pdfFile.open (_fileName.c_str(), std::ios::binary );
    if (pdfFile.fail())
@@ -459,8 +479,6 @@ bool Object::getStream(std::string & stream)
       errorMessage << _fileName << " is absent" << "\0";
       throw Exception(errorMessage);
    }
-   // get length of file:
-   int length = _streamBounds.second - _streamBounds.first;
    pdfFile.seekg (_streamBounds.first, std::ios_base::beg);
    stream.resize(length);
    pdfFile.read(&stream[0], length);   
@@ -468,6 +486,22 @@ bool Object::getStream(std::string & stream)
    return true;
 }
 
+void Object::setDecodedStream(std::string & decodedStream)
+{
+   _decodedStream.swap(decodedStream);
+   _hasDecodedStream = true;
+}
+
+bool Object::takeDecodedStream(std::string & decodedStream)
+{
+   if(!_hasDecodedStream)
+      return false;
+   decodedStream.swap(_decodedStream);
+   _decodedStream.clear();
+   _hasDecodedStream = false;
+   return true;
+}
+
 bool Object::_getStreamFromContent(std::string & stream)
 {
    size_t stream_begin = _content.find("stream");
@@ -63,7 +63,8 @@ namespace merge_lib
            std::string fileName = "", std::pair<unsigned int, unsigned int> streamBounds = std::make_pair ((unsigned int)0,(unsigned int)0), bool hasStream = false
                   ):
        _number(objectNumber), _generationNumber(generationNumber), _oldNumber(objectNumber), _content(objectContent),_parents(),_children(),_isPassed(false),
-           _streamBounds(streamBounds), _fileName(fileName), _hasStream(hasStream), _hasStreamInContent(false)
+           _streamBounds(streamBounds), _fileName(fileName), _hasStream(hasStream), _hasStreamInContent(false),
+           _decodedStream(), _hasDecodedStream(false)
        {
        }
        virtual ~Object();
@@ -93,8 +94,9 @@ namespace merge_lib
        void                        insertToContent(unsigned int position, const char * insertedStr, unsigned int length);
        void                        insertToContent(unsigned int position, const std::string & insertedStr);   
 
-       //vector <object number, its size>
-       void serialize(std::ofstream & out, std::map< unsigned int, std::pair<unsigned long long, unsigned int > > & sizesAndGenerationNumbers);
+       //key - object number, value - offset of the object in the written file and its generation number
+       typedef std::map<unsigned int, std::pair<unsigned long long, unsigned int> > XrefEntries;
+       void serialize(std::ofstream & out, XrefEntries & xrefEntries);
 
        void recalculateObjectNumbers(unsigned int & newNumber);
 
@@ -134,6 +136,11 @@ namespace merge_lib
             _hasStream = true;
        }
 
+       //stream decoded ahead of time, see Merger::merge.
+       //Both methods swap the buffers, so decoded stream is handed over only once
+       void setDecodedStream(std::string & decodedStream);
+       bool takeDecodedStream(std::string & decodedStream);
+
        std::string getNameSimpleValue(const std::string &content, const std::string &patten, size_t pos = 0);
        
        unsigned int getChildPosition(const Object * child); //throw (Exception)
@@ -152,7 +159,8 @@ namespace merge_lib
        void _setObjectNumber(unsigned int objectNumber);       
        void _addParent(Object * child);
        bool _findObject(const std::string & token, Object* & foundObject, unsigned int & tokenPositionInContent);
-       void _serialize(std::ofstream  & out, const std::string & stream);
+       void _serialize(std::ofstream  & out);
+       void _writeStream(std::ofstream & out);
        void _recalculateObjectNumbers(unsigned int & maxNumber);
        void _recalculateReferencePositions(unsigned int changedReference, int displacement);
        void _retrieveMaxObjectNumber(unsigned int & maxNumber);
@@ -171,6 +179,8 @@ namespace merge_lib
        std::string                           _fileName;
        bool                                  _hasStream;
        bool                                  _hasStreamInContent;
+       std::string                           _decodedStream;
+       bool                                  _hasDecodedStream;
 
     };
 }
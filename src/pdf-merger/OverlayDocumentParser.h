@@ -45,7 +45,7 @@ namespace merge_lib
    class OverlayDocumentParser: private Parser
    {
    public:   
-      OverlayDocumentParser(): Parser(), _fileName()  {};
+      OverlayDocumentParser(): Parser(), _fileName(), _partOfFileContent()  {};
       Document * parseDocument(const char * fileName);
 
    protected:
@@ -63,6 +63,8 @@ namespace merge_lib
 
       //members
       std::string _fileName;
+      //the part of the file which is parsed now, _fileContent looks at it
+      std::string _partOfFileContent;
    };
 }
 #endif
@@ -80,6 +80,28 @@ void Page::recalculateObjectNumbers(unsigned int & newNumber)
    _root->recalculateObjectNumbers(newNumber);
 }
 
+void Page::getContentStreams(std::vector<Object *> & contentStreams)
+{
+   std::string contentsToken("/Contents");
+   std::string & content = _root->getObjectContent();
+   size_t startOfContents = Parser::findTokenName(content, contentsToken);
+   if((int) startOfContents == -1 )
+   {
+      return;
+   }
+   size_t endOfContents = Parser::findEndOfElementContent(content, startOfContents + contentsToken.size());
+   if((int) endOfContents == -1 )
+   {
+      endOfContents = content.size();
+   }
+   std::vector<Object *> contents = _root->getChildrenByBounds(startOfContents, endOfContents);
+   for(size_t i = 0; i < contents.size(); ++i)
+   {
+      if(contents[i]->hasStream())
+         contentStreams.push_back(contents[i]);
+   }
+}
+
 Object * Page::pageToXObject(std::vector<Object *> & allObjects, std::vector<Object *> & annots, bool isCloneNeeded)
 {
    Object * xObject = (isCloneNeeded) ? _root->getClone(allObjects) : _root;
@@ -59,6 +59,8 @@ namespace merge_lib
       std::string & getPageContent();
       const Object::Children &   getPageRefs();
       Object * pageToXObject(std::vector<Object *> & allObjects, std::vector<Object *> & annots, bool isCloneNeeded);
+      //objects with streams referenced by /Contents of the page
+      void getContentStreams(std::vector<Object *> & contentStreams);
       void setRotation(int rotation)
       {
          _rotation = rotation;
@@ -33,9 +33,12 @@
 #include <vector>
 #include <map>
 #include <stack>
+#include <set>
 #include <string.h>
 #include "Parser.h"
 #include "Object.h"
+#include "Filter.h"
+#include "MappedFile.h"
 #include "Exception.h"
 #include "Utils.h"
 
@@ -112,28 +115,24 @@ void Parser::_createDocument(const char * docName)
 void Parser::_clearParser()
 {
    _root = 0;
-   _fileContent.clear();
-   _fileContent.reserve();
+   _fileContent = ContentView();
    _objects.clear();
 }
 
 
 void Parser::_getFileContent(const char * fileName)
 {
-   ifstream pdfFile;
-   pdfFile.open (fileName, ios::binary );
-   if (pdfFile.fail())
+   //file is mapped instead of read, objects keep positions in it
+   //and read their streams from the mapping later
+   MappedFile * mappedFile = MappedFile::acquire(fileName);
+   if (!mappedFile)
    {
       stringstream errorMessage("File ");
       errorMessage << fileName << " is absent" << "\0";
       throw Exception(errorMessage);
    }
-   // get length of file:
-   pdfFile.seekg (0, ios::end);
-   int length = pdfFile.tellg();
-   pdfFile.seekg (0, ios::beg);
-   _fileContent.resize(length);
-   pdfFile.read(&_fileContent[0], length);
+   _document->_mappedFile = mappedFile;
+   _fileContent = ContentView(mappedFile->data(), mappedFile->size());
 
    // check version
    const char *header = "%PDF-1.";
@@ -142,7 +141,7 @@ void Parser::_getFileContent(const char * fileName)
    {
       verPos += strlen(header);
       char ver = _fileContent[verPos];
-      if( ver < '0' || ver > '4' )
+      if( ver < '0' || ver > '7' )
       {
          stringstream errorMsg;
          errorMsg<<" File with verion 1."<<ver<<" is not currently supported by merge library\n";
@@ -153,7 +152,6 @@ void Parser::_getFileContent(const char * fileName)
    {
       throw Exception("Unrecognized header of PDF file");
    }
-   pdfFile.close();
 }
 
 
@@ -280,13 +278,25 @@ unsigned int Parser::_skipNumber(const std::string & str, unsigned int currentPo
 }
 void Parser::_readXRefAndCreateObjects()
 {      
+   CompressedObjects compressedObjects;
+   std::set<unsigned int> xrefStreams;
+   std::set<unsigned int> readXrefs;
    unsigned int currentPostion = _getStartOfXrefWithRoot();
-   do
+   bool hasPreviosXref = true;
+   while(hasPreviosXref)
    {
+      //corrupted /Prev chains must not make us loop forever
+      if(readXrefs.count(currentPostion))
+         break;
+      readXrefs.insert(currentPostion);
+
+      unsigned int startOfXref = currentPostion;
       const std::string & currentToken = _getNextToken(currentPostion);
       if(currentToken != "xref")
       {
-         throw Exception("Wrong xref in some document");
+         //PDF 1.5 cross-reference stream: "<number> <generation> obj << /Type /XRef ..."
+         hasPreviosXref = _readXRefStream(startOfXref, compressedObjects, xrefStreams, currentPostion);
+         continue;
       }
       unsigned int endOfLine = _getEndOfLineFromContent(currentPostion );
       if(_countTokens(currentPostion, endOfLine) != 2)
@@ -310,24 +320,7 @@ void Parser::_readXRefAndCreateObjects()
                const string & use         = _getNextToken(currentPostion);
                if(!use.compare("n"))
                {
-                  unsigned int objectNumber;
-
-                  try               
-                  {
-                     std::pair<unsigned int, unsigned int> streamBounds;
-                     bool hasObjectStream;
-                     unsigned int generationNumber;
-                     const std::string content = _getObjectContent(first, objectNumber, generationNumber, streamBounds, hasObjectStream);
-                     if(!_objects.count(objectNumber))
-                     {
-                        Object * newObject = new Object(objectNumber, generationNumber, content, _document->_documentName ,streamBounds, hasObjectStream);
-                        _objects[objectNumber] = newObject;
-                     }
-                  }
-                  catch(std::exception &)
-                  {
-                  }
-
+                  _createObject(first, compressedObjects);
                }
             }
             else
@@ -351,10 +344,219 @@ void Parser::_readXRefAndCreateObjects()
             currentPostion = previosPostion;
 
       }
+
+      //hybrid files keep objects from object streams in a cross-reference stream
+      //which is referenced by /XRefStm and has to be read before /Prev
+      unsigned int startOfTrailer = Parser::findToken(_fileContent, "trailer", currentPostion);
+      unsigned int endOfTrailer = _fileContent.find("startxref", startOfTrailer);
+      std::string xrefStreamToken("/XRefStm");
+      unsigned int startOfXrefStream = Parser::findToken(_fileContent, xrefStreamToken, startOfTrailer);
+      if(((int)startOfXrefStream != -1) && (startOfXrefStream < endOfTrailer))
+      {
+         startOfXrefStream += xrefStreamToken.size();
+         unsigned int xrefStream = Utils::stringToInt(Parser::getNextToken(_fileContent, startOfXrefStream));
+         unsigned int ignoredPrev;
+         _readXRefStream(xrefStream, compressedObjects, xrefStreams, ignoredPrev);
+      }
+      hasPreviosXref = _readTrailerAndRterievePrev(currentPostion, currentPostion);
+   }
+   _createCompressedObjects(compressedObjects);
+   _dropXRefStreams(xrefStreams);
+}
+
+void Parser::_createObject(unsigned long objectPosition, const CompressedObjects & compressedObjects)
+{
+   try               
+   {
+      std::pair<unsigned int, unsigned int> streamBounds;
+      bool hasObjectStream;
+      unsigned int objectNumber;
+      unsigned int generationNumber;
+      const std::string content = _getObjectContent(objectPosition, objectNumber, generationNumber, streamBounds, hasObjectStream);
+      //the newest xref section wins, objects may be already read or stored in object stream
+      if(!_objects.count(objectNumber) && !compressedObjects.count(objectNumber))
+      {
+         Object * newObject = new Object(objectNumber, generationNumber, content, _document->_documentName ,streamBounds, hasObjectStream);
+         _objects[objectNumber] = newObject;
+      }
+   }
+   catch(std::exception &)
+   {
+   }
+}
+
+//reads big-endian field of cross-reference stream entry
+static unsigned long readXRefStreamField(const unsigned char * field, unsigned int width)
+{
+   unsigned long value = 0;
+   for(unsigned int i = 0; i < width; ++i)
+      value = (value << 8) | field[i];
+   return value;
+}
+
+bool Parser::_readXRefStream(unsigned int xrefPosition, CompressedObjects & compressedObjects, std::set<unsigned int> & xrefStreams, unsigned int & previosXref)
+{
+   std::pair<unsigned int, unsigned int> streamBounds;
+   bool hasObjectStream;
+   unsigned int objectNumber;
+   unsigned int generationNumber;
+   const std::string content = _getObjectContent(xrefPosition, objectNumber, generationNumber, streamBounds, hasObjectStream);
+   if(!hasObjectStream || ((int)Parser::findToken(content, "/XRef") == -1))
+   {
+      throw Exception("Wrong xref in some document");
+   }
+   xrefStreams.insert(objectNumber);
+   Object xrefObject(objectNumber, generationNumber, content, _document->_documentName, streamBounds, hasObjectStream);
+   std::string entries;
+   Filter filter(&xrefObject);
+   filter.getDecodedStream(entries);
+
+   //widths of the three fields of each entry: type, offset (or object stream), generation (or index)
+   std::vector<unsigned int> widths = _readNumbersArray(content, "/W");
+   if(widths.size() != 3)
+   {
+      throw Exception("Wrong xref stream in some document");
+   }
+   unsigned int entrySize = widths[0] + widths[1] + widths[2];
+   std::vector<unsigned int> subsections = _readNumbersArray(content, "/Index");
+   if(subsections.empty())
+   {
+      subsections.push_back(0);
+      subsections.push_back(Utils::stringToInt(xrefObject.getNameSimpleValue(content, "/Size")));
+   }
+
+   size_t entryPosition = 0;
+   for(size_t i = 0; i + 1 < subsections.size(); i += 2)
+   {
+      for(unsigned int j = 0; j < subsections[i + 1]; ++j)
+      {
+         if(entryPosition + entrySize > entries.size())
+            break;
+         const unsigned char * entry = reinterpret_cast<const unsigned char *>(entries.data()) + entryPosition;
+         entryPosition += entrySize;
+         //type 1 is default when its width is 0
+         unsigned long type = widths[0] ? readXRefStreamField(entry, widths[0]) : 1;
+         unsigned long second = readXRefStreamField(entry + widths[0], widths[1]);
+         unsigned long third = readXRefStreamField(entry + widths[0] + widths[1], widths[2]);
+         unsigned int entryObjectNumber = subsections[i] + j;
+         if(type == 1)
+         {
+            _createObject(second, compressedObjects);
+         }
+         else if((type == 2) && !_objects.count(entryObjectNumber) && !compressedObjects.count(entryObjectNumber))
+         {
+            compressedObjects[entryObjectNumber] = std::make_pair((unsigned int)second, (unsigned int)third);
+         }
+      }
+   }
+
+   std::string prev = xrefObject.getNameSimpleValue(content, "/Prev");
+   if(prev.empty())
+      return false;
+   previosXref = Utils::stringToInt(prev);
+   return true;
+}
+
+void Parser::_createCompressedObjects(const CompressedObjects & compressedObjects)
+{
+   //each object stream is decoded only once for all objects it holds
+   std::set<unsigned int> objectStreams;
+   CompressedObjects::const_iterator it;
+   for(it = compressedObjects.begin(); it != compressedObjects.end(); ++it)
+      objectStreams.insert(it->second.first);
+
+   std::set<unsigned int>::const_iterator streamIt;
+   for(streamIt = objectStreams.begin(); streamIt != objectStreams.end(); ++streamIt)
+   {
+      if(!_objects.count(*streamIt) || !_objects[*streamIt]->hasStream())
+      {
+         std::cerr<<"Object stream "<<*streamIt<<" is absent\n";
+         continue;
+      }
+      Object * objectStream = _objects[*streamIt];
+      std::string header;
+      objectStream->getHeader(header);
+      std::string stream;
+      Filter filter(objectStream);
+      filter.getDecodedStream(stream);
+
+      //stream starts with N pairs "<object number> <offset>", offsets are relative to /First
+      unsigned int numberOfObjects = Utils::stringToInt(objectStream->getNameSimpleValue(header, "/N"));
+      unsigned int first = Utils::stringToInt(objectStream->getNameSimpleValue(header, "/First"));
+      if(first > stream.size())
+         continue;
+      std::string offsetsTable = stream.substr(0, first);
+      std::vector<std::pair<unsigned int, unsigned int> > offsets;
+      size_t position = 0;
+      std::string number, offset;
+      while((offsets.size() < numberOfObjects) &&
+         Parser::getNextWord(number, offsetsTable, position) &&
+         Parser::getNextWord(offset, offsetsTable, position))
+      {
+         offsets.push_back(std::make_pair((unsigned int)Utils::stringToInt(number), first + Utils::stringToInt(offset)));
+      }
+
+      for(size_t i = 0; i < offsets.size(); ++i)
+      {
+         unsigned int objectNumber = offsets[i].first;
+         CompressedObjects::const_iterator compressed = compressedObjects.find(objectNumber);
+         if((compressed == compressedObjects.end()) || (compressed->second.first != *streamIt) || _objects.count(objectNumber))
+            continue;
+         unsigned int startOfObject = offsets[i].second;
+         unsigned int endOfObject = (i + 1 < offsets.size()) ? offsets[i + 1].second : stream.size();
+         if((startOfObject > endOfObject) || (endOfObject > stream.size()))
+            continue;
+         std::string content = stream.substr(startOfObject, endOfObject - startOfObject);
+         if(content.empty() || (int)WHITESPACES.find(content[content.size() - 1]) == -1)
+            content.append("\n");
+         _objects[objectNumber] = new Object(objectNumber, 0, content, _document->_documentName);
+      }
+      //the container is not part of the document once its objects are expanded
+      _dropObject(*streamIt);
+   }
+}
+
+void Parser::_dropXRefStreams(const std::set<unsigned int> & xrefStreams)
+{
+   //cross-reference streams list themselves, they would be written out as plain objects
+   std::set<unsigned int>::const_iterator it;
+   for(it = xrefStreams.begin(); it != xrefStreams.end(); ++it)
+   {
+      if(!_objects.count(*it))
+         continue;
+      std::string header;
+      _objects[*it]->getHeader(header);
+      //an incremental update may have reused the number for another object
+      if((int)Parser::findToken(header, "/XRef") != -1)
+         _dropObject(*it);
    }
-   while(_readTrailerAndRterievePrev(currentPostion, currentPostion));
+}
 
+void Parser::_dropObject(unsigned int objectNumber)
+{
+   std::map<unsigned int, Object *>::iterator it = _objects.find(objectNumber);
+   if(it == _objects.end())
+      return;
+   delete it->second;
+   _objects.erase(it);
+}
 
+std::vector<unsigned int> Parser::_readNumbersArray(const std::string & content, const std::string & name)
+{
+   std::vector<unsigned int> numbers;
+   size_t startOfName = Parser::findTokenName(content, name);
+   if((int)startOfName == -1)
+      return numbers;
+   size_t startOfArray = content.find("[", startOfName);
+   size_t endOfArray = content.find("]", startOfArray);
+   if(((int)startOfArray == -1) || ((int)endOfArray == -1))
+      return numbers;
+   std::string array = content.substr(startOfArray + 1, endOfArray - startOfArray - 1);
+   std::string number;
+   size_t position = 0;
+   while(Parser::getNextWord(number, array, position))
+      numbers.push_back(Utils::stringToInt(number));
+   return numbers;
 }
 
 unsigned int Parser::_getStartOfXrefWithRoot()
@@ -550,14 +752,22 @@ unsigned int Parser::_readTrailerAndReturnRoot()
 {
 
    unsigned int startOfTrailer = Parser::findToken(_fileContent,"trailer", _getStartOfXrefWithRoot());
+   unsigned int endOfTrailer = _fileContent.size();
+   if((int) startOfTrailer == -1)
+   {
+      //there is no trailer when the last xref is a stream, its dictionary is the trailer
+      startOfTrailer = _getStartOfXrefWithRoot();
+      endOfTrailer = _fileContent.find("stream", startOfTrailer);
+   }
    std::string rootStr("/Root");
    unsigned int startOfRoot = Parser::findToken(_fileContent,rootStr.data(), startOfTrailer);
-   if((int) startOfRoot == -1)
+   if((int) startOfRoot == -1 || startOfRoot > endOfTrailer)
    {
       throw Exception("Cannot find Root object !");
    }
    std::string encryptStr("/Encrypt");
-   if((int) Parser::findToken(_fileContent,encryptStr,startOfTrailer) != -1 )
+   unsigned int startOfEncrypt = Parser::findToken(_fileContent,encryptStr,startOfTrailer);
+   if((int) startOfEncrypt != -1 && startOfEncrypt < endOfTrailer)
    {
       throw Exception("Encrypted PDF is not supported!");
    }
@@ -596,7 +806,7 @@ unsigned int Parser::_readTrailerAndRterievePrev(const unsigned int startPositio
 //Method finds the token from current position from string
 // It uses PDF whitespaces and delimeters to recognize
 // Returned string without begin/end spaces
-std::string Parser::getNextToken(const std::string &str, unsigned int  &position)
+std::string Parser::getNextToken(const ContentView &str, unsigned int  &position)
 {
    if( position >= str.size() )
    {
@@ -625,7 +835,7 @@ std::string Parser::getNextToken(const std::string &str, unsigned int  &position
 * method finds and returns next word from the string
 * For example: " 1 0 R \n" will return "1" , then "0" then "R"
 */
-bool Parser::getNextWord(std::string &out, const std::string &str, size_t &nextPosition, size_t  *found)
+bool Parser::getNextWord(std::string &out, const ContentView &str, size_t &nextPosition, size_t  *found)
 {
    if( found )
    {
@@ -703,7 +913,7 @@ std::string Parser::findTokenStr(const std::string &content, const std::string &
 // contains token but not euqal to it
 // Example: content "/Transparency/ ..." pattern "/Trans
 //          will return npos.
-size_t Parser::findToken(const std::string &content, const std::string &keyword,size_t start)
+size_t Parser::findToken(const ContentView &content, const std::string &keyword,size_t start)
 {
    size_t cur_pos  = start;
    // lets find pattern first
@@ -742,7 +952,7 @@ size_t Parser::findToken(const std::string &content, const std::string &keyword,
 // /H /P /P 12 0 R
 // the tag /P can be a name (and a value also), while 12 cannot
 // start defines the position of token content
-bool Parser::tokenIsAName(const std::string &content, size_t start )
+bool Parser::tokenIsAName(const ContentView &content, size_t start )
 {
    std::string openBraces = "<[({";
    bool found = false;
@@ -789,7 +999,7 @@ bool Parser::tokenIsAName(const std::string &content, size_t start )
 // For example, the string contains /H /P /P 12 0 R.
 // If search for /P then it will return position of /P 12 0 R, not value of 
 // /H /P
-size_t Parser::findTokenName(const std::string &content, const std::string &keyword,size_t start)
+size_t Parser::findTokenName(const ContentView &content, const std::string &keyword,size_t start)
 {
    size_t cur_pos  = start;
    // lets find pattern first
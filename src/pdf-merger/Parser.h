@@ -33,9 +33,11 @@
 #include "Object.h"
 #include "Document.h"
 #include "Page.h"
+#include "ContentView.h"
 
 #include <string>
 #include <vector>
+#include <set>
 
 
 namespace merge_lib
@@ -55,16 +57,20 @@ namespace merge_lib
       static const std::string NUMBERS;
       static const std::string WHITESPACES_AND_DELIMETERS;
 
-      static bool getNextWord(std::string & out, const std::string &in, size_t &nextPosition,size_t *found = NULL);
-      static std::string getNextToken( const std::string &in, unsigned &position);
+      static bool getNextWord(std::string & out, const ContentView &in, size_t &nextPosition,size_t *found = NULL);
+      static std::string getNextToken( const ContentView &in, unsigned &position);
       static void trim(std::string &str);
       static std::string findTokenStr(const std::string &content, const std::string &pattern, size_t start,size_t &foundStart, size_t &foundEnd); 
 
-      static size_t findToken(const std::string &content, const std::string &keyword,size_t start = 0);
-      static size_t findTokenName(const std::string &content, const std::string &keyword,size_t start = 0);
+      static size_t findToken(const ContentView &content, const std::string &keyword,size_t start = 0);
+      static size_t findTokenName(const ContentView &content, const std::string &keyword,size_t start = 0);
       static unsigned int findEndOfElementContent(const std::string &content, unsigned int startOfPageElement);
-      static bool tokenIsAName(const std::string &content, size_t start );
+      static bool tokenIsAName(const ContentView &content, size_t start );
    protected:
+      //key - number of an object stored in an object stream
+      //value - number of that object stream and index of the object in it
+      typedef std::map<unsigned int, std::pair<unsigned int, unsigned int> > CompressedObjects;
+
       const std::string &                           _getObjectContent(unsigned int objectPosition, unsigned int & objectNumber, unsigned int & generationNumber, std::pair<unsigned int, unsigned int> &, bool &);
       virtual unsigned int                          _readTrailerAndReturnRoot();
    private:
@@ -76,6 +82,12 @@ namespace merge_lib
       void                                          _retrieveAllPages(Object * objectWithKids);
       void                                          _fillOutObjects();
       virtual void                                  _readXRefAndCreateObjects();
+      void                                          _createObject(unsigned long objectPosition, const CompressedObjects & compressedObjects);
+      bool                                          _readXRefStream(unsigned int xrefPosition, CompressedObjects & compressedObjects, std::set<unsigned int> & xrefStreams, unsigned int & previosXref);
+      void                                          _createCompressedObjects(const CompressedObjects & compressedObjects);
+      void                                          _dropXRefStreams(const std::set<unsigned int> & xrefStreams);
+      void                                          _dropObject(unsigned int objectNumber);
+      std::vector<unsigned int>                     _readNumbersArray(const std::string & content, const std::string & name);
       unsigned int                                  _getEndOfLineFromContent(unsigned int fromPosition);
       const std::pair<unsigned int, unsigned int> & _getLineBounds(const std::string & str, unsigned int fromPosition);
       const std::string &                           _getNextToken(unsigned int & fromPosition);
@@ -95,7 +107,7 @@ namespace merge_lib
 
       //members
       Object *                         _root;
-      std::string                      _fileContent;
+      ContentView                      _fileContent;
       std::map<unsigned int, Object *> _objects;
       Document *                       _document;
       
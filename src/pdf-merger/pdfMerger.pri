@@ -5,6 +5,7 @@ HEADERS += \
 	src/pdf-merger/CCITTFaxDecode.h \
 	src/pdf-merger/Config.h \
 	src/pdf-merger/ContentHandler.h \
+	src/pdf-merger/ContentView.h \
 	src/pdf-merger/DCTDecode.h \
 	src/pdf-merger/Decoder.h \
 	src/pdf-merger/Document.h \
@@ -15,6 +16,7 @@ HEADERS += \
 	src/pdf-merger/FlateDecode.h \
 	src/pdf-merger/JBIG2Decode.h \
 	src/pdf-merger/LZWDecode.h \
+	src/pdf-merger/MappedFile.h \
 	src/pdf-merger/MediaBoxElementHandler.h \
 	src/pdf-merger/MergePageDescription.h \
 	src/pdf-merger/Merger.h \
@@ -39,11 +41,13 @@ SOURCES += \
 	src/pdf-merger/ASCII85Decode.cpp \
 	src/pdf-merger/ASCIIHexDecode.cpp \
 	src/pdf-merger/ContentHandler.cpp \
+	src/pdf-merger/ContentView.cpp \
 	src/pdf-merger/Document.cpp \
 	src/pdf-merger/Filter.cpp \
 	src/pdf-merger/FilterPredictor.cpp \
 	src/pdf-merger/FlateDecode.cpp \
 	src/pdf-merger/LZWDecode.cpp \
+	src/pdf-merger/MappedFile.cpp \
 	src/pdf-merger/Merger.cpp \
 	src/pdf-merger/Object.cpp \
 	src/pdf-merger/Page.cpp \
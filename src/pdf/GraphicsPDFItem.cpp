@@ -42,6 +42,8 @@ GraphicsPDFItem::GraphicsPDFItem(PDFRenderer *renderer, int pageNumber, QGraphic
 {
     setCacheMode(QGraphicsItem::DeviceCoordinateCache);
     mRenderer->attach();
+
+    connect(mRenderer, SIGNAL(pageRendered(int)), this, SLOT(pageRendered(int)));
 }
 
 GraphicsPDFItem::~GraphicsPDFItem()
@@ -69,9 +71,23 @@ void GraphicsPDFItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *o
         return;
     }
 
-    if (option)
+    if (option && rendersProgressively())
+        mRenderer->renderProgressively(painter, mPageNumber, option->exposedRect);
+    else if (option)
         mRenderer->render(painter, mPageNumber, option->exposedRect);
     else
         qWarning("GraphicsPDFItem::paint: option is null, ignoring painting");
 
 }
+
+void GraphicsPDFItem::prerender(qreal viewScale)
+{
+    if (mRenderer && mRenderer->isValid())
+        mRenderer->prerender(mPageNumber, viewScale * sceneTransform().m11());
+}
+
+void GraphicsPDFItem::pageRendered(int pageNumber)
+{
+    if (pageNumber == mPageNumber)
+        update();
+}
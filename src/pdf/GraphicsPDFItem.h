@@ -50,9 +50,18 @@ class GraphicsPDFItem : public QObject, public QGraphicsItem
 
         int pageNumber() const { return mPageNumber; }
         QUuid fileUuid() const { return mRenderer->fileUuid(); }
-        QByteArray fileData() const { return mRenderer->fileData(); }
+        QString fileName() const { return mRenderer->fileName(); }
+
+        // rasterizes the page in the background for a view zoomed at viewScale
+        void prerender(qreal viewScale);
+
+    protected slots:
+        void pageRendered(int pageNumber);
 
     protected:
+        // screen paints do not wait for the rasterization of the page
+        virtual bool rendersProgressively() const { return false; }
+
         PDFRenderer *mRenderer;
         int mPageNumber;
 };
@@ -61,11 +61,7 @@ PDFRenderer* PDFRenderer::rendererForUuid(const QUuid &uuid, const QString &file
 
         newRenderer->setRefCount(0);
         newRenderer->setFileUuid(uuid);
-
-        QFile file(filename);
-        file.open(QIODevice::ReadOnly);
-        newRenderer->setFileData(file.readAll());
-        file.close();
+        newRenderer->setFileName(filename);
 
         sRenderers.insert(newRenderer->fileUuid(), newRenderer);
 
@@ -82,9 +78,9 @@ void PDFRenderer::setRefCount(const QAtomicInt &refCount)
     mRefCount = refCount;
 }
 
-void PDFRenderer::setFileData(const QByteArray &fileData)
+void PDFRenderer::setFileName(const QString &fileName)
 {
-    mFileData = fileData;
+    mFileName = fileName;
 }
 
 void PDFRenderer::setFileUuid(const QUuid &fileUuid)
@@ -37,9 +37,23 @@
 #include <QUuid>
 #include <QMap>
 #include <QPointer>
+#include <QDateTime>
 
 class QPainter;
 
+struct PDFThumbnailRequest
+{
+    int pageNumber;
+    QString thumbnailFile;
+
+    // the thumbnail is not written if the page at pageIndex is not the scene of sceneUuid
+    // anymore (pages moved or deleted), or if it was saved since pageModified
+    QString persistencePath;
+    int pageIndex;
+    QUuid sceneUuid;
+    QDateTime pageModified;
+};
+
 class PDFRenderer : public QObject
 {
     Q_OBJECT
@@ -62,20 +76,48 @@ class PDFRenderer : public QObject
         void detach();
 
         QUuid fileUuid() const { return mFileUuid; }
-        QByteArray fileData() const { return mFileData; }
+        QString fileName() const { return mFileName; }
 
         void setDPI(int desiredDPI) { this->dpiForRendering = desiredDPI; }
 
+    signals:
+        // more of the page got rasterized since the last progressive render
+        void pageRendered(int pageNumber);
+
+        void thumbnailWritten(int requestIndex);
+        void thumbnailsWritten();
+
     public slots:
         virtual void render(QPainter *p, int pageNumber, const QRectF &bounds = QRectF()) = 0;
 
+        // paints what is ready without waiting, the rest is rasterized in the background
+        virtual void renderProgressively(QPainter *p, int pageNumber, const QRectF &bounds = QRectF())
+        {
+            render(p, pageNumber, bounds);
+        }
+
+        // rasterizes a page about to be shown in the background, at a device scale of the page size
+        virtual void prerender(int pageNumber, qreal scale)
+        {
+            Q_UNUSED(pageNumber);
+            Q_UNUSED(scale);
+        }
+
+        // writes page thumbnails as jpg files in the background
+        virtual void writeThumbnails(const QList<PDFThumbnailRequest>& requests, int thumbnailWidth)
+        {
+            Q_UNUSED(requests);
+            Q_UNUSED(thumbnailWidth);
+            emit thumbnailsWritten();
+        }
+
     private:
         QAtomicInt mRefCount;
-        QByteArray mFileData;
+        QString mFileName;
         QUuid mFileUuid;
 
         void setRefCount(const QAtomicInt &refCount);
-        void setFileData(const QByteArray &fileData);
+        void setFileName(const QString &fileName);
         void setFileUuid(const QUuid &fileUuid);
 
         static QMap< QUuid, QPointer<PDFRenderer> > sRenderers;
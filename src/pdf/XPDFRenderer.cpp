@@ -32,15 +32,120 @@
 #include <QtGui>
 
 #include <frameworks/UBPlatformUtils.h>
+#include <frameworks/UBFileSystemUtils.h>
+
+#include "adaptors/UBSvgSubsetAdaptor.h"
 
 #include "core/memcheck.h"
 
 QAtomicInt XPDFRenderer::sInstancesCount = 0;
 
+// raster budget of the tile cache of each document, in kilobytes
+static const int sTileCacheBudget = 48 * 1024;
+
+XPDFRasterizer::XPDFRasterizer(XPDFRenderer* renderer, const QString& filename)
+    : QThread(0)
+    , mRenderer(renderer)
+    , mFilename(filename)
+{
+    // NOOP
+}
+
+XPDFRasterizer::~XPDFRasterizer()
+{
+    // NOOP
+}
+
+void XPDFRasterizer::run()
+{
+    PDFDoc* document = new PDFDoc(new GString(mFilename.toLocal8Bit()), 0, 0, 0);
+    SplashOutputDev* splash = 0;
+
+    XPDFRenderer::SliceRequest request;
+
+    while (mRenderer->takeRequest(request))
+    {
+        if (!document->isOk())
+            continue;
+
+        qreal scale = (qreal)request.scaleKey / XPDFRenderer::ScaleSteps;
+        QImage image = XPDFRenderer::rasterizeSlice(document, splash, request.pageNumber,
+                                                    request.dpi * scale, request.dpi * scale, request.slice);
+
+        emit sliceRasterized(request.pageNumber, request.scaleKey, request.dpi, request.slice, image);
+    }
+
+    delete splash;
+    delete document;
+}
+
+
+XPDFThumbnailer::XPDFThumbnailer(const QString& filename, const QList<PDFThumbnailRequest>& requests, int thumbnailWidth)
+    : QThread(0)
+    , mFilename(filename)
+    , mRequests(requests)
+    , mThumbnailWidth(thumbnailWidth)
+{
+    // NOOP
+}
+
+XPDFThumbnailer::~XPDFThumbnailer()
+{
+    // NOOP
+}
+
+void XPDFThumbnailer::run()
+{
+    PDFDoc* document = new PDFDoc(new GString(mFilename.toLocal8Bit()), 0, 0, 0);
+    SplashOutputDev* splash = 0;
+
+    for (int i = 0; i < mRequests.size() && document->isOk() && !isInterruptionRequested(); i++)
+    {
+        const PDFThumbnailRequest& request = mRequests.at(i);
+
+        qreal pageWidth = document->getPageCropWidth(request.pageNumber);
+        qreal pageHeight = document->getPageCropHeight(request.pageNumber);
+        int rotate = document->getPageRotate(request.pageNumber);
+
+        if (rotate == 90 || rotate == 270)
+            qSwap(pageWidth, pageHeight);
+
+        if (pageWidth <= 0 || pageHeight <= 0)
+            continue;
+
+        // page sizes are in points
+        qreal dpi = 72.0 * mThumbnailWidth / pageWidth;
+        QRect slice(0, 0, mThumbnailWidth, qRound(pageHeight * mThumbnailWidth / pageWidth));
+
+        QImage thumbnail = XPDFRenderer::rasterizeSlice(document, splash, request.pageNumber, dpi, dpi, slice);
+
+        if (!request.persistencePath.isEmpty())
+        {
+            // the pages were moved or deleted, the thumbnail file now belongs to another page
+            if (UBSvgSubsetAdaptor::sceneUuid(request.persistencePath, request.pageIndex) != request.sceneUuid)
+                continue;
+
+            // the page was edited and saved with its own thumbnail in the meantime
+            QString pageFile = request.persistencePath + UBFileSystemUtils::digitFileFormat("/page%1.svg", request.pageIndex);
+            if (QFileInfo(pageFile).lastModified() != request.pageModified)
+                continue;
+        }
+
+        if (!thumbnail.isNull() && thumbnail.save(request.thumbnailFile, "JPG"))
+            emit thumbnailWritten(i);
+    }
+
+    delete splash;
+    delete document;
+}
+
+
 XPDFRenderer::XPDFRenderer(const QString &filename, bool importingFile)
     : mDocument(0)
-    , mpSplashBitmap(0)
+    , mFilename(filename)
     , mSplash(0)
+    , mTiles(sTileCacheBudget)
+    , mStopping(false)
 {
     Q_UNUSED(importingFile);
     if (!globalParams)
@@ -57,6 +162,9 @@ XPDFRenderer::XPDFRenderer(const QString &filename, bool importingFile)
 
 XPDFRenderer::~XPDFRenderer()
 {
+    // the workers use globalParams
+    stopRasterizers();
+
     if(mSplash){
         delete mSplash;
         mSplash = NULL;
@@ -156,48 +264,461 @@ void XPDFRenderer::render(QPainter *p, int pageNumber, const QRectF &bounds)
         qreal xscale = p->worldTransform().m11();
         qreal yscale = p->worldTransform().m22();
 
-        QImage *pdfImage = createPDFImage(pageNumber, xscale, yscale, bounds);
-        QTransform savedTransform = p->worldTransform();
-        p->resetTransform();
-        p->drawImage(QPointF(savedTransform.dx() + mSliceX, savedTransform.dy() + mSliceY), *pdfImage);
-        p->setWorldTransform(savedTransform);
-        delete pdfImage;
+        if (xscale <= 0 || yscale <= 0)
+            return;
+
+        renderTiles(p, pageNumber, xscale, yscale, bounds, false);
     }
 }
 
-QImage* XPDFRenderer::createPDFImage(int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds)
+void XPDFRenderer::renderProgressively(QPainter *p, int pageNumber, const QRectF &bounds)
 {
     if (isValid())
     {
-        SplashColor paperColor = {0xFF, 0xFF, 0xFF}; // white
-        if(mSplash)
-            delete mSplash;
-        mSplash = new SplashOutputDev(splashModeRGB8, 1, gFalse, paperColor);
-        mSplash->startDoc(mDocument->getXRef());
-        int rotation = 0; // in degrees (get it from the worldTransform if we want to support rotation)
-        GBool useMediaBox = gFalse;
-        GBool crop = gTrue;
-        GBool printing = gFalse;
-        mSliceX = 0.;
-        mSliceY = 0.;
-
-        if (bounds.isNull())
+        qreal xscale = p->worldTransform().m11();
+        qreal yscale = p->worldTransform().m22();
+
+        if (xscale <= 0 || yscale <= 0)
+            return;
+
+        renderTiles(p, pageNumber, xscale, yscale, bounds, true);
+    }
+}
+
+void XPDFRenderer::prerender(int pageNumber, qreal scale)
+{
+    if (!isValid() || scale <= 0 || pageNumber < 1 || pageNumber > pageCount())
+        return;
+
+    int scaleKey = scaleKeyFor(scale);
+    QRect pageRect = pagePixelRect(pageNumber, scaleKey);
+
+    TileKey key;
+    key.pageNumber = pageNumber;
+    key.dpi = dpiForRendering;
+    key.column = 0;
+    key.row = 0;
+
+    key.scaleKey = PreviewScaleKey;
+    if (scaleKey > PreviewScaleKey && !mTiles.contains(key) && !mPendingTiles.contains(key))
+        requestSlice(pageNumber, PreviewScaleKey, pagePixelRect(pageNumber, PreviewScaleKey), true);
+
+    // a page that would not fit in half of the cache would evict the page on screen
+    if (pageRect.isEmpty() || pageRect.width() * pageRect.height() * 4 / 1024 > sTileCacheBudget / 2)
+        return;
+
+    QRect missingRect;
+    key.scaleKey = scaleKey;
+    for (int row = 0; row <= pageRect.bottom() / TileSize; row++)
+    {
+        for (int column = 0; column <= pageRect.right() / TileSize; column++)
+        {
+            key.column = column;
+            key.row = row;
+
+            if (!mTiles.contains(key) && !mPendingTiles.contains(key))
+                missingRect |= QRect(column * TileSize, row * TileSize, TileSize, TileSize);
+        }
+    }
+
+    missingRect &= pageRect;
+
+    if (!missingRect.isEmpty())
+        requestSlice(pageNumber, scaleKey, missingRect, true);
+}
+
+int XPDFRenderer::scaleKeyFor(qreal scale) const
+{
+    // tiles are rasterized at a quantized scale so that small zoom changes keep hitting the cache
+    return qMax(1, qRound(scale * ScaleSteps));
+}
+
+QRect XPDFRenderer::pagePixelRect(int pageNumber, int scaleKey) const
+{
+    qreal scale = (qreal)scaleKey / ScaleSteps;
+
+    return QRect(QPoint(0, 0), (pageSizeF(pageNumber) * scale).toSize());
+}
+
+void XPDFRenderer::renderTiles(QPainter *p, int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds, bool progressive)
+{
+    int scaleKey = scaleKeyFor(qMax(xscale, yscale));
+    qreal scale = (qreal)scaleKey / ScaleSteps;
+
+    QSizeF pageSize = pageSizeF(pageNumber);
+    QRect pageRect = pagePixelRect(pageNumber, scaleKey);
+
+    QRectF exposed = bounds.isNull() ? QRectF(QPointF(0, 0), pageSize) : bounds;
+    QRect exposedPixels = QRectF(exposed.topLeft() * scale, exposed.size() * scale).toAlignedRect() & pageRect;
+
+    if (exposedPixels.isEmpty())
+        return;
+
+    int firstColumn = exposedPixels.left() / TileSize;
+    int lastColumn = exposedPixels.right() / TileSize;
+    int firstRow = exposedPixels.top() / TileSize;
+    int lastRow = exposedPixels.bottom() / TileSize;
+
+    TileKey key;
+    key.pageNumber = pageNumber;
+    key.scaleKey = scaleKey;
+    key.dpi = dpiForRendering;
+
+    // rasterize the missing tiles in one slice, the content stream is interpreted once
+    QRect missingRect;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            key.column = column;
+            key.row = row;
+
+            if (!mTiles.contains(key) && (!progressive || !mPendingTiles.contains(key)))
+                missingRect |= QRect(column * TileSize, row * TileSize, TileSize, TileSize);
+        }
+    }
+
+    missingRect &= pageRect;
+
+    QImage slice;
+
+    if (progressive)
+    {
+        if (mPageScaleKeys.value(pageNumber) != scaleKey)
+        {
+            if (mPageScaleKeys.contains(pageNumber))
+                mPreviousPageScaleKeys.insert(pageNumber, mPageScaleKeys.value(pageNumber));
+            mPageScaleKeys.insert(pageNumber, scaleKey);
+        }
+
+        // a cheap version of the whole page comes first
+        if (scaleKey > PreviewScaleKey)
+        {
+            QRect previewRect = pagePixelRect(pageNumber, PreviewScaleKey);
+            TileKey previewKey = key;
+            previewKey.scaleKey = PreviewScaleKey;
+            previewKey.column = 0;
+            previewKey.row = 0;
+
+            if (!previewRect.isEmpty() && !mTiles.contains(previewKey) && !mPendingTiles.contains(previewKey))
+                requestSlice(pageNumber, PreviewScaleKey, previewRect);
+        }
+
+        if (!missingRect.isEmpty())
+            requestSlice(pageNumber, scaleKey, missingRect);
+    }
+    else if (!missingRect.isEmpty())
+    {
+        slice = rasterizeSlice(mDocument, mSplash, pageNumber, dpiForRendering * scale, dpiForRendering * scale, missingRect);
+        insertSlice(pageNumber, scaleKey, dpiForRendering, missingRect, slice);
+    }
+
+    // tiles are in device pixels at the quantized scale
+    QTransform savedTransform = p->worldTransform();
+    p->save();
+    p->setWorldTransform(QTransform(xscale / scale, 0, 0, yscale / scale, savedTransform.dx(), savedTransform.dy()));
+
+    if (!qFuzzyCompare(xscale, scale) || !qFuzzyCompare(yscale, scale))
+        p->setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    // the output never depends on what the cache kept, the new slice is drawn as rasterized
+    if (!slice.isNull())
+        p->drawImage(missingRect.topLeft(), slice);
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            key.column = column;
+            key.row = row;
+
+            QRect tileRect = QRect(column * TileSize, row * TileSize, TileSize, TileSize) & pageRect;
+
+            if (!slice.isNull() && missingRect.contains(tileRect))
+                continue;
+
+            // the cache budget may be smaller than the exposed area
+            QImage* tile = mTiles.object(key);
+            if (tile)
+            {
+                p->drawImage(tileRect.topLeft(), *tile);
+            }
+            else if (!progressive)
+            {
+                // evicted while the new slice was inserted
+                p->drawImage(tileRect.topLeft(), rasterizeSlice(mDocument, mSplash, pageNumber,
+                                                                dpiForRendering * scale, dpiForRendering * scale, tileRect));
+            }
+            else
+            {
+                p->fillRect(tileRect, Qt::white);
+                drawPlaceholder(p, pageNumber, scaleKey, PreviewScaleKey, tileRect);
+
+                if (mPreviousPageScaleKeys.contains(pageNumber))
+                    drawPlaceholder(p, pageNumber, scaleKey, mPreviousPageScaleKeys.value(pageNumber), tileRect);
+            }
+        }
+    }
+
+    p->restore();
+}
+
+void XPDFRenderer::drawPlaceholder(QPainter *p, int pageNumber, int scaleKey, int placeholderScaleKey, const QRect& rect)
+{
+    if (placeholderScaleKey == scaleKey)
+        return;
+
+    // rect is in pixels at scaleKey, placeholder tiles are stretched over it
+    qreal factor = (qreal)scaleKey / placeholderScaleKey;
+    QRect placeholderRect = QRectF(QPointF(rect.topLeft()) / factor, QSizeF(rect.size()) / factor).toAlignedRect()
+                          & pagePixelRect(pageNumber, placeholderScaleKey);
+
+    if (placeholderRect.isEmpty())
+        return;
+
+    TileKey key;
+    key.pageNumber = pageNumber;
+    key.scaleKey = placeholderScaleKey;
+    key.dpi = dpiForRendering;
+
+    p->save();
+    p->setClipRect(rect, Qt::IntersectClip);
+    p->setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    for (int row = placeholderRect.top() / TileSize; row <= placeholderRect.bottom() / TileSize; row++)
+    {
+        for (int column = placeholderRect.left() / TileSize; column <= placeholderRect.right() / TileSize; column++)
         {
-            mDocument->displayPage(mSplash, pageNumber, this->dpiForRendering * xscale, this->dpiForRendering *yscale,
-                                   rotation, useMediaBox, crop, printing);
+            key.column = column;
+            key.row = row;
+
+            QImage* tile = mTiles.object(key);
+            if (tile)
+            {
+                QRectF target(QPointF(column * TileSize, row * TileSize) * factor, QSizeF(tile->size()) * factor);
+                p->drawImage(target, *tile);
+            }
         }
-        else
+    }
+
+    p->restore();
+}
+
+void XPDFRenderer::insertSlice(int pageNumber, int scaleKey, int dpi, const QRect& slice, const QImage& image)
+{
+    if (image.isNull())
+        return;
+
+    QRect pageRect = pagePixelRect(pageNumber, scaleKey);
+
+    TileKey key;
+    key.pageNumber = pageNumber;
+    key.scaleKey = scaleKey;
+    key.dpi = dpi;
+
+    for (int row = slice.top() / TileSize; row <= slice.bottom() / TileSize; row++)
+    {
+        for (int column = slice.left() / TileSize; column <= slice.right() / TileSize; column++)
         {
-            mSliceX = bounds.x() * xscale;
-            mSliceY = bounds.y() * yscale;
-            qreal sliceW = bounds.width() * xscale;
-            qreal sliceH = bounds.height() * yscale;
+            key.column = column;
+            key.row = row;
 
-            mDocument->displayPageSlice(mSplash, pageNumber, this->dpiForRendering * xscale, this->dpiForRendering * yscale,
-                rotation, useMediaBox, crop, printing, mSliceX, mSliceY, sliceW, sliceH);
+            mPendingTiles.remove(key);
+
+            if (mTiles.contains(key))
+                continue;
+
+            QRect tileRect = QRect(column * TileSize, row * TileSize, TileSize, TileSize) & pageRect & slice;
+            QImage* tile = new QImage(image.copy(tileRect.translated(-slice.topLeft())));
+
+            mTiles.insert(key, tile, qMax(1, tile->byteCount() / 1024));
+        }
+    }
+}
+
+void XPDFRenderer::requestSlice(int pageNumber, int scaleKey, const QRect& slice, bool prefetch)
+{
+    SliceRequest request;
+    request.pageNumber = pageNumber;
+    request.scaleKey = scaleKey;
+    request.dpi = dpiForRendering;
+    request.slice = slice;
+    request.prefetch = prefetch;
+
+    TileKey key;
+    key.pageNumber = pageNumber;
+    key.scaleKey = scaleKey;
+    key.dpi = dpiForRendering;
+
+    for (int row = slice.top() / TileSize; row <= slice.bottom() / TileSize; row++)
+    {
+        for (int column = slice.left() / TileSize; column <= slice.right() / TileSize; column++)
+        {
+            key.column = column;
+            key.row = row;
+            mPendingTiles.insert(key);
+        }
+    }
+
+    {
+        QMutexLocker locker(&mRequestsMutex);
+
+        // requests of a zoom level the page is not painted at anymore are dropped
+        for (int i = mRequests.size() - 1; i >= 0; i--)
+        {
+            const SliceRequest& queued = mRequests.at(i);
+
+            if (queued.pageNumber != pageNumber || queued.scaleKey == scaleKey || queued.scaleKey == PreviewScaleKey || prefetch)
+                continue;
+
+            key.scaleKey = queued.scaleKey;
+            key.dpi = queued.dpi;
+            for (int row = queued.slice.top() / TileSize; row <= queued.slice.bottom() / TileSize; row++)
+            {
+                for (int column = queued.slice.left() / TileSize; column <= queued.slice.right() / TileSize; column++)
+                {
+                    key.column = column;
+                    key.row = row;
+                    mPendingTiles.remove(key);
+                }
+            }
+
+            mRequests.removeAt(i);
         }
 
-        mpSplashBitmap = mSplash->getBitmap();
+        mRequests << request;
+    }
+
+    mRequestsCondition.wakeOne();
+
+    int maxRasterizers = qBound(1, QThread::idealThreadCount() - 1, 2);
+
+    if (mRasterizers.size() < maxRasterizers)
+    {
+        XPDFRasterizer* rasterizer = new XPDFRasterizer(this, mFilename);
+        connect(rasterizer, SIGNAL(sliceRasterized(int, int, int, const QRect&, const QImage&)),
+                this, SLOT(sliceRasterized(int, int, int, const QRect&, const QImage&)), Qt::QueuedConnection);
+        mRasterizers << rasterizer;
+        rasterizer->start(QThread::LowPriority);
     }
-    return new QImage(mpSplashBitmap->getDataPtr(), mpSplashBitmap->getWidth(), mpSplashBitmap->getHeight(), mpSplashBitmap->getWidth() * 3, QImage::Format_RGB888);
+}
+
+bool XPDFRenderer::takeRequest(SliceRequest& request)
+{
+    QMutexLocker locker(&mRequestsMutex);
+
+    while (mRequests.isEmpty() && !mStopping)
+        mRequestsCondition.wait(&mRequestsMutex);
+
+    if (mStopping)
+        return false;
+
+    // the preview is the most useful, then the latest paint, then the pages about to be shown
+    int next = -1;
+    int nextPriority = -1;
+
+    for (int i = mRequests.size() - 1; i >= 0; i--)
+    {
+        const SliceRequest& queued = mRequests.at(i);
+        int priority = (queued.prefetch ? 0 : 2) + (queued.scaleKey == PreviewScaleKey ? 1 : 0);
+
+        if (priority > nextPriority)
+        {
+            next = i;
+            nextPriority = priority;
+        }
+    }
+
+    request = mRequests.takeAt(next);
+    return true;
+}
+
+void XPDFRenderer::stopRasterizers()
+{
+    {
+        QMutexLocker locker(&mRequestsMutex);
+        mStopping = true;
+        mRequests.clear();
+    }
+
+    mRequestsCondition.wakeAll();
+
+    foreach (XPDFRasterizer* rasterizer, mRasterizers)
+    {
+        rasterizer->wait();
+        delete rasterizer;
+    }
+
+    mRasterizers.clear();
+
+    foreach (XPDFThumbnailer* thumbnailer, mThumbnailers)
+    {
+        thumbnailer->requestInterruption();
+        thumbnailer->wait();
+        delete thumbnailer;
+    }
+
+    mThumbnailers.clear();
+}
+
+void XPDFRenderer::writeThumbnails(const QList<PDFThumbnailRequest>& requests, int thumbnailWidth)
+{
+    if (!isValid() || requests.isEmpty())
+    {
+        emit thumbnailsWritten();
+        return;
+    }
+
+    XPDFThumbnailer* thumbnailer = new XPDFThumbnailer(mFilename, requests, thumbnailWidth);
+    connect(thumbnailer, SIGNAL(thumbnailWritten(int)), this, SIGNAL(thumbnailWritten(int)), Qt::QueuedConnection);
+    connect(thumbnailer, SIGNAL(finished()), this, SLOT(thumbnailerFinished()), Qt::QueuedConnection);
+
+    mThumbnailers << thumbnailer;
+    thumbnailer->start(QThread::LowPriority);
+}
+
+void XPDFRenderer::thumbnailerFinished()
+{
+    XPDFThumbnailer* thumbnailer = qobject_cast<XPDFThumbnailer*>(sender());
+
+    if (thumbnailer && mThumbnailers.removeOne(thumbnailer))
+        thumbnailer->deleteLater();
+
+    emit thumbnailsWritten();
+}
+
+void XPDFRenderer::sliceRasterized(int pageNumber, int scaleKey, int dpi, const QRect& slice, const QImage& image)
+{
+    insertSlice(pageNumber, scaleKey, dpi, slice, image);
+
+    emit pageRendered(pageNumber);
+}
+
+QImage XPDFRenderer::rasterizeSlice(PDFDoc* document, SplashOutputDev*& splash, int pageNumber, qreal hDPI, qreal vDPI, const QRect &slice)
+{
+    if (!document || !document->isOk())
+        return QImage();
+
+    if (!splash)
+    {
+        // the output device is kept for the lifetime of the document, startPage allocates each bitmap
+        SplashColor paperColor = {0xFF, 0xFF, 0xFF}; // white
+        splash = new SplashOutputDev(splashModeRGB8, 1, gFalse, paperColor);
+        splash->startDoc(document->getXRef());
+    }
+
+    int rotation = 0; // in degrees (get it from the worldTransform if we want to support rotation)
+    GBool useMediaBox = gFalse;
+    GBool crop = gTrue;
+    GBool printing = gFalse;
+
+    document->displayPageSlice(splash, pageNumber, hDPI, vDPI,
+        rotation, useMediaBox, crop, printing, slice.x(), slice.y(), slice.width(), slice.height());
+
+    SplashBitmap* bitmap = splash->getBitmap();
+
+    // the bitmap belongs to the output device, copy it out in a format cheap to draw
+    QImage image(bitmap->getDataPtr(), bitmap->getWidth(), bitmap->getHeight(), bitmap->getRowSize(), QImage::Format_RGB888);
+
+    return image.convertToFormat(QImage::Format_RGB32);
 }
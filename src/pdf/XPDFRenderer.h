@@ -30,6 +30,10 @@
 #ifndef XPDFRENDERER_H
 #define XPDFRENDERER_H
 #include <QImage>
+#include <QCache>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include "PDFRenderer.h"
 #include <splash/SplashBitmap.h>
 
@@ -43,6 +47,55 @@ THIRD_PARTY_WARNINGS_DISABLE
 THIRD_PARTY_WARNINGS_ENABLE
 
 class PDFDoc;
+class XPDFRenderer;
+
+/*
+ * Worker rasterizing page slices requested by progressive paints. Each worker opens
+ * its own PDFDoc and SplashOutputDev, xpdf documents cannot be shared between threads.
+ */
+class XPDFRasterizer : public QThread
+{
+    Q_OBJECT
+
+    public:
+        XPDFRasterizer(XPDFRenderer* renderer, const QString& filename);
+        virtual ~XPDFRasterizer();
+
+    signals:
+        void sliceRasterized(int pageNumber, int scaleKey, int dpi, const QRect& slice, const QImage& image);
+
+    protected:
+        virtual void run();
+
+    private:
+        XPDFRenderer* mRenderer;
+        QString mFilename;
+};
+
+
+/*
+ * Writes page thumbnails straight from the pdf file, with its own PDFDoc.
+ */
+class XPDFThumbnailer : public QThread
+{
+    Q_OBJECT
+
+    public:
+        XPDFThumbnailer(const QString& filename, const QList<PDFThumbnailRequest>& requests, int thumbnailWidth);
+        virtual ~XPDFThumbnailer();
+
+    signals:
+        void thumbnailWritten(int requestIndex);
+
+    protected:
+        virtual void run();
+
+    private:
+        QString mFilename;
+        QList<PDFThumbnailRequest> mRequests;
+        int mThumbnailWidth;
+};
+
 
 class XPDFRenderer : public PDFRenderer
 {
@@ -62,20 +115,95 @@ class XPDFRenderer : public PDFRenderer
 
         virtual QString title() const;
 
+        static QImage rasterizeSlice(PDFDoc* document, SplashOutputDev*& splash, int pageNumber, qreal hDPI, qreal vDPI, const QRect &slice);
+
     public slots:
         void render(QPainter *p, int pageNumber, const QRectF &bounds = QRectF());
+        void renderProgressively(QPainter *p, int pageNumber, const QRectF &bounds = QRectF());
+        void prerender(int pageNumber, qreal scale);
+        void writeThumbnails(const QList<PDFThumbnailRequest>& requests, int thumbnailWidth);
+
+    private slots:
+        void sliceRasterized(int pageNumber, int scaleKey, int dpi, const QRect& slice, const QImage& image);
+        void thumbnailerFinished();
 
     private:
-        void init();
-        QImage* createPDFImage(int pageNumber, qreal xscale = 0.5, qreal yscale = 0.5, const QRectF &bounds = QRectF());
+        friend class XPDFRasterizer;
+
+        /*
+         * Pages are rasterized in tiles of TileSize device pixels, cached per page and
+         * quantized scale. Painting only rasterizes the tiles missing from the cache.
+         */
+        struct TileKey
+        {
+            int pageNumber;
+            int scaleKey;
+            int dpi;
+            int column;
+            int row;
+
+            bool operator==(const TileKey& other) const
+            {
+                return pageNumber == other.pageNumber && scaleKey == other.scaleKey && dpi == other.dpi
+                        && column == other.column && row == other.row;
+            }
+        };
+
+        friend uint qHash(const TileKey& key);
+
+        struct SliceRequest
+        {
+            int pageNumber;
+            int scaleKey;
+            int dpi;
+            QRect slice;
+            bool prefetch; // taken after the requests of the pages on screen
+        };
+
+        enum
+        {
+            TileSize = 256,
+            ScaleSteps = 32, // quantization of the scale factor, per unit
+            PreviewScaleKey = ScaleSteps / 4 // placeholder shown while the tiles are rasterized
+        };
+
+        int scaleKeyFor(qreal scale) const;
+        void renderTiles(QPainter *p, int pageNumber, qreal xscale, qreal yscale, const QRectF &bounds, bool progressive);
+        void insertSlice(int pageNumber, int scaleKey, int dpi, const QRect& slice, const QImage& image);
+        void requestSlice(int pageNumber, int scaleKey, const QRect& slice, bool prefetch = false);
+        void drawPlaceholder(QPainter *p, int pageNumber, int scaleKey, int placeholderScaleKey, const QRect& rect);
+        QRect pagePixelRect(int pageNumber, int scaleKey) const;
+
+        // called by the workers, waits for a request, returns false when the renderer stops
+        bool takeRequest(SliceRequest& request);
+        void stopRasterizers();
 
         PDFDoc *mDocument;
         static QAtomicInt sInstancesCount;
-        qreal mSliceX;
-        qreal mSliceY;
 
-        SplashBitmap* mpSplashBitmap;
+        QString mFilename;
         SplashOutputDev* mSplash;
+
+        // cost in kilobytes
+        QCache<TileKey, QImage> mTiles;
+
+        // tiles requested from the workers, only used in the GUI thread
+        QSet<TileKey> mPendingTiles;
+        QHash<int, int> mPageScaleKeys;
+        QHash<int, int> mPreviousPageScaleKeys;
+
+        QList<XPDFRasterizer*> mRasterizers;
+        QList<XPDFThumbnailer*> mThumbnailers;
+        QMutex mRequestsMutex;
+        QWaitCondition mRequestsCondition;
+        QList<SliceRequest> mRequests;
+        bool mStopping;
 };
 
+inline uint qHash(const XPDFRenderer::TileKey& key)
+{
+    return ((uint)key.pageNumber << 24) ^ ((uint)key.scaleKey << 12) ^ ((uint)key.dpi << 20)
+            ^ ((uint)key.column << 8) ^ (uint)key.row;
+}
+
 #endif // XPDFRENDERER_H
@@ -71,6 +71,7 @@ UBGraphicsCurtainItem::UBGraphicsCurtainItem(QGraphicsItem* parent)
 
 UBGraphicsCurtainItem::~UBGraphicsCurtainItem()
 {
+    UBGraphicsItem::forgetRenderInfo(this);
 }
 
 QVariant UBGraphicsCurtainItem::itemChange(GraphicsItemChange change, const QVariant &value)